@@ -96,6 +96,69 @@ void set_default_title_volume(float value) {
     ini_putf("config", "global_volume", value, CONFIG_PATH);
 }
 
+auto get_buffer_ms() -> int {
+    return ini_getl("config", "buffer_ms", 250, CONFIG_PATH);
+}
+
+void set_buffer_ms(int value) {
+    create_config_dir();
+    ini_putl("config", "buffer_ms", value, CONFIG_PATH);
+}
+
+auto get_preload_kib() -> int {
+    return ini_getl("config", "preload_kib", 128, CONFIG_PATH);
+}
+
+void set_preload_kib(int value) {
+    create_config_dir();
+    ini_putl("config", "preload_kib", value, CONFIG_PATH);
+}
+
+auto get_parallel_decode() -> bool {
+    return ini_getbool("config", "parallel_decode", false, CONFIG_PATH);
+}
+
+void set_parallel_decode(bool value) {
+    create_config_dir();
+    ini_putl("config", "parallel_decode", value, CONFIG_PATH);
+}
+
+auto get_dither() -> bool {
+    return ini_getbool("config", "dither", true, CONFIG_PATH);
+}
+
+void set_dither(bool value) {
+    create_config_dir();
+    ini_putl("config", "dither", value, CONFIG_PATH);
+}
+
+auto get_pcm_cache_mib() -> int {
+    return ini_getl("config", "pcm_cache_mib", 0, CONFIG_PATH);
+}
+
+void set_pcm_cache_mib(int value) {
+    create_config_dir();
+    ini_putl("config", "pcm_cache_mib", value, CONFIG_PATH);
+}
+
+auto get_stream_loops() -> int {
+    return ini_getl("config", "stream_loops", 0, CONFIG_PATH);
+}
+
+void set_stream_loops(int value) {
+    create_config_dir();
+    ini_putl("config", "stream_loops", value, CONFIG_PATH);
+}
+
+auto get_resampler_quality() -> int {
+    return ini_getl("config", "resampler_quality", 3, CONFIG_PATH);
+}
+
+void set_resampler_quality(int value) {
+    create_config_dir();
+    ini_putl("config", "resampler_quality", value, CONFIG_PATH);
+}
+
 auto get_load_path(char* out, int max_len) -> int {
     return ini_gets("config", "load_path", "", out, max_len, CONFIG_PATH);
 }
@@ -34,6 +34,34 @@ void set_title_volume(u64 tid, float value);
 auto get_default_title_volume() -> float;
 void set_default_title_volume(float value);
 
+// decode-ahead buffer length in milliseconds
+auto get_buffer_ms() -> int;
+void set_buffer_ms(int value);
+
+// files up to this size are read into memory whole, 0 disables
+auto get_preload_kib() -> int;
+void set_preload_kib(int value);
+
+// split hi-res flac decoding across a second core, dual core builds only
+auto get_parallel_decode() -> bool;
+void set_parallel_decode(bool value);
+
+// triangular dither when WANT_FLOAT output is converted to s16
+auto get_dither() -> bool;
+void set_dither(bool value);
+
+// raw 48kHz copies of resampled tracks rendered in the home menu, 0 disables
+auto get_pcm_cache_mib() -> int;
+void set_pcm_cache_mib(int value);
+
+// extra plays of a bfstm/brstm loop before the track ends, 0 loops until skipped
+auto get_stream_loops() -> int;
+void set_stream_loops(int value);
+
+// resampler filter, 0 linear, 1 cubic, 2 short sinc, 3 full sinc
+auto get_resampler_quality() -> int;
+void set_resampler_quality(int value);
+
 // returns the length of the string
 auto get_load_path(char* out, int max_len) -> int;
 void set_load_path(const char* path);
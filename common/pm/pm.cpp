@@ -48,4 +48,8 @@ auto PollCurrentPidTid(u64* pid_out, u64* tid_out) -> bool {
     return false;
 }
 
+auto IsHomeMenu(u64 tid) -> bool {
+    return tid == QLAUNCH_TITLE_ID;
+}
+
 }
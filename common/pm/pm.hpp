@@ -8,5 +8,6 @@ auto Initialize() -> Result;
 void Exit();
 void getCurrentPidTid(u64* pid_out, u64* tid_out);
 auto PollCurrentPidTid(u64* pid_out, u64* tid_out) -> bool;
+auto IsHomeMenu(u64 tid) -> bool;
 
 }
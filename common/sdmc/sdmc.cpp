@@ -1,5 +1,7 @@
 #include "sdmc.hpp"
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 
 namespace sdmc {
@@ -8,29 +10,129 @@ namespace sdmc {
 
         FsFileSystem sdmc;
         char path_buffer[FS_MAX_PATH];
+        // path_buffer is shared, files are opened from the background thread as well.
+        Mutex path_mutex;
+
+        class PathLock {
+          public:
+            PathLock(const char *path) {
+                mutexLock(&path_mutex);
+                std::strcpy(path_buffer, path);
+            }
+            ~PathLock() {
+                mutexUnlock(&path_mutex);
+            }
+        };
+
+        constexpr s64 PAGE_SIZE = 0x1000;
+        constexpr u32 PAGE_COUNT = 16;
+        constexpr s64 HEAD_SIZE = PAGE_SIZE * 4;
+        constexpr s64 TAIL_SIZE = PAGE_SIZE * 2;
+
+        struct Page {
+            FileKey key;
+            s64 off;
+            s64 size;
+            u64 last_use;
+            // read without cache_mutex held, neither served nor evicted until it is done.
+            bool loading;
+        };
+
+        Page pages[PAGE_COUNT];
+        // allocated on first use, the overlay links this file as well but never reads through it.
+        u8 *page_data;
+        u64 use_counter;
+        u32 cache_hits;
+        u32 cache_misses;
+        Mutex cache_mutex;
+
+        bool IsCached(const FileKey &key, s64 offset) {
+            return offset < HEAD_SIZE || offset >= key.size - TAIL_SIZE;
+        }
+
+        // cache_mutex must be held.
+        Page *FindPage(const FileKey &key, s64 page_off) {
+            for (auto &page : pages) {
+                if (!page.loading && page.size && page.off == page_off && page.key == key) {
+                    return &page;
+                }
+            }
+            return nullptr;
+        }
+
+        // cache_mutex must be held, it is dropped while a missing page is read so other
+        // readers aren't blocked behind the sd card.
+        Page *GetPage(FsFile *file, const FileKey &key, s64 page_off) {
+            if (const auto page = FindPage(key, page_off)) {
+                page->last_use = ++use_counter;
+                cache_hits++;
+                return page;
+            }
+
+            Page *lru = nullptr;
+            for (auto &page : pages) {
+                if (!page.loading && (!lru || page.last_use < lru->last_use)) {
+                    lru = &page;
+                }
+            }
+
+            cache_misses++;
+            if (!lru) {
+                return nullptr;
+            }
+
+            lru->key = key;
+            lru->off = page_off;
+            lru->size = 0;
+            lru->loading = true;
+
+            mutexUnlock(&cache_mutex);
+            u64 bytes_read = 0;
+            const auto rc = fsFileRead(file, page_off, page_data + (lru - pages) * PAGE_SIZE, PAGE_SIZE, 0, &bytes_read);
+            mutexLock(&cache_mutex);
+
+            lru->loading = false;
+            if (R_FAILED(rc) || !bytes_read) {
+                return nullptr;
+            }
+
+            // someone else read the same page meanwhile, keep theirs and free the slot again.
+            if (const auto page = FindPage(key, page_off)) {
+                page->last_use = ++use_counter;
+                return page;
+            }
+
+            lru->size = bytes_read;
+            lru->last_use = ++use_counter;
+            return lru;
+        }
 
     }
 
     Result Open() {
+        mutexInit(&cache_mutex);
+        mutexInit(&path_mutex);
         return fsOpenSdCardFileSystem(&sdmc);
     }
 
     void Close() {
+        std::free(page_data);
+        page_data = nullptr;
         fsFsClose(&sdmc);
     }
 
     Result OpenFile(FsFile *file, const char *path, int open_mode) {
-        std::strcpy(path_buffer, path);
+        PathLock lk(path);
         return fsFsOpenFile(&sdmc, path_buffer, open_mode, file);
     }
 
     Result OpenDir(FsDir *dir, const char *path, int open_mode) {
-        std::strcpy(path_buffer, path);
+        PathLock lk(path);
         return fsFsOpenDirectory(&sdmc, path_buffer, open_mode, dir);
     }
 
     Result GetType(const char* path, FsDirEntryType* type) {
-        std::strcpy(path_buffer, path);
+        PathLock lk(path);
         return fsFsGetEntryType(&sdmc, path_buffer, type);;
     }
 
@@ -39,9 +141,108 @@ namespace sdmc {
         return R_SUCCEEDED(GetType(path, &type)) && type == FsDirEntryType_File;
     }
 
+    Result GetModifiedTime(const char* path, u64* modified) {
+        PathLock lk(path);
+        FsTimeStampRaw timestamp;
+        Result rc = fsFsGetFileTimeStampRaw(&sdmc, path_buffer, &timestamp);
+        if (R_SUCCEEDED(rc)) {
+            *modified = timestamp.is_valid ? timestamp.modified : 0;
+        }
+        return rc;
+    }
+
     Result CreateFolder(const char* path) {
-        std::strcpy(path_buffer, path);
+        PathLock lk(path);
         return fsFsCreateDirectory(&sdmc, path_buffer);
     }
 
+    Result CreateFile(const char* path, s64 size) {
+        PathLock lk(path);
+        return fsFsCreateFile(&sdmc, path_buffer, size, 0);
+    }
+
+    Result DeleteFile(const char* path) {
+        PathLock lk(path);
+        return fsFsDeleteFile(&sdmc, path_buffer);
+    }
+
+    // fnv-1a
+    u64 HashPath(const char* path) {
+        u64 hash = 0xCBF29CE484222325;
+        for (; *path; path++) {
+            hash = (hash ^ u8(*path)) * 0x100000001B3;
+        }
+        return hash;
+    }
+
+    FileKey MakeFileKey(const char* path, s64 size) {
+        // without a timestamp the key falls back to path and size.
+        u64 modified = 0;
+        GetModifiedTime(path, &modified);
+        return {HashPath(path), size, modified};
+    }
+
+    Result ReadFile(FsFile* file, const FileKey& key, s64 offset, void* buffer, u64 size, u64* bytes_read) {
+        auto dst = static_cast<u8*>(buffer);
+        *bytes_read = 0;
+
+        while (size && offset < key.size) {
+            if (!IsCached(key, offset)) {
+                // straight through up to where the tail starts.
+                const auto direct = std::min<u64>(size, (key.size - TAIL_SIZE) - offset);
+                u64 direct_read = 0;
+                Result rc = fsFileRead(file, offset, dst, direct, 0, &direct_read);
+                if (R_FAILED(rc)) {
+                    return *bytes_read ? 0 : rc;
+                }
+
+                *bytes_read += direct_read;
+                if (direct_read != direct) {
+                    break;
+                }
+                dst += direct;
+                offset += direct;
+                size -= direct;
+                continue;
+            }
+
+            mutexLock(&cache_mutex);
+            if (!page_data) {
+                page_data = static_cast<u8*>(std::malloc(PAGE_SIZE * PAGE_COUNT));
+            }
+
+            const auto page_off = offset & ~(PAGE_SIZE - 1);
+            const auto page = page_data ? GetPage(file, key, page_off) : nullptr;
+            if (!page) {
+                mutexUnlock(&cache_mutex);
+                // no memory for the cache, or the read failed. either way let fs decide.
+                u64 direct_read = 0;
+                Result rc = fsFileRead(file, offset, dst, size, 0, &direct_read);
+                *bytes_read += direct_read;
+                return *bytes_read ? 0 : rc;
+            }
+
+            const auto copy = std::min<s64>(size, page->off + page->size - offset);
+            if (copy > 0) {
+                std::memcpy(dst, page_data + (page - pages) * PAGE_SIZE + (offset - page_off), copy);
+            }
+            mutexUnlock(&cache_mutex);
+
+            if (copy <= 0) {
+                break;
+            }
+            *bytes_read += copy;
+            dst += copy;
+            offset += copy;
+            size -= copy;
+        }
+
+        return 0;
+    }
+
+    void GetCacheStats(u32* hits, u32* misses) {
+        *hits = cache_hits;
+        *misses = cache_misses;
+    }
+
 }
@@ -12,7 +12,30 @@ namespace sdmc {
 
     Result GetType(const char* path, FsDirEntryType* type);
     bool FileExists(const char* path);
+    // modification time as reported by fs, 0 if the fs doesn't track it.
+    Result GetModifiedTime(const char* path, u64* modified);
 
     Result CreateFolder(const char* path);
+    Result CreateFile(const char* path, s64 size);
+    Result DeleteFile(const char* path);
+
+    u64 HashPath(const char* path);
+
+    // identifies a file in the page cache, independent of the handle it was opened with.
+    // the modification time tells apart a file that was rewritten in place at the same size.
+    struct FileKey {
+        u64 path_hash;
+        s64 size;
+        u64 modified;
+
+        bool operator==(const FileKey&) const = default;
+    };
+
+    FileKey MakeFileKey(const char* path, s64 size);
+
+    // reads through a small shared page cache. only the head and tail of a file are
+    // cached, that's where headers, tags and seek tables live, the rest is read directly.
+    Result ReadFile(FsFile* file, const FileKey& key, s64 offset, void* buffer, u64 size, u64* bytes_read);
+    void GetCacheStats(u32* hits, u32* misses);
 
 }
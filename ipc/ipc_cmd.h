@@ -18,6 +18,8 @@ enum TuneIpcCmd {
     TuneIpcCmd_SetRepeatMode = 21,
     TuneIpcCmd_GetShuffleMode = 22,
     TuneIpcCmd_SetShuffleMode = 23,
+    TuneIpcCmd_GetResamplerQuality = 24,
+    TuneIpcCmd_SetResamplerQuality = 25,
 
     TuneIpcCmd_GetPlaylistSize = 30,
     TuneIpcCmd_GetPlaylistItem = 31,
@@ -29,8 +31,12 @@ enum TuneIpcCmd {
 
     TuneIpcCmd_Enqueue = 40,
     TuneIpcCmd_Remove = 41,
+    TuneIpcCmd_Probe = 42,
 
     TuneIpcCmd_QuitServer = 50,
 
+    TuneIpcCmd_GetIoStats = 60,
+    TuneIpcCmd_GetMemoryStats = 61,
+
     TuneIpcCmd_GetApiVersion = 5000,
 };
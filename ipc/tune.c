@@ -90,6 +90,19 @@ Result tuneSetShuffleMode(TuneShuffleMode state) {
     return serviceDispatchIn(&g_tune, TuneIpcCmd_SetShuffleMode, tmp);
 }
 
+Result tuneGetResamplerQuality(TuneResamplerQuality *quality) {
+    u8 out = 0;
+    Result rc = serviceDispatchOut(&g_tune, TuneIpcCmd_GetResamplerQuality, out);
+    if (R_SUCCEEDED(rc) && quality)
+        *quality = out;
+    return rc;
+}
+
+Result tuneSetResamplerQuality(TuneResamplerQuality quality) {
+    u8 tmp = quality;
+    return serviceDispatchIn(&g_tune, TuneIpcCmd_SetResamplerQuality, tmp);
+}
+
 Result tuneGetPlaylistSize(u32 *count) {
     return serviceDispatchOut(&g_tune, TuneIpcCmd_GetPlaylistSize, *count);
 }
@@ -138,10 +151,25 @@ Result tuneRemove(u32 index) {
     return serviceDispatchIn(&g_tune, TuneIpcCmd_Remove, index);
 }
 
+Result tuneProbe(const char *path, TuneProbeInfo *out) {
+    size_t path_length = strlen(path);
+    return serviceDispatchOut(&g_tune, TuneIpcCmd_Probe, *out,
+                              .buffer_attrs = {SfBufferAttr_In | SfBufferAttr_HipcMapAlias},
+                              .buffers = {{path, path_length}}, );
+}
+
 Result tuneQuit() {
     return serviceDispatch(&g_tune, TuneIpcCmd_QuitServer);
 }
 
+Result tuneGetIoStats(TuneIoStats *out) {
+    return serviceDispatchOut(&g_tune, TuneIpcCmd_GetIoStats, *out);
+}
+
+Result tuneGetMemoryStats(TuneMemoryStats *out) {
+    return serviceDispatchOut(&g_tune, TuneIpcCmd_GetMemoryStats, *out);
+}
+
 Result tuneGetApiVersion(u32 *version) {
     return serviceDispatchOut(&g_tune, TuneIpcCmd_GetApiVersion, *version);
 }
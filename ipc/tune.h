@@ -21,6 +21,15 @@ typedef enum {
     TuneRepeatMode_Count,
 } TuneRepeatMode;
 
+typedef enum {
+    TuneResamplerQuality_Linear,    ///< 2 taps, cheapest, aliases on downsampling.
+    TuneResamplerQuality_Cubic,     ///< 4 taps, Catmull-Rom.
+    TuneResamplerQuality_SincShort, ///< 8 taps, windowed sinc.
+    TuneResamplerQuality_Sinc,      ///< 12 taps, windowed sinc, the default.
+
+    TuneResamplerQuality_Count,
+} TuneResamplerQuality;
+
 typedef enum {
     TuneEnqueueType_Front,
     TuneEnqueueType_Back,
@@ -34,6 +43,42 @@ typedef struct {
     u32 total_frames;
 } TuneCurrentStats;
 
+typedef enum {
+    TuneCodec_None,
+    TuneCodec_Mp3,
+    TuneCodec_Flac,
+    TuneCodec_Wav,
+    TuneCodec_Bfstm,     ///< bfstm, bcstm and brstm.
+    TuneCodec_Ogg,       ///< flac or vorbis in an ogg container.
+} TuneCodec;
+
+typedef struct {
+    u32 codec;           ///< \ref TuneCodec
+    u32 sample_rate;
+    u32 channels;
+    u32 bits_per_sample; ///< 0 for lossy codecs.
+    u64 total_frames;
+    u32 bitrate_kbps;
+    u8 total_estimated;  ///< total_frames was worked out from the bitrate.
+    u8 reserved[3];
+} TuneProbeInfo;
+
+typedef struct {
+    u32 window_size;    ///< read-ahead bytes of the current track.
+    u32 latency_us;     ///< average time of one sd read.
+    u32 throughput_kib; ///< average KiB/s of those reads.
+    u32 memory_used;    ///< read-ahead bytes of all open tracks.
+    u32 cache_hits;     ///< page cache hits since boot.
+    u32 cache_misses;   ///< page cache misses since boot.
+} TuneIoStats;
+
+typedef struct {
+    u32 arena_size;       ///< size of one decoder arena.
+    u32 arena_high_water; ///< most bytes any decoder arena has had in use.
+    u32 arena_fallback;   ///< decoder bytes currently on the heap because an arena was full.
+    u32 heap_used;        ///< bytes currently allocated from the heap.
+} TuneMemoryStats;
+
 Result tuneInitialize();
 
 void tuneExit();
@@ -102,6 +147,19 @@ Result tuneSetRepeatMode(TuneRepeatMode state);
 Result tuneGetShuffleMode(TuneShuffleMode *state);
 Result tuneSetShuffleMode(TuneShuffleMode state);
 
+/**
+ * @brief Get the filter used when a track has to be resampled.
+ * @param[out] quality \ref TuneResamplerQuality
+ */
+Result tuneGetResamplerQuality(TuneResamplerQuality *quality);
+
+/**
+ * @brief Set the filter used when a track has to be resampled, saved to the config.
+ * @note Takes effect from the next track, cheaper filters leave more cpu time to the game.
+ * @param[in] quality \ref TuneResamplerQuality
+ */
+Result tuneSetResamplerQuality(TuneResamplerQuality quality);
+
 /**
  * @brief Get the current queue size.
  * @param[out] count remaining tracks after current.
@@ -142,8 +200,30 @@ Result tuneEnqueue(const char *path, TuneEnqueueType type);
 
 Result tuneRemove(u32 index);
 
+/**
+ * @brief Read format and duration of a file from its headers, without playing it.
+ * @note Same path rules as \ref tuneEnqueue.
+ * @note Fails for files whose headers can't be parsed, even if they would play.
+ * @param[in] path Path to file on sdcard.
+ * @param[out] out \ref TuneProbeInfo
+ */
+Result tuneProbe(const char *path, TuneProbeInfo *out);
+
 Result tuneQuit();
 
+/**
+ * @brief Get read-ahead statistics, for tuning.
+ * @note window_size, latency_us and throughput_kib are 0 when nothing is playing.
+ * @param[out] out \ref TuneIoStats
+ */
+Result tuneGetIoStats(TuneIoStats *out);
+
+/**
+ * @brief Get decoder memory statistics, for sizing the heap and arenas.
+ * @param[out] out \ref TuneMemoryStats
+ */
+Result tuneGetMemoryStats(TuneMemoryStats *out);
+
 Result tuneGetApiVersion(u32 *version);
 
 #ifdef __cplusplus
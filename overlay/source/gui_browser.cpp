@@ -24,9 +24,18 @@ namespace {
 #ifdef WANT_FLAC
         ".flac",
 #endif
+#ifdef WANT_OGG
+        ".oga",
+        ".ogg",
+#endif
 #ifdef WANT_WAV
         ".wav",
         ".wave",
+#endif
+#ifdef WANT_BFSTM
+        ".bfstm",
+        ".bcstm",
+        ".brstm",
 #endif
     };
 
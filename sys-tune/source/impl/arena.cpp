@@ -0,0 +1,178 @@
+#include "arena.hpp"
+
+#include <nxExt.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+    // every allocation is prefixed with its size, keeps the data 16 byte aligned.
+    constexpr size_t HEADER_SIZE = 0x10;
+
+    u8 *g_memory[Arena::COUNT];
+    bool g_in_use[Arena::COUNT];
+    LockableMutex g_mutex;
+
+    std::atomic<u32> g_high_water{};
+    std::atomic<u32> g_fallback_bytes{};
+
+    constexpr size_t Align(size_t size) {
+        return (size + 0xF) & ~0xF;
+    }
+
+    size_t &SizeOf(void *p) {
+        return *reinterpret_cast<size_t *>(static_cast<u8 *>(p) - HEADER_SIZE);
+    }
+
+    void UpdateHighWater(u32 used) {
+        auto high_water = g_high_water.load();
+        while (used > high_water && !g_high_water.compare_exchange_weak(high_water, used)) {
+        }
+    }
+
+    void *FallbackMalloc(size_t size) {
+        auto block = static_cast<u8 *>(std::malloc(HEADER_SIZE + size));
+        if (!block) {
+            return nullptr;
+        }
+
+        *reinterpret_cast<size_t *>(block) = size;
+        g_fallback_bytes += size;
+        return block + HEADER_SIZE;
+    }
+
+}
+
+Arena::~Arena() {
+    if (m_slot >= 0) {
+        std::scoped_lock lk(g_mutex);
+        g_in_use[m_slot] = false;
+    }
+}
+
+void *Arena::Malloc(size_t size) {
+#ifdef DEBUG
+    std::printf("malloc: 0x%lX\n", size);
+#endif
+
+    if (!m_base) {
+        TakeSlot();
+    }
+
+    if (!m_base || m_used + HEADER_SIZE + Align(size) > SIZE) {
+        return FallbackMalloc(size);
+    }
+
+    auto block = m_base + m_used;
+    *reinterpret_cast<size_t *>(block) = size;
+    m_last = m_used;
+    m_used += HEADER_SIZE + Align(size);
+    UpdateHighWater(m_used);
+    return block + HEADER_SIZE;
+}
+
+void *Arena::Realloc(void *p, size_t size) {
+#ifdef DEBUG
+    std::printf("realloc: %p, 0x%lX\n", p, size);
+#endif
+
+    if (!p) {
+        return Malloc(size);
+    }
+
+    if (!size) {
+        Free(p);
+        return nullptr;
+    }
+
+    const auto old_size = SizeOf(p);
+
+    if (!Owns(p)) {
+        auto block = static_cast<u8 *>(std::realloc(static_cast<u8 *>(p) - HEADER_SIZE, HEADER_SIZE + size));
+        if (!block) {
+            return nullptr;
+        }
+
+        *reinterpret_cast<size_t *>(block) = size;
+        g_fallback_bytes += size - old_size;
+        return block + HEADER_SIZE;
+    }
+
+    // dr_libs grow their read buffers, that is always the newest allocation.
+    const size_t offset = static_cast<u8 *>(p) - HEADER_SIZE - m_base;
+    if (offset == m_last && m_last + HEADER_SIZE + Align(size) <= SIZE) {
+        SizeOf(p) = size;
+        m_used = m_last + HEADER_SIZE + Align(size);
+        UpdateHighWater(m_used);
+        return p;
+    }
+
+    auto new_p = Malloc(size);
+    if (!new_p) {
+        return nullptr;
+    }
+
+    std::memcpy(new_p, p, std::min(old_size, size));
+    Free(p);
+    return new_p;
+}
+
+void Arena::Free(void *p) {
+#ifdef DEBUG
+    std::printf("free: %p\n", p);
+#endif
+
+    if (!p) {
+        return;
+    }
+
+    if (!Owns(p)) {
+        g_fallback_bytes -= SizeOf(p);
+        std::free(static_cast<u8 *>(p) - HEADER_SIZE);
+        return;
+    }
+
+    // anything but the newest allocation stays until the whole arena is released.
+    const size_t offset = static_cast<u8 *>(p) - HEADER_SIZE - m_base;
+    if (offset == m_last) {
+        m_used = m_last;
+    }
+}
+
+u32 Arena::GetHighWater() {
+    return g_high_water;
+}
+
+u32 Arena::GetFallbackBytes() {
+    return g_fallback_bytes;
+}
+
+bool Arena::Owns(const void *p) const {
+    return m_base && p >= m_base && p < m_base + SIZE;
+}
+
+void Arena::TakeSlot() {
+    std::scoped_lock lk(g_mutex);
+
+    for (u32 i = 0; i < COUNT; i++) {
+        if (g_in_use[i]) {
+            continue;
+        }
+
+        // kept once allocated, freeing it again would bring the fragmentation back.
+        if (!g_memory[i]) {
+            g_memory[i] = static_cast<u8 *>(std::aligned_alloc(0x10, SIZE));
+            if (!g_memory[i]) {
+                return;
+            }
+        }
+
+        g_in_use[i] = true;
+        m_slot = i;
+        m_base = g_memory[i];
+        return;
+    }
+}
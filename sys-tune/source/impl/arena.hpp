@@ -0,0 +1,62 @@
+#pragma once
+
+#include <switch.h>
+#include <cstddef>
+
+// bump allocator for decoder state. a track takes one of a few fixed slots on its
+// first allocation and gives it back in one go when it closes, so hours of track
+// changes don't fragment the heap. allocations that don't fit fall back to malloc.
+// the slots come from the heap the first time they are used and stay there, the
+// heap size in main.cpp includes them.
+class Arena {
+  public:
+    // the largest decoder tests/memory_bench measures is a vorbis stream at 110KiB, hi-res
+    // flac takes 69KiB, mp3 16KiB. the parallel decode worker opens a second flac decoder
+    // in the same slot, 137KiB for both.
+#ifdef WANT_DUALCORE
+    static constexpr size_t SIZE = 1024 * 140;
+#else
+    static constexpr size_t SIZE = 1024 * 112;
+#endif
+    // the current track and the prerolled next one.
+    static constexpr u32 COUNT = 2;
+
+  private:
+    u8 *m_base{};
+    size_t m_used{};
+    // offset of the last allocation, the only one that can grow or shrink in place.
+    size_t m_last{};
+    s32 m_slot{-1};
+
+  public:
+    Arena() = default;
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *Malloc(size_t size);
+    void *Realloc(void *p, size_t size);
+    void Free(void *p);
+
+    // matches the dr_libs allocation callbacks, which all share the same layout.
+    template<typename T>
+    T GetCallbacks() {
+        return T{
+            .pUserData = this,
+            .onMalloc  = [](size_t sz, void *user) { return static_cast<Arena *>(user)->Malloc(sz); },
+            .onRealloc = [](void *p, size_t sz, void *user) { return static_cast<Arena *>(user)->Realloc(p, sz); },
+            .onFree    = [](void *p, void *user) { static_cast<Arena *>(user)->Free(p); },
+        };
+    }
+
+    // most bytes any slot has had in use, for sizing SIZE.
+    static u32 GetHighWater();
+    // bytes currently allocated from the heap because a slot was full or none was free.
+    static u32 GetFallbackBytes();
+
+  private:
+    bool Owns(const void *p) const;
+    // sources that never allocate through the callbacks don't hold a slot.
+    void TakeSlot();
+};
@@ -0,0 +1,81 @@
+#include "background.hpp"
+
+#include <cstring>
+#include <nxExt.h>
+
+namespace tune::impl::background {
+
+    namespace {
+
+        constexpr auto QUEUE_SIZE_MAX = 4;
+        constexpr auto PATH_SIZE_MAX = 256;
+
+        struct Entry {
+            Task task;
+            char path[PATH_SIZE_MAX];
+        };
+
+        LockableMutex g_mutex;
+        Entry g_queue[QUEUE_SIZE_MAX];
+        u32 g_queue_size = 0;
+
+        bool g_should_run = true;
+
+        bool Pop(Entry &out) {
+            std::scoped_lock lk(g_mutex);
+
+            if (!g_queue_size) {
+                return false;
+            }
+
+            out = g_queue[0];
+            std::memmove(g_queue, g_queue + 1, --g_queue_size * sizeof(Entry));
+            return true;
+        }
+
+    }
+
+    bool Post(Task task, const char *path) {
+        if (std::strlen(path) >= PATH_SIZE_MAX) {
+            return false;
+        }
+
+        std::scoped_lock lk(g_mutex);
+
+        for (u32 i = 0; i < g_queue_size; i++) {
+            if (g_queue[i].task == task && !std::strcmp(g_queue[i].path, path)) {
+                return true;
+            }
+        }
+
+        if (g_queue_size >= QUEUE_SIZE_MAX) {
+            return false;
+        }
+
+        auto &entry = g_queue[g_queue_size++];
+        entry.task = task;
+        std::strcpy(entry.path, path);
+        return true;
+    }
+
+    bool ShouldStop() {
+        return !g_should_run;
+    }
+
+    void ThreadFunc(void *) {
+        while (g_should_run) {
+            Entry entry;
+            if (!Pop(entry)) {
+                svcSleepThread(100'000'000ul);
+                continue;
+            }
+
+            entry.task(entry.path);
+        }
+    }
+
+    void Exit() {
+        g_should_run = false;
+    }
+
+}
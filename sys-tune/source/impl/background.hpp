@@ -0,0 +1,17 @@
+#pragma once
+
+#include <switch.h>
+
+namespace tune::impl::background {
+
+    using Task = void (*)(const char *path);
+
+    // queues a task for the low priority background thread, duplicates are dropped.
+    bool Post(Task task, const char *path);
+    // long running tasks poll this and bail out early on exit.
+    bool ShouldStop();
+
+    void ThreadFunc(void *);
+    void Exit();
+
+}
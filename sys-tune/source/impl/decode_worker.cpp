@@ -0,0 +1,81 @@
+#include "decode_worker.hpp"
+
+namespace tune::impl::decode_worker {
+
+    namespace {
+
+        // libnx mutex and condvar are valid zero initialised.
+        Mutex g_mutex;
+        CondVar g_request_cv;
+        CondVar g_done_cv;
+        Func g_func = nullptr;
+        void *g_user = nullptr;
+        bool g_running = false;
+        bool g_should_run = true;
+
+    }
+
+    bool IsAvailable() {
+        mutexLock(&g_mutex);
+        const bool available = g_running;
+        mutexUnlock(&g_mutex);
+        return available;
+    }
+
+    bool Submit(Func func, void *user) {
+        mutexLock(&g_mutex);
+
+        const bool accepted = g_running && !g_func;
+        if (accepted) {
+            g_func = func;
+            g_user = user;
+            condvarWakeOne(&g_request_cv);
+        }
+
+        mutexUnlock(&g_mutex);
+        return accepted;
+    }
+
+    void Wait(void *user) {
+        mutexLock(&g_mutex);
+        while (g_func && g_user == user) {
+            condvarWait(&g_done_cv, &g_mutex);
+        }
+        mutexUnlock(&g_mutex);
+    }
+
+    void ThreadFunc(void *) {
+        mutexLock(&g_mutex);
+        g_running = true;
+
+        // a job submitted just before exit is still run, its owner is waiting on it.
+        while (g_should_run || g_func) {
+            if (!g_func) {
+                condvarWait(&g_request_cv, &g_mutex);
+                continue;
+            }
+
+            const auto func = g_func;
+            const auto user = g_user;
+            mutexUnlock(&g_mutex);
+
+            func(user);
+
+            mutexLock(&g_mutex);
+            g_func = nullptr;
+            g_user = nullptr;
+            condvarWakeAll(&g_done_cv);
+        }
+
+        g_running = false;
+        mutexUnlock(&g_mutex);
+    }
+
+    void Exit() {
+        mutexLock(&g_mutex);
+        g_should_run = false;
+        condvarWakeAll(&g_request_cv);
+        mutexUnlock(&g_mutex);
+    }
+
+}
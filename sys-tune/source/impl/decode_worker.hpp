@@ -0,0 +1,20 @@
+#pragma once
+
+#include <switch.h>
+
+// runs one decode job at a time on a second core. only started in dual core builds,
+// everywhere else IsAvailable() stays false and sources decode everything inline.
+namespace tune::impl::decode_worker {
+
+    using Func = void (*)(void *user);
+
+    bool IsAvailable();
+    // false when the worker isn't running or is busy with another job.
+    bool Submit(Func func, void *user);
+    // blocks until the job passed to Submit has finished.
+    void Wait(void *user);
+
+    void ThreadFunc(void *);
+    void Exit();
+
+}
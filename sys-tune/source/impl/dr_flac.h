@@ -985,6 +985,21 @@ Return Value
 */
 DRFLAC_API drflac_bool32 drflac_seek_to_pcm_frame(drflac* pFlac, drflac_uint64 pcmFrameIndex);
 
+/*
+TUNE-FIX: frame level access, for splitting the decoding of one native FLAC stream across two decoders.
+
+drflac_find_flac_frame() seeks the stream to byteOffset and reads frame headers from there until it finds one that starts
+at minPCMFrame or later, pFirstPCMFrame receives where it starts. The frame is not decoded yet, drflac_decode_flac_frame()
+does that and leaves the decoder ready to read from it. If either fails the decoder has to be seeked with
+drflac_seek_to_pcm_frame() before it is used again.
+
+drflac_get_unread_byte_count() is the number of bytes read from the client that the decoder hasn't consumed yet. After a
+frame has been read to the end, the client's position minus this is where the next frame header starts.
+*/
+DRFLAC_API drflac_bool32 drflac_find_flac_frame(drflac* pFlac, drflac_uint64 byteOffset, drflac_uint64 minPCMFrame, drflac_uint64* pFirstPCMFrame);
+DRFLAC_API drflac_bool32 drflac_decode_flac_frame(drflac* pFlac);
+DRFLAC_API drflac_uint64 drflac_get_unread_byte_count(drflac* pFlac);
+
 
 
 #ifndef DR_FLAC_NO_STDIO
@@ -11682,6 +11697,64 @@ DRFLAC_API drflac_bool32 drflac_seek_to_pcm_frame(drflac* pFlac, drflac_uint64 p
     }
 }
 
+/* TUNE-FIX */
+DRFLAC_API drflac_bool32 drflac_find_flac_frame(drflac* pFlac, drflac_uint64 byteOffset, drflac_uint64 minPCMFrame, drflac_uint64* pFirstPCMFrame)
+{
+    drflac_uint64 firstPCMFrame;
+
+    if (pFlac == NULL || pFlac->container != drflac_container_native || byteOffset < pFlac->firstFLACFramePosInBytes) {
+        return DRFLAC_FALSE;
+    }
+
+    if (!drflac__seek_to_byte(&pFlac->bs, byteOffset)) {
+        return DRFLAC_FALSE;
+    }
+
+    /* Nothing is decoded until drflac_decode_flac_frame(). */
+    pFlac->currentFLACFrame.pcmFramesRemaining = 0;
+
+    for (;;) {
+        if (!drflac__read_next_flac_frame_header(&pFlac->bs, pFlac->bitsPerSample, &pFlac->currentFLACFrame.header)) {
+            return DRFLAC_FALSE;
+        }
+
+        drflac__get_pcm_frame_range_of_current_flac_frame(pFlac, &firstPCMFrame, NULL);
+        if (firstPCMFrame >= minPCMFrame) {
+            break;
+        }
+    }
+
+    pFlac->currentPCMFrame = firstPCMFrame;
+    if (pFirstPCMFrame != NULL) {
+        *pFirstPCMFrame = firstPCMFrame;
+    }
+
+    return DRFLAC_TRUE;
+}
+
+/* TUNE-FIX */
+DRFLAC_API drflac_bool32 drflac_decode_flac_frame(drflac* pFlac)
+{
+    if (pFlac == NULL) {
+        return DRFLAC_FALSE;
+    }
+
+    return drflac__decode_flac_frame(pFlac) == DRFLAC_SUCCESS;
+}
+
+/* TUNE-FIX */
+DRFLAC_API drflac_uint64 drflac_get_unread_byte_count(drflac* pFlac)
+{
+    drflac_bs* bs;
+
+    if (pFlac == NULL) {
+        return 0;
+    }
+
+    bs = &pFlac->bs;
+    return (DRFLAC_CACHE_L1_BITS_REMAINING(bs) >> 3) + DRFLAC_CACHE_L2_LINES_REMAINING(bs) * sizeof(bs->cacheL2[0]) + bs->unalignedByteCount;
+}
+
 
 
 /* High Level APIs */
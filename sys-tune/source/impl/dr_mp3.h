@@ -505,6 +505,14 @@ Note that seektable seeking is not quite sample exact when the MP3 stream contai
 */
 DRMP3_API drmp3_bool32 drmp3_calculate_seek_points(drmp3* pMP3, drmp3_uint32* pSeekPointCount, drmp3_seek_point* pSeekPoints);
 
+/*
+TUNE-FIX: same as drmp3_calculate_seek_points(), but in a single pass over the stream that also returns the PCM frame count.
+
+The length isn't known up front, so the points start close together and every other one is dropped whenever the table
+fills up. On output pSeekPointCount is between half and all of the requested count, for streams long enough to need it.
+*/
+DRMP3_API drmp3_bool32 drmp3_calculate_seek_points_and_pcm_frame_count(drmp3* pMP3, drmp3_uint32* pSeekPointCount, drmp3_seek_point* pSeekPoints, drmp3_uint64* pPCMFrameCount);
+
 /*
 Binds a seek table to the decoder.
 
@@ -4727,6 +4735,125 @@ DRMP3_API drmp3_bool32 drmp3_calculate_seek_points(drmp3* pMP3, drmp3_uint32* pS
     return DRMP3_TRUE;
 }
 
+/* TUNE-FIX */
+DRMP3_API drmp3_bool32 drmp3_calculate_seek_points_and_pcm_frame_count(drmp3* pMP3, drmp3_uint32* pSeekPointCount, drmp3_seek_point* pSeekPoints, drmp3_uint64* pPCMFrameCount)
+{
+    drmp3_uint32 seekPointCapacity;
+    drmp3_uint32 seekPointCount = 0;
+    drmp3_uint64 currentPCMFrame;
+    drmp3__seeking_mp3_frame_info mp3FrameInfo[DRMP3_SEEK_LEADING_MP3_FRAMES+1];
+    drmp3_uint64 runningPCMFrameCount = 0;
+    float runningPCMFrameCountFractionalPart = 0;
+    drmp3_uint64 pcmFramesBetweenSeekPoints;
+    drmp3_uint64 nextTargetPCMFrame;
+    drmp3_uint32 pcmFramesInCurrentMP3FrameIn;
+    drmp3_uint32 iMP3Frame;
+    drmp3_uint32 i;
+
+    if (pMP3 == NULL || pSeekPointCount == NULL || pSeekPoints == NULL || pPCMFrameCount == NULL) {
+        return DRMP3_FALSE; /* Invalid args. */
+    }
+
+    /* Halving needs at least two points to keep one. */
+    seekPointCapacity = *pSeekPointCount;
+    if (seekPointCapacity < 2) {
+        return DRMP3_FALSE;
+    }
+
+    currentPCMFrame = pMP3->currentPCMFrame;
+
+    if (!drmp3_seek_to_start_of_stream(pMP3)) {
+        return DRMP3_FALSE;
+    }
+
+    /* The leading MP3 frames are read first, same as drmp3_calculate_seek_points(). */
+    for (iMP3Frame = 0; iMP3Frame < DRMP3_SEEK_LEADING_MP3_FRAMES+1; ++iMP3Frame) {
+        mp3FrameInfo[iMP3Frame].bytePos       = pMP3->streamCursor - pMP3->dataSize;
+        mp3FrameInfo[iMP3Frame].pcmFrameIndex = runningPCMFrameCount;
+
+        pcmFramesInCurrentMP3FrameIn = drmp3_decode_next_frame_ex(pMP3, NULL, NULL, NULL);
+        if (pcmFramesInCurrentMP3FrameIn == 0) {
+            break;
+        }
+
+        drmp3__accumulate_running_pcm_frame_count(pMP3, pcmFramesInCurrentMP3FrameIn, &runningPCMFrameCount, &runningPCMFrameCountFractionalPart);
+    }
+
+    if (iMP3Frame < DRMP3_SEEK_LEADING_MP3_FRAMES+1) {
+        /* Too short for anything but the very start of the stream. */
+        seekPointCount = 1;
+        pSeekPoints[0].seekPosInBytes     = 0;
+        pSeekPoints[0].pcmFrameIndex      = 0;
+        pSeekPoints[0].mp3FramesToDiscard = 0;
+        pSeekPoints[0].pcmFramesToDiscard = 0;
+    } else {
+        /*
+        The spacing is never less than the leading frames, so every target lands in a later MP3 frame than the one before it
+        and the frames to discard are always the cached ones.
+        */
+        pcmFramesBetweenSeekPoints = runningPCMFrameCount;
+        nextTargetPCMFrame = pcmFramesBetweenSeekPoints;
+
+        for (;;) {
+            if (nextTargetPCMFrame < runningPCMFrameCount) {
+                if (seekPointCount == seekPointCapacity) {
+                    /* Keep every second point, those sit on multiples of the doubled spacing. */
+                    for (i = 0; i < seekPointCount/2; ++i) {
+                        pSeekPoints[i] = pSeekPoints[i*2 + 1];
+                    }
+                    seekPointCount /= 2;
+                    pcmFramesBetweenSeekPoints *= 2;
+                    nextTargetPCMFrame = pcmFramesBetweenSeekPoints * (seekPointCount+1);
+                    continue;
+                }
+
+                pSeekPoints[seekPointCount].seekPosInBytes     = mp3FrameInfo[0].bytePos;
+                pSeekPoints[seekPointCount].pcmFrameIndex      = nextTargetPCMFrame;
+                pSeekPoints[seekPointCount].mp3FramesToDiscard = DRMP3_SEEK_LEADING_MP3_FRAMES;
+                pSeekPoints[seekPointCount].pcmFramesToDiscard = (drmp3_uint16)(nextTargetPCMFrame - mp3FrameInfo[DRMP3_SEEK_LEADING_MP3_FRAMES-1].pcmFrameIndex);
+                seekPointCount += 1;
+                nextTargetPCMFrame += pcmFramesBetweenSeekPoints;
+                continue;
+            }
+
+            for (i = 0; i < DRMP3_COUNTOF(mp3FrameInfo)-1; ++i) {
+                mp3FrameInfo[i] = mp3FrameInfo[i+1];
+            }
+
+            mp3FrameInfo[DRMP3_COUNTOF(mp3FrameInfo)-1].bytePos       = pMP3->streamCursor - pMP3->dataSize;
+            mp3FrameInfo[DRMP3_COUNTOF(mp3FrameInfo)-1].pcmFrameIndex = runningPCMFrameCount;
+
+            pcmFramesInCurrentMP3FrameIn = drmp3_decode_next_frame_ex(pMP3, NULL, NULL, NULL);
+            if (pcmFramesInCurrentMP3FrameIn == 0) {
+                break;
+            }
+
+            drmp3__accumulate_running_pcm_frame_count(pMP3, pcmFramesInCurrentMP3FrameIn, &runningPCMFrameCount, &runningPCMFrameCountFractionalPart);
+        }
+
+        /* Streams shorter than the first target still get the start of the stream. */
+        if (seekPointCount == 0) {
+            seekPointCount = 1;
+            pSeekPoints[0].seekPosInBytes     = 0;
+            pSeekPoints[0].pcmFrameIndex      = 0;
+            pSeekPoints[0].mp3FramesToDiscard = 0;
+            pSeekPoints[0].pcmFramesToDiscard = 0;
+        }
+    }
+
+    /* Finally, we need to seek back to where we were. */
+    if (!drmp3_seek_to_start_of_stream(pMP3)) {
+        return DRMP3_FALSE;
+    }
+    if (!drmp3_seek_to_pcm_frame(pMP3, currentPCMFrame)) {
+        return DRMP3_FALSE;
+    }
+
+    *pSeekPointCount = seekPointCount;
+    *pPCMFrameCount  = runningPCMFrameCount;
+    return DRMP3_TRUE;
+}
+
 DRMP3_API drmp3_bool32 drmp3_bind_seek_table(drmp3* pMP3, drmp3_uint32 seekPointCount, drmp3_seek_point* pSeekPoints)
 {
     if (pMP3 == NULL) {
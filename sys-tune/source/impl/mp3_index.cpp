@@ -0,0 +1,242 @@
+#ifdef WANT_MP3
+
+#include "mp3_index.hpp"
+#include "background.hpp"
+#include "sdmc/sdmc.hpp"
+
+#include <nxExt.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+namespace tune::impl::mp3_index {
+
+    namespace {
+
+        constexpr u32 INDEX_MAGIC = 0x58444954; // "TIDX"
+        constexpr u32 INDEX_VERSION = 1;
+        constexpr const char CACHE_DIR[]{"/config/sys-tune/cache"};
+
+        std::atomic<u32> g_generation{};
+        // the last index Build() made, until the track waiting on it takes it.
+        LockableMutex g_built_mutex;
+        Key g_built_key{};
+        std::shared_ptr<Index> g_built;
+
+        struct IndexHeader {
+            u32 magic;
+            u32 version;
+            Key key;
+            u64 total_pcm_frames;
+            u32 seek_point_count;
+            u32 reserved;
+        };
+
+        void GetCachePath(const Key &key, char *out, size_t size) {
+            std::snprintf(out, size, "%s/%016lX.idx", CACHE_DIR, key.path_hash);
+        }
+
+        // plain buffered reader, the scan doesn't need anything the Source reader does.
+        // goes through the page cache, so the header is still warm when the track is opened.
+        struct Reader {
+            FsFile file;
+            sdmc::FileKey key;
+            s64 offset;
+            s64 size;
+            s64 buffered_off;
+            s64 buffered_size;
+            u8 buffer[1024 * 16];
+
+            size_t Read(void *dst, size_t read_size) {
+                auto out = static_cast<u8 *>(dst);
+                size_t amount = 0;
+
+                while (read_size && !background::ShouldStop()) {
+                    if (offset < buffered_off || offset >= buffered_off + buffered_size) {
+                        u64 bytes_read = 0;
+                        if (R_FAILED(sdmc::ReadFile(&file, key, offset, buffer, sizeof(buffer), &bytes_read)) || !bytes_read) {
+                            break;
+                        }
+                        buffered_off = offset;
+                        buffered_size = bytes_read;
+                    }
+
+                    const auto size = std::min<s64>(read_size, buffered_off + buffered_size - offset);
+                    std::memcpy(out, buffer + (offset - buffered_off), size);
+                    out += size;
+                    offset += size;
+                    amount += size;
+                    read_size -= size;
+                }
+
+                return amount;
+            }
+        };
+
+        size_t ReadCallback(void *pUserData, void *pBufferOut, size_t bytesToRead) {
+            return static_cast<Reader *>(pUserData)->Read(pBufferOut, bytesToRead);
+        }
+
+        drmp3_bool32 SeekCallback(void *pUserData, int offset, drmp3_seek_origin origin) {
+            auto reader = static_cast<Reader *>(pUserData);
+
+            s64 new_offset = offset;
+            if (origin == DRMP3_SEEK_CUR) {
+                new_offset += reader->offset;
+            } else if (origin == DRMP3_SEEK_END) {
+                new_offset += reader->size;
+            }
+
+            if (new_offset < 0 || new_offset > reader->size) {
+                return false;
+            }
+
+            reader->offset = new_offset;
+            return true;
+        }
+
+        drmp3_bool32 TellCallback(void *pUserData, drmp3_int64 *pCursor) {
+            *pCursor = static_cast<Reader *>(pUserData)->offset;
+            return true;
+        }
+
+        void Save(const Key &key, const Index &index) {
+            sdmc::CreateFolder("/config");
+            sdmc::CreateFolder("/config/sys-tune");
+            sdmc::CreateFolder(CACHE_DIR);
+
+            char path[FS_MAX_PATH];
+            GetCachePath(key, path, sizeof(path));
+
+            const IndexHeader header{
+                .magic = INDEX_MAGIC,
+                .version = INDEX_VERSION,
+                .key = key,
+                .total_pcm_frames = index.total_pcm_frames,
+                .seek_point_count = index.seek_point_count,
+                .reserved = 0,
+            };
+            const auto points_size = index.seek_point_count * sizeof(drmp3_seek_point);
+
+            sdmc::DeleteFile(path);
+            if (R_FAILED(sdmc::CreateFile(path, sizeof(header) + points_size))) {
+                return;
+            }
+
+            FsFile file;
+            if (R_FAILED(sdmc::OpenFile(&file, path, FsOpenMode_Write))) {
+                return;
+            }
+
+            if (R_FAILED(fsFileWrite(&file, 0, &header, sizeof(header), FsWriteOption_None)) ||
+                R_FAILED(fsFileWrite(&file, sizeof(header), index.seek_points.get(), points_size, FsWriteOption_Flush))) {
+                fsFileClose(&file);
+                sdmc::DeleteFile(path);
+                return;
+            }
+
+            fsFileClose(&file);
+        }
+
+    }
+
+    bool MakeKey(const char *path, s64 size, Key *out) {
+        u64 modified;
+        if (R_FAILED(sdmc::GetModifiedTime(path, &modified))) {
+            return false;
+        }
+
+        out->path_hash = sdmc::HashPath(path);
+        out->size = size;
+        out->modified = modified;
+        return true;
+    }
+
+    std::shared_ptr<Index> Load(const Key &key) {
+        char path[FS_MAX_PATH];
+        GetCachePath(key, path, sizeof(path));
+
+        FsFile file;
+        if (R_FAILED(sdmc::OpenFile(&file, path))) {
+            return nullptr;
+        }
+
+        IndexHeader header;
+        u64 bytes_read = 0;
+        bool ok = R_SUCCEEDED(fsFileRead(&file, 0, &header, sizeof(header), 0, &bytes_read)) && bytes_read == sizeof(header);
+        ok = ok && header.magic == INDEX_MAGIC && header.version == INDEX_VERSION;
+        ok = ok && !std::memcmp(&header.key, &key, sizeof(key));
+        ok = ok && header.seek_point_count && header.seek_point_count <= SEEK_POINT_MAX;
+
+        auto out = std::make_shared<Index>();
+        if (ok) {
+            const auto points_size = header.seek_point_count * sizeof(drmp3_seek_point);
+            out->seek_points = std::make_unique<drmp3_seek_point[]>(header.seek_point_count);
+            ok = R_SUCCEEDED(fsFileRead(&file, sizeof(header), out->seek_points.get(), points_size, 0, &bytes_read)) && bytes_read == points_size;
+        }
+
+        fsFileClose(&file);
+
+        if (!ok) {
+            return nullptr;
+        }
+
+        out->total_pcm_frames = header.total_pcm_frames;
+        out->seek_point_count = header.seek_point_count;
+        return out;
+    }
+
+    std::shared_ptr<Index> TakeBuilt(const Key &key) {
+        std::shared_ptr<Index> out;
+        std::scoped_lock lk(g_built_mutex);
+        if (g_built && !std::memcmp(&g_built_key, &key, sizeof(key))) {
+            out.swap(g_built);
+        }
+        return out;
+    }
+
+    u32 GetGeneration() {
+        return g_generation;
+    }
+
+    void Build(const char *path) {
+        auto reader = std::make_unique<Reader>();
+        if (R_FAILED(sdmc::OpenFile(&reader->file, path))) {
+            return;
+        }
+
+        Key key;
+        auto mp3 = std::make_unique<drmp3>();
+        auto index = std::make_shared<Index>();
+        index->seek_points = std::make_unique<drmp3_seek_point[]>(SEEK_POINT_MAX);
+        index->seek_point_count = SEEK_POINT_MAX;
+
+        if (R_SUCCEEDED(fsFileGetSize(&reader->file, &reader->size)) && MakeKey(path, reader->size, &key)) {
+            reader->key = sdmc::MakeFileKey(path, reader->size);
+            if (drmp3_init(mp3.get(), ReadCallback, SeekCallback, TellCallback, nullptr, reader.get(), nullptr)) {
+                // one walk over the frame headers gives both the seek points and the length.
+                drmp3_uint64 total_pcm_frames = 0;
+                const bool ok = drmp3_calculate_seek_points_and_pcm_frame_count(mp3.get(), &index->seek_point_count, index->seek_points.get(), &total_pcm_frames);
+                index->total_pcm_frames = total_pcm_frames;
+
+                // a cancelled scan looks like a short file, don't cache that.
+                if (ok && !background::ShouldStop()) {
+                    Save(key, *index);
+
+                    // replaces one nobody took, so at most one index waits here.
+                    std::scoped_lock lk(g_built_mutex);
+                    g_built_key = key;
+                    g_built.swap(index);
+                    g_generation++;
+                }
+
+                drmp3_uninit(mp3.get());
+            }
+        }
+
+        fsFileClose(&reader->file);
+    }
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <switch.h>
+#include <memory>
+#include "dr_mp3.h"
+
+// mp3 has no index of its own, so seeking decodes forward from the start of the file.
+// the index is built once by the background thread and cached on the sd card.
+namespace tune::impl::mp3_index {
+
+    // a seek point every ~15s on a two hour mix, so a seek decodes at most that far.
+    constexpr u32 SEEK_POINT_MAX = 512;
+
+    struct Key {
+        u64 path_hash;
+        s64 size;
+        u64 modified;
+
+        bool IsValid() const {
+            return path_hash != 0;
+        }
+    };
+
+    struct Index {
+        u64 total_pcm_frames;
+        u32 seek_point_count;
+        std::unique_ptr<drmp3_seek_point[]> seek_points;
+    };
+
+    bool MakeKey(const char *path, s64 size, Key *out);
+    // reads the cached index from the sd card, nullptr if there is none for key.
+    std::shared_ptr<Index> Load(const Key &key);
+    // hands over the index Build() last made if it is for key. touches no file, so the
+    // decode thread can pick up an index that finished while the track was playing.
+    std::shared_ptr<Index> TakeBuilt(const Key &key);
+    // bumped every time an index is built, so open tracks know when to retry TakeBuilt().
+    u32 GetGeneration();
+
+    // background task, scans the whole file and writes the index to the cache.
+    void Build(const char *path);
+
+}
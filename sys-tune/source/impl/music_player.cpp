@@ -7,9 +7,13 @@
 #include "aud_wrapper.h"
 #include "config/config.hpp"
 #include "source.hpp"
+#include "pcm_cache.hpp"
 #include "resamplers/SDL_audioEX.h"
 
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
+#include <malloc.h>
 #include <nxExt.h>
 
 namespace tune::impl {
@@ -224,6 +228,7 @@ namespace tune::impl {
 
         RepeatMode g_repeat   = RepeatMode::All;
         ShuffleMode g_shuffle = ShuffleMode::Off;
+        ResamplerQuality g_resampler_quality = ResamplerQuality::Sinc;
         PlayerStatus g_status = PlayerStatus::FetchNext;
         Source *g_source = nullptr;
 
@@ -233,81 +238,395 @@ namespace tune::impl {
 
         constexpr auto AUDIO_FREQ          = 48000;
         constexpr auto AUDIO_CHANNEL_COUNT = 2;
-        constexpr auto AUDIO_BUFFER_COUNT  = 2;
         constexpr auto AUDIO_LATENCY_MS    = 42;
         constexpr auto AUDIO_BUFFER_SIZE   = AUDIO_FREQ / 1000 * AUDIO_LATENCY_MS * AUDIO_CHANNEL_COUNT;
-
-        AudioOutBuffer g_audout_buffer[AUDIO_BUFFER_COUNT];
-        alignas(0x1000) s16 AudioMemoryPool[AUDIO_BUFFER_COUNT][(AUDIO_BUFFER_SIZE + 0xFFF) & ~0xFFF];
+        // amount of blocks appended to audout at once, the rest waits decoded in the ring.
+        constexpr auto AUDIO_BUFFERS_IN_FLIGHT = 2;
+        // the ring size is read from the config, this is the upper bound (~500ms).
+        constexpr auto AUDIO_BUFFER_COUNT_MAX  = 12;
+        constexpr auto AUDIO_BUFFER_COUNT_MIN  = AUDIO_BUFFERS_IN_FLIGHT + 1;
+
+        AudioOutBuffer g_audout_buffer[AUDIO_BUFFER_COUNT_MAX];
+        alignas(0x1000) u8 AudioMemoryPool[AUDIO_BUFFER_COUNT_MAX][(AUDIO_BUFFER_SIZE * sizeof(s16) + 0xFFF) & ~0xFFF];
         static_assert((sizeof(AudioMemoryPool[0]) % 0x2000) == 0, "Audio Memory pool needs to be page aligned!");
 
+        // single producer (tune thread), single consumer (audio thread) ring of audout blocks.
+        // the producer decodes straight into AudioMemoryPool and the consumer hands the
+        // very same block to audout, so nothing is copied between the two stages.
+        class BlockRing {
+        public:
+            void Init(u32 count) {
+                m_count = count;
+                m_write = m_submit = m_release = 0;
+                m_flush = NO_FLUSH;
+                for (auto& e : m_queued) {
+                    e = false;
+                }
+            }
+
+            u32 Count() const {
+                return m_count;
+            }
+
+            // blocks that are decoded but not yet played out.
+            u32 Buffered() const {
+                return m_write.load(std::memory_order_relaxed) - m_release.load(std::memory_order_relaxed);
+            }
+
+            // [producer] next free block or nullptr if the ring is full.
+            AudioOutBuffer* AcquireWrite() {
+                const auto write = m_write.load(std::memory_order_relaxed);
+                if (write - m_release.load(std::memory_order_acquire) >= m_count) {
+                    return nullptr;
+                }
+
+                return &g_audout_buffer[write % m_count];
+            }
+
+            // [producer] publish the block returned by AcquireWrite.
+            void CommitWrite() {
+                m_write.store(m_write.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+
+            // [producer] drop everything that was decoded so far but not yet handed to audout.
+            void Flush() {
+                m_flush.store(m_write.load(std::memory_order_relaxed), std::memory_order_release);
+            }
+
+            // [consumer] apply a pending flush from the producer.
+            void ApplyFlush() {
+                const auto flush = m_flush.exchange(NO_FLUSH, std::memory_order_acquire);
+                if (flush == NO_FLUSH || flush <= m_submit) {
+                    return;
+                }
+
+                // skipped blocks were never queued, so they are free as soon as release reaches them.
+                for (auto i = m_submit; i < flush; i++) {
+                    m_queued[i % m_count] = false;
+                }
+                m_submit = flush;
+                AdvanceRelease();
+            }
+
+            u32 InFlight() const {
+                u32 count = 0;
+                for (auto i = m_release.load(std::memory_order_relaxed); i < m_submit; i++) {
+                    count += m_queued[i % m_count];
+                }
+                return count;
+            }
+
+            // [consumer] next decoded block or nullptr if the producer hasn't caught up.
+            AudioOutBuffer* AcquireSubmit() {
+                if (m_submit >= m_write.load(std::memory_order_acquire)) {
+                    return nullptr;
+                }
+
+                return &g_audout_buffer[m_submit % m_count];
+            }
+
+            // [consumer] mark the block returned by AcquireSubmit as queued in audout.
+            void CommitSubmit() {
+                m_queued[m_submit % m_count] = true;
+                m_submit++;
+            }
+
+            // [consumer] audout is done with this block.
+            void Release(const AudioOutBuffer* buffer) {
+                m_queued[buffer - g_audout_buffer] = false;
+                AdvanceRelease();
+            }
+
+        private:
+            void AdvanceRelease() {
+                auto release = m_release.load(std::memory_order_relaxed);
+                while (release < m_submit && !m_queued[release % m_count]) {
+                    release++;
+                }
+                m_release.store(release, std::memory_order_release);
+            }
+
+        private:
+            static constexpr u64 NO_FLUSH = UINT64_MAX;
+
+            u32 m_count{AUDIO_BUFFER_COUNT_MIN};
+            std::atomic<u64> m_write{};
+            std::atomic<u64> m_release{};
+            std::atomic<u64> m_flush{NO_FLUSH};
+            // consumer only.
+            u64 m_submit{};
+            bool m_queued[AUDIO_BUFFER_COUNT_MAX]{};
+        };
+
+        BlockRing g_ring;
+
+        // seek requests are handled by the tune thread so it can flush the ring afterwards.
+        constexpr u32 NO_SEEK = UINT32_MAX;
+        std::atomic<u32> g_seek_target{NO_SEEK};
+
         bool g_should_pause      = false;
         bool g_should_run        = true;
 
-        Result PlayTrack(const char* path) {
-            /* Open file and allocate */
+        // paused this long, the tune thread suspends until playback resumes.
+        constexpr u64 SUSPEND_DELAY_NS = 1'000'000'000ul;
+        // set by the tune thread, the audio thread stops audout once nothing is in flight.
+        std::atomic<bool> g_suspended{false};
+
+        // the next track is picked this long before the current one ends.
+        constexpr auto PREROLL_SECONDS = 5;
+        constexpr auto AUDIO_BLOCK_BYTES = AUDIO_BUFFER_SIZE * sizeof(s16);
+
+        struct FreeDeleter {
+            void operator()(void* p) const {
+                std::free(p);
+            }
+        };
+
+        // the first blocks of a prerolled track, copied into the ring before its source is read again.
+        struct PrerollBlocks {
+            std::unique_ptr<u8[], FreeDeleter> data;
+            u32 size[AUDIO_BUFFER_COUNT_MAX];
+            u32 count;
+        };
+
+        // next track, opened and with a ring's worth of blocks decoded ahead of time. owned by
+        // the tune thread, which only works on it in steps while the ring is full.
+        struct Preroll {
+            PlaylistID id;
+            char path[PATH_SIZE_MAX];
+            std::unique_ptr<Source> source;
+            PrerollBlocks blocks;
+            bool opened;
+            // nothing left to do, the blocks are full, the track ended or the open failed.
+            bool finished;
+
+            bool Matches(const PlaylistID& entry, const char* entry_path) const {
+                return source && id.id == entry.id && entry_path && !std::strcmp(path, entry_path);
+            }
+
+            void Reset() {
+                id.Reset();
+                source.reset();
+                blocks = {};
+                opened = finished = false;
+            }
+        } g_preroll;
+
+        bool IsLastInQueue() {
+            std::scoped_lock lk(g_mutex);
+
+            return g_queue_position + 1 >= g_playlist.Size();
+        }
+
+        // the entry Next() will move to once the current track ends, mirrors its repeat handling.
+        PlaylistID PeekNext(char* path, size_t path_size) {
+            std::scoped_lock lk(g_mutex);
+
+            const auto size = g_playlist.Size();
+            PlaylistID entry;
+            if (!size) {
+                return entry;
+            }
+
+            if (g_repeat == RepeatMode::One) {
+                entry = g_playlist.Get(g_queue_position, g_shuffle);
+            } else if (g_queue_position + 1 < size) {
+                entry = g_playlist.Get(g_queue_position + 1, g_shuffle);
+            } else if (g_repeat == RepeatMode::All) {
+                entry = g_playlist.Get(0, g_shuffle);
+            }
+
+            if (const auto entry_path = g_playlist.GetPath(entry)) {
+                std::snprintf(path, path_size, "%s", entry_path);
+            } else {
+                entry.Reset();
+            }
+
+            return entry;
+        }
+
+        // same order as SDL_ResamplerQualityEX.
+        SDL_ResamplerQualityEX GetSdlResamplerQuality() {
+            return static_cast<SDL_ResamplerQualityEX>(g_resampler_quality);
+        }
+
+        std::unique_ptr<Source> OpenTrack(const char* path) {
             auto source = OpenFile(path);
-            R_UNLESS(source != nullptr, tune::FileOpenFailure);
-            R_UNLESS(source->IsOpen(), tune::FileOpenFailure);
-            R_UNLESS(source->SetupResampler(audoutGetChannelCount(), audoutGetSampleRate()), tune::VoiceInitFailure);
+            if (!source || !source->IsOpen() || !source->SetupResampler(audoutGetChannelCount(), audoutGetSampleRate(), GetSdlResamplerQuality())) {
+                return nullptr;
+            }
 
-            AudioOutState state;
-            R_TRY(audoutGetAudioOutState(&state));
-            if (state == AudioOutState_Stopped) {
-                R_TRY(audoutStartAudioOut());
+            return source;
+        }
+
+        // only picks the entry, opening and decoding it is left to PrerollStep().
+        void PrerollNext() {
+            g_preroll.Reset();
+            g_preroll.id = PeekNext(g_preroll.path, sizeof(g_preroll.path));
+            // a single entry on repeat-all comes round to itself, it's opened again when it starts.
+            if (g_preroll.id.id == g_current.id) {
+                g_preroll.Reset();
             }
+        }
+
+        // opens the next track or decodes one of its blocks. only called while the ring is
+        // full, so a slow open or decode is covered by the blocks that are already queued.
+        // returns false once there is nothing left to do.
+        bool PrerollStep() {
+            auto& preroll = g_preroll;
+            if (!preroll.id.IsValid() || preroll.finished) {
+                return false;
+            }
+
+            if (!preroll.opened) {
+                // failures are left for PlayTrack to report, so the entry gets removed there.
+                preroll.opened = true;
+                preroll.source = OpenTrack(preroll.path);
+                if (preroll.source) {
+                    preroll.blocks.data.reset(static_cast<u8*>(std::malloc(g_ring.Count() * AUDIO_BLOCK_BYTES)));
+                }
+                preroll.finished = !preroll.blocks.data;
+                return true;
+            }
+
+            auto& blocks = preroll.blocks;
+            const auto got = preroll.source->Resample(blocks.data.get() + blocks.count * AUDIO_BLOCK_BYTES, AUDIO_BLOCK_BYTES);
+            if (got > 0) {
+                blocks.size[blocks.count++] = got;
+            }
+
+            // a short block is the end of the track.
+            preroll.finished = got < s64(AUDIO_BLOCK_BYTES) || blocks.count >= g_ring.Count();
+            return true;
+        }
+
+        // drops the read-ahead window and the next track. the open source and the blocks
+        // already decoded into the ring are kept, so output restarts as soon as the pause ends.
+        void Suspend(Source* source) {
+            source->Suspend();
+            g_preroll.Reset();
+            g_suspended = true;
+
+            while (g_should_run && g_status == PlayerStatus::Playing && g_should_pause && g_seek_target == NO_SEEK) {
+                svcSleepThread(10'000'000ul);
+            }
+
+            g_suspended = false;
+            source->Resume();
+        }
+
+        Result PlayTrack(const char* path) {
+            /* Take over the prerolled source or open file and allocate */
+            std::unique_ptr<Source> source;
+            PrerollBlocks blocks{};
+            if (g_preroll.Matches(g_current, path)) {
+                source = std::move(g_preroll.source);
+                if (g_preroll.blocks.count) {
+                    blocks = std::move(g_preroll.blocks);
+                }
+            } else {
+                source = OpenFile(path);
+                R_UNLESS(source != nullptr, tune::FileOpenFailure);
+                R_UNLESS(source->IsOpen(), tune::FileOpenFailure);
+                R_UNLESS(source->SetupResampler(audoutGetChannelCount(), audoutGetSampleRate(), GetSdlResamplerQuality()), tune::VoiceInitFailure);
+            }
+            g_preroll.Reset();
 
             g_source = source.get();
 
-            // for the first buffer, use very small buffer sizes to reduce latency between songs.
-            int first = 1;
+            if (source->GetSampleRate() != pcm_cache::SAMPLE_RATE) {
+                pcm_cache::Request(path);
+            }
 
+            const u64 preroll_frames = u64(source->GetSampleRate()) * PREROLL_SECONDS;
+            u32 block_next = 0;
+            bool prerolled = false;
+            bool finished = false;
+            u64 paused_tick = 0;
             while (g_should_run && g_status == PlayerStatus::Playing) {
-                if (g_should_pause) {
-                    svcSleepThread(17'000'000);
-                    continue;
+                if (const auto target = g_seek_target.exchange(NO_SEEK); target != NO_SEEK) {
+                    source->Seek(target);
+                    g_ring.Flush();
+                    blocks = {};
+                    block_next = 0;
                 }
 
-                AudioOutBuffer* buffer = NULL;
-                for (int i = 0; i < AUDIO_BUFFER_COUNT; i++) {
-                    bool has_buffer = false;
-                    R_TRY(audoutContainsAudioOutBuffer(&g_audout_buffer[i], &has_buffer));
-                    if (!has_buffer) {
-                        buffer = &g_audout_buffer[i];
-                        break;
+                // the ring is full, let it drain to half before decoding the next batch.
+                AudioOutBuffer* buffer = g_ring.AcquireWrite();
+                if (!buffer) {
+                    while (g_should_run && g_status == PlayerStatus::Playing && g_seek_target == NO_SEEK && g_ring.Buffered() > g_ring.Count() / 2) {
+                        // nothing drains while paused, stay like this for long and it suspends.
+                        if (!g_should_pause) {
+                            paused_tick = 0;
+                        } else if (!paused_tick) {
+                            paused_tick = armGetSystemTick();
+                        } else if (armTicksToNs(armGetSystemTick() - paused_tick) >= SUSPEND_DELAY_NS) {
+                            Suspend(source.get());
+                            paused_tick = 0;
+                            prerolled = false;
+                            continue;
+                        }
+                        // use the slack on the next track before sleeping.
+                        if (prerolled && PrerollStep()) {
+                            continue;
+                        }
+                        svcSleepThread(AUDIO_LATENCY_MS * 1'000'000ul);
                     }
+                    continue;
                 }
 
-                if (!buffer) {
-                    u32 released_count;
-                    R_TRY(audoutWaitPlayFinish(&buffer, &released_count, UINT64_MAX));
+                s64 nSamples;
+                if (block_next < blocks.count) {
+                    // decoded while the previous track played, the source carries on after it.
+                    nSamples = blocks.size[block_next];
+                    std::memcpy(buffer->buffer, blocks.data.get() + block_next * AUDIO_BLOCK_BYTES, nSamples);
+                    if (++block_next == blocks.count) {
+                        blocks = {};
+                        block_next = 0;
+                    }
+                } else {
+                    // repeat-one wraps inside the source, so the decoder and resampler stay warm.
+                    source->SetRepeat(g_repeat == RepeatMode::One);
+                    nSamples = source->Resample((u8*)buffer->buffer, AUDIO_BLOCK_BYTES);
+                }
+                if (nSamples > 0) {
+                    buffer->data_size = nSamples;
+                    buffer->data_offset = 0;
+                    g_ring.CommitWrite();
                 }
 
-                bool error = false;
-                if (buffer) {
-                    auto buffer_size = AUDIO_BUFFER_SIZE * sizeof(s16);
-                    if (first) {
-                        first--;
-                        buffer_size = std::min(512 * sizeof(s16), buffer_size);
+                // open the next track during the last seconds so it starts right after this one.
+                // nothing is held for it while the current track still has loops to play.
+                if (!prerolled && g_repeat != RepeatMode::One && !source->WillWrap()) {
+                    const auto [current, total] = source->Tell();
+                    if (current + preroll_frames >= total) {
+                        prerolled = true;
+                        PrerollNext();
                     }
+                }
 
-                    const auto nSamples = source->Resample((u8*)buffer->buffer, buffer_size);
-                    if (nSamples <= 0) {
-                        error = true;
-                    } else {
-                        buffer->data_size = nSamples;
-                        R_TRY(audoutAppendAudioOutBuffer(buffer));
+                if (!blocks.count && (nSamples <= 0 || source->Done())) {
+                    // let the tail play out before Next() pauses at the end of the queue.
+                    if (g_repeat == RepeatMode::Off && IsLastInQueue()) {
+                        while (g_should_run && g_status == PlayerStatus::Playing && g_ring.Buffered()) {
+                            svcSleepThread(AUDIO_LATENCY_MS * 1'000'000ul);
+                        }
                     }
-                }
 
-                if (error || source->Done()) {
                     if (g_repeat != RepeatMode::One) {
                         Next();
                     }
+                    finished = true;
                     break;
                 }
             }
 
+            // on track change, drop what was decoded ahead of the old track.
+            if (!finished) {
+                g_ring.Flush();
+                g_preroll.Reset();
+            }
+
             g_source = nullptr;
 
             return 0;
@@ -316,11 +635,19 @@ namespace tune::impl {
     }
 
     Result Initialize() {
-        for (int i = 0; i < AUDIO_BUFFER_COUNT; i++) {
+        for (int i = 0; i < AUDIO_BUFFER_COUNT_MAX; i++) {
             g_audout_buffer[i].buffer = AudioMemoryPool[i];
             g_audout_buffer[i].buffer_size = sizeof(AudioMemoryPool[i]);
         }
 
+        const auto buffer_count = config::get_buffer_ms() / AUDIO_LATENCY_MS;
+        g_ring.Init(std::clamp(buffer_count, AUDIO_BUFFER_COUNT_MIN, AUDIO_BUFFER_COUNT_MAX));
+        SetPreloadSizeMax(s64(std::max(config::get_preload_kib(), 0)) * 1024);
+        SetParallelDecode(config::get_parallel_decode());
+        SetDither(config::get_dither());
+        SetStreamLoops(std::max(config::get_stream_loops(), 0));
+        pcm_cache::SetSizeMax(s64(std::max(config::get_pcm_cache_mib(), 0)) * 1024 * 1024);
+
         R_TRY(audoutInitialize());
         SetVolume(config::get_volume());
 
@@ -330,6 +657,9 @@ namespace tune::impl {
         }
 
         SetShuffleMode(static_cast<ShuffleMode>(config::get_shuffle()));
+        if (auto c = config::get_resampler_quality(); c <= 3 && c >= 0) {
+            g_resampler_quality = static_cast<ResamplerQuality>(c);
+        }
         SetDefaultTitleVolume(config::get_default_title_volume());
 
         // reserves memory so that we don't allocate later on.
@@ -422,8 +752,59 @@ namespace tune::impl {
                 Remove(g_queue_position);
             }
         }
+    }
+
+    void AudioThreadFunc(void *) {
+        audoutStartAudioOut();
+        bool stopped = false;
+
+        while (g_should_run) {
+            g_ring.ApplyFlush();
+
+            /* Resumed, the tune thread may still be catching up but the ring is ready. */
+            if (stopped && (!g_suspended || !g_should_pause)) {
+                audoutStartAudioOut();
+                stopped = false;
+            }
+
+            /* Keep a few blocks queued, everything else stays decoded in the ring. */
+            if (!g_should_pause) {
+                while (g_ring.InFlight() < AUDIO_BUFFERS_IN_FLIGHT) {
+                    AudioOutBuffer* buffer = g_ring.AcquireSubmit();
+                    if (!buffer || R_FAILED(audoutAppendAudioOutBuffer(buffer))) {
+                        break;
+                    }
+                    g_ring.CommitSubmit();
+                }
+            }
+
+            /* Nothing queued, either paused or the decoder fell behind. */
+            if (!g_ring.InFlight()) {
+                /* Suspended, audout has nothing left to play so it is stopped as well. */
+                if (!stopped && g_suspended && g_should_pause) {
+                    audoutStopAudioOut();
+                    stopped = true;
+                }
+                svcSleepThread(5'000'000);
+                continue;
+            }
+
+            AudioOutBuffer* released = nullptr;
+            u32 released_count = 0;
+            if (R_SUCCEEDED(audoutWaitPlayFinish(&released, &released_count, AUDIO_LATENCY_MS * 1'000'000ul))) {
+                while (released && released_count) {
+                    g_ring.Release(released);
+                    released = nullptr;
+                    if (R_FAILED(audoutGetReleasedAudioOutBuffer(&released, &released_count))) {
+                        break;
+                    }
+                }
+            }
+        }
 
-        audoutStopAudioOut();
+        if (!stopped) {
+            audoutStopAudioOut();
+        }
         audoutExit();
     }
 
@@ -458,6 +839,7 @@ namespace tune::impl {
             u64 pid{}, new_tid{};
             if (pm::PollCurrentPidTid(&pid, &new_tid)) {
                 g_title_volume = 1.f;
+                pcm_cache::SetIdle(pm::IsHomeMenu(new_tid));
 
                 if (config::has_title_volume(new_tid)) {
                     g_use_title_volume = true;
@@ -569,6 +951,20 @@ namespace tune::impl {
         g_repeat = mode;
     }
 
+    ResamplerQuality GetResamplerQuality() {
+        return g_resampler_quality;
+    }
+
+    void SetResamplerQuality(ResamplerQuality quality) {
+        if (quality > ResamplerQuality::Sinc) {
+            return;
+        }
+
+        // only tracks opened from now on use it, the playing one keeps its stream.
+        g_resampler_quality = quality;
+        config::set_resampler_quality(static_cast<int>(quality));
+    }
+
     ShuffleMode GetShuffleMode() {
         return g_shuffle;
     }
@@ -617,6 +1013,10 @@ namespace tune::impl {
         auto [current, total] = g_source->Tell();
         int sample_rate       = g_source->GetSampleRate();
 
+        // the decoder runs ahead of what can be heard by the amount buffered in the ring.
+        const u64 buffered = u64(g_ring.Buffered()) * (AUDIO_BUFFER_SIZE / AUDIO_CHANNEL_COUNT) * sample_rate / AUDIO_FREQ;
+        current = current > buffered ? current - buffered : 0;
+
         out->sample_rate   = sample_rate;
         out->current_frame = current;
         out->total_frames  = total;
@@ -664,7 +1064,7 @@ namespace tune::impl {
 
     void Seek(u32 position) {
         if (g_source != nullptr && g_source->IsOpen())
-            g_source->Seek(position);
+            g_seek_target = position;
     }
 
     Result Enqueue(const char *buffer, size_t buffer_length, EnqueueType type) {
@@ -690,6 +1090,27 @@ namespace tune::impl {
         return 0;
     }
 
+    Result Probe(const char *buffer, size_t buffer_length, ProbeInfo *out) {
+        char path[PATH_SIZE_MAX];
+        R_UNLESS(buffer_length < sizeof(path), tune::InvalidPath);
+        std::memcpy(path, buffer, buffer_length);
+        path[buffer_length] = '\0';
+
+        ::ProbeInfo info;
+        R_UNLESS(::Probe(path, &info), tune::FileOpenFailure);
+
+        *out = {};
+        out->codec           = static_cast<u32>(info.type);
+        out->sample_rate     = info.sample_rate;
+        out->channels        = info.channels;
+        out->bits_per_sample = info.bits_per_sample;
+        out->total_frames    = info.total_frames;
+        out->bitrate_kbps    = info.bitrate_kbps;
+        out->total_estimated = info.total_estimated;
+
+        return 0;
+    }
+
     Result Remove(u32 index) {
         std::scoped_lock lk(g_mutex);
 
@@ -714,4 +1135,25 @@ namespace tune::impl {
         return 0;
     }
 
+    void GetIoStats(IoStats *out) {
+        *out = {};
+        out->memory_used = ReadAhead::GetMemoryUsed();
+        sdmc::GetCacheStats(&out->cache_hits, &out->cache_misses);
+
+        if (const auto source = g_source) {
+            const auto &read_ahead = source->GetReadAhead();
+            out->window_size    = read_ahead.GetWindowSize();
+            out->latency_us     = read_ahead.GetLatency();
+            out->throughput_kib = read_ahead.GetThroughput();
+        }
+    }
+
+    void GetMemoryStats(MemoryStats *out) {
+        *out = {};
+        out->arena_size       = Arena::SIZE;
+        out->arena_high_water = Arena::GetHighWater();
+        out->arena_fallback   = Arena::GetFallbackBytes();
+        out->heap_used        = mallinfo().uordblks;
+    }
+
 }
@@ -10,6 +10,7 @@ namespace tune::impl {
     void Exit();
 
     void TuneThreadFunc(void *);
+    void AudioThreadFunc(void *);
     void GpioThreadFunc(void *);
     void PmdmntThreadFunc(void *);
 
@@ -35,6 +36,8 @@ namespace tune::impl {
     void SetRepeatMode(RepeatMode mode);
     ShuffleMode GetShuffleMode();
     void SetShuffleMode(ShuffleMode mode);
+    ResamplerQuality GetResamplerQuality();
+    void SetResamplerQuality(ResamplerQuality quality);
 
     u32 GetPlaylistSize();
     u32 GetPlaylistItem(u32 index, char* buffer, size_t buffer_size);
@@ -46,5 +49,9 @@ namespace tune::impl {
 
     Result Enqueue(const char* buffer, size_t buffer_length, EnqueueType type);
     Result Remove(u32 index);
+    Result Probe(const char* buffer, size_t buffer_length, ProbeInfo *out);
+
+    void GetIoStats(IoStats *out);
+    void GetMemoryStats(MemoryStats *out);
 
 }
@@ -0,0 +1,410 @@
+#ifdef WANT_BFSTM
+
+#include "nw_stream.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+namespace tune::impl::nw_stream {
+
+    namespace {
+
+        // the info block, or the head chunk on brstm, is read whole.
+        constexpr u32 INFO_SIZE_MAX = 1024 * 16;
+
+        constexpr u16 FSTM_INFO_BLOCK = 0x4000;
+        constexpr u16 FSTM_SEEK_BLOCK = 0x4001;
+        constexpr u16 FSTM_DATA_BLOCK = 0x4002;
+
+        // every read is bounds checked, a short or broken header reads as zeros.
+        struct View {
+            const u8 *data;
+            u32 size;
+            bool big_endian;
+
+            bool Has(u32 offset, u32 length) const {
+                return offset <= size && length <= size - offset;
+            }
+
+            u8 U8(u32 offset) const {
+                return Has(offset, 1) ? data[offset] : 0;
+            }
+
+            u16 U16(u32 offset) const {
+                if (!Has(offset, 2)) {
+                    return 0;
+                }
+                const auto p = data + offset;
+                return big_endian ? (p[0] << 8 | p[1]) : (p[1] << 8 | p[0]);
+            }
+
+            u32 U32(u32 offset) const {
+                if (!Has(offset, 4)) {
+                    return 0;
+                }
+                const auto p = data + offset;
+                return big_endian ? (u32(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3]) : (u32(p[3]) << 24 | p[2] << 16 | p[1] << 8 | p[0]);
+            }
+        };
+
+        // the adpcm info is the same on every format, brstm has a gain field before the context.
+        bool ReadChannel(const View &v, u32 offset, u32 context, Channel *out) {
+            if (!v.Has(offset, context + 12)) {
+                return false;
+            }
+
+            for (u32 i = 0; i < 16; i++) {
+                out->coefs[i] = s16(v.U16(offset + i * 2));
+            }
+            out->hist1      = s16(v.U16(offset + context + 2));
+            out->hist2      = s16(v.U16(offset + context + 4));
+            out->loop_hist1 = s16(v.U16(offset + context + 8));
+            out->loop_hist2 = s16(v.U16(offset + context + 10));
+            return true;
+        }
+
+        // codec, loop and block layout, the same fields on every format from the codec byte on.
+        void ReadStreamInfo(const View &v, u32 s, bool fstm, StreamInfo *out) {
+            out->codec                  = Codec(v.U8(s + 0x00));
+            out->loop                   = v.U8(s + 0x01) != 0;
+            out->channels               = v.U8(s + 0x02);
+            out->sample_rate            = fstm ? v.U32(s + 0x04) : v.U16(s + 0x04);
+            out->loop_start             = v.U32(s + 0x08);
+            out->total_samples          = v.U32(s + 0x0C);
+            const u32 layout            = fstm ? s + 0x10 : s + 0x14;
+            out->block_count            = v.U32(layout + 0x00);
+            out->block_size             = v.U32(layout + 0x04);
+            out->block_samples          = v.U32(layout + 0x08);
+            out->last_block_size        = v.U32(layout + 0x0C);
+            out->last_block_samples     = v.U32(layout + 0x10);
+            out->last_block_padded_size = v.U32(layout + 0x14);
+        }
+
+        u8 *ReadBlock(ReadFunc read, void *user, s64 offset, u32 size) {
+            if (!size || size > INFO_SIZE_MAX) {
+                return nullptr;
+            }
+
+            auto block = static_cast<u8 *>(std::malloc(size));
+            if (block && !read(user, offset, block, size)) {
+                std::free(block);
+                return nullptr;
+            }
+            return block;
+        }
+
+        // bfstm and bcstm, blocks are found through the section table in the file header.
+        bool ParseFstm(ReadFunc read, void *user, const View &header, StreamInfo *out) {
+            s64 info_offset = 0, seek_offset = 0, data_offset = 0;
+            u32 info_size = 0;
+
+            const u32 sections = std::min<u32>(header.U16(0x10), 8);
+            for (u32 i = 0; i < sections; i++) {
+                const u32 ref = 0x14 + i * 12;
+                switch (header.U16(ref)) {
+                    case FSTM_INFO_BLOCK: info_offset = header.U32(ref + 4); info_size = header.U32(ref + 8); break;
+                    case FSTM_SEEK_BLOCK: seek_offset = header.U32(ref + 4); break;
+                    case FSTM_DATA_BLOCK: data_offset = header.U32(ref + 4); break;
+                }
+            }
+
+            if (!info_offset || !data_offset) {
+                return false;
+            }
+
+            const auto info = ReadBlock(read, user, info_offset, info_size);
+            if (!info) {
+                return false;
+            }
+
+            // references inside the info block are relative to the end of its header.
+            const View v{info, info_size, header.big_endian};
+            const u32 stream = 8 + v.U32(0x0C);
+            const u32 table = 8 + v.U32(0x1C);
+            ReadStreamInfo(v, stream, true, out);
+            out->data_offset = data_offset + 8 + v.U32(stream + 0x34);
+            out->seek_offset = seek_offset ? seek_offset + 8 : 0;
+
+            bool ok = v.U32(table) >= out->channels;
+            for (u32 c = 0; ok && c < std::min(out->channels, CHANNELS_MAX); c++) {
+                const u32 channel = table + v.U32(table + 4 + c * 8 + 4);
+                ok = ReadChannel(v, channel + v.U32(channel + 4), 0x20, &out->channel[c]);
+            }
+
+            std::free(info);
+            return ok;
+        }
+
+        // brstm, the head chunk holds three references: stream info, tracks and channels.
+        bool ParseRstm(ReadFunc read, void *user, const View &header, StreamInfo *out) {
+            const s64 head_offset = header.U32(0x10);
+            const u32 head_size = header.U32(0x14);
+            const s64 adpc_offset = header.U32(0x18);
+
+            const auto head = ReadBlock(read, user, head_offset, head_size);
+            if (!head) {
+                return false;
+            }
+
+            const View v{head, head_size, header.big_endian};
+            const u32 stream = 8 + v.U32(0x0C);
+            const u32 table = 8 + v.U32(0x1C);
+            ReadStreamInfo(v, stream, false, out);
+            out->data_offset = v.U32(stream + 0x10);
+            // only usable when there is one history entry per block.
+            out->seek_offset = adpc_offset && v.U32(stream + 0x2C) == out->block_samples ? adpc_offset + 8 : 0;
+
+            bool ok = v.U8(table) >= out->channels;
+            for (u32 c = 0; ok && c < std::min(out->channels, CHANNELS_MAX); c++) {
+                const u32 channel = 8 + v.U32(table + 4 + c * 8 + 4);
+                ok = ReadChannel(v, 8 + v.U32(channel + 4), 0x22, &out->channel[c]);
+            }
+
+            std::free(head);
+            return ok;
+        }
+
+    }
+
+    bool Probe(const u8 *data, size_t size) {
+        if (size < 6) {
+            return false;
+        }
+
+        const bool magic = !std::memcmp(data, "FSTM", 4) || !std::memcmp(data, "CSTM", 4) || !std::memcmp(data, "RSTM", 4);
+        const bool bom = (data[4] == 0xFE && data[5] == 0xFF) || (data[4] == 0xFF && data[5] == 0xFE);
+        return magic && bom;
+    }
+
+    bool ParseHeader(ReadFunc read, void *user, s64 file_size, StreamInfo *out) {
+        u8 data[0x14 + 8 * 12];
+        if (file_size < s64(sizeof(data)) || !read(user, 0, data, sizeof(data)) || !Probe(data, sizeof(data))) {
+            return false;
+        }
+
+        *out = {};
+        out->big_endian = data[4] == 0xFE;
+        const View header{data, sizeof(data), out->big_endian};
+        if (!(std::memcmp(data, "RSTM", 4) ? ParseFstm(read, user, header, out) : ParseRstm(read, user, header, out))) {
+            return false;
+        }
+
+        if (out->codec > Codec::DspAdpcm || !out->channels || !out->sample_rate || !out->total_samples) {
+            return false;
+        }
+
+        if (!out->block_count || !out->block_samples || !out->block_size || out->block_size > BLOCK_SIZE_MAX ||
+            out->last_block_size > out->block_size || out->last_block_padded_size < out->last_block_size) {
+            return false;
+        }
+
+        if (out->loop && out->loop_start >= out->total_samples) {
+            out->loop = false;
+        }
+
+        return out->data_offset > 0 && out->data_offset < file_size;
+    }
+
+    void DecodeDspFrame(const u8 *frame, const s16 *coefs, s16 *hist1, s16 *hist2, s16 *out, u32 stride, u32 first, u32 count) {
+        const s32 scale = 1 << (frame[0] & 0xF);
+        const u32 predictor = (frame[0] >> 4) & 0x7;
+        const s32 coef1 = coefs[predictor * 2 + 0];
+        const s32 coef2 = coefs[predictor * 2 + 1];
+
+        // the nibbles are expanded up front, that part has no dependency between
+        // samples and vectorizes. the filter after it needs the previous two outputs.
+        s32 delta[DSP_FRAME_SAMPLES];
+        for (u32 i = 0; i < DSP_FRAME_SAMPLES; i++) {
+            const u32 byte = frame[1 + i / 2];
+            const s32 nibble = (i & 1) ? (byte & 0xF) : (byte >> 4);
+            delta[i] = ((((nibble ^ 8) - 8) * scale) << 11) + 1024;
+        }
+
+        s32 h1 = *hist1;
+        s32 h2 = *hist2;
+        for (u32 i = first; i < first + count; i++) {
+            const s32 sample = std::clamp((delta[i] + coef1 * h1 + coef2 * h2) >> 11, -0x8000, 0x7FFF);
+            h2 = h1;
+            h1 = sample;
+            *out = sample;
+            out += stride;
+        }
+
+        *hist1 = h1;
+        *hist2 = h2;
+    }
+
+    Decoder::~Decoder() {
+        std::free(m_block);
+    }
+
+    bool Decoder::Open(ReadFunc read, void *user, s64 file_size) {
+        m_read = read;
+        m_user = user;
+        if (!ParseHeader(read, user, file_size, &m_info)) {
+            return false;
+        }
+
+        m_channels = std::min(m_info.channels, CHANNELS_MAX);
+        m_block = static_cast<u8 *>(std::malloc(m_info.block_size * m_channels));
+        if (!m_block) {
+            return false;
+        }
+
+        for (u32 c = 0; c < m_channels; c++) {
+            m_hist1[c] = m_info.channel[c].hist1;
+            m_hist2[c] = m_info.channel[c].hist2;
+        }
+        return true;
+    }
+
+    u64 Decoder::Decode(s16 *out, u64 frames) {
+        u64 done = 0;
+
+        while (done < frames && m_position < m_info.total_samples) {
+            const u32 block = m_position / m_info.block_samples;
+            if (!LoadBlock(block)) {
+                break;
+            }
+
+            const u32 block_samples = IsLastBlock(block) ? m_info.last_block_samples : m_info.block_samples;
+            const u32 first = m_position - u64(block) * m_info.block_samples;
+            if (first >= block_samples) {
+                break;
+            }
+
+            const auto count = std::min<u64>({frames - done, block_samples - first, m_info.total_samples - m_position});
+            DecodeBlock(first, count, out + done * m_channels);
+            m_position += count;
+            done += count;
+        }
+
+        return done;
+    }
+
+    bool Decoder::Seek(u64 target) {
+        target = std::min<u64>(target, m_info.total_samples);
+
+        if (m_info.codec != Codec::DspAdpcm) {
+            m_position = target;
+            return true;
+        }
+
+        // the stream stores the decoder state at its loop start, so wrapping needs no decoding.
+        if (m_info.loop && target == m_info.loop_start && target % DSP_FRAME_SAMPLES == 0) {
+            for (u32 c = 0; c < m_channels; c++) {
+                m_hist1[c] = m_info.channel[c].loop_hist1;
+                m_hist2[c] = m_info.channel[c].loop_hist2;
+            }
+            m_position = target;
+            return true;
+        }
+
+        // start from the closest block with a known history and decode up to the target.
+        auto block = std::min<u32>(target / m_info.block_samples, m_info.block_count - 1);
+        if (!LoadHistory(block)) {
+            block = 0;
+            LoadHistory(block);
+        }
+        m_position = u64(block) * m_info.block_samples;
+
+        s16 scratch[DSP_FRAME_SAMPLES * CHANNELS_MAX * 16];
+        while (m_position < target) {
+            if (!Decode(scratch, std::min<u64>(target - m_position, std::size(scratch) / m_channels))) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool Decoder::IsLastBlock(u32 block) const {
+        return block + 1 == m_info.block_count;
+    }
+
+    bool Decoder::LoadBlock(u32 block) {
+        if (block == m_block_index) {
+            return true;
+        }
+
+        if (block >= m_info.block_count) {
+            return false;
+        }
+
+        const u32 size = IsLastBlock(block) ? m_info.last_block_size : m_info.block_size;
+        const u32 stride = IsLastBlock(block) ? m_info.last_block_padded_size : m_info.block_size;
+        const s64 offset = m_info.data_offset + s64(block) * m_info.block_size * m_info.channels;
+
+        for (u32 c = 0; c < m_channels; c++) {
+            const auto dst = m_block + c * m_info.block_size;
+            if (!m_read(m_user, offset + c * stride, dst, size)) {
+                m_block_index = UINT32_MAX;
+                return false;
+            }
+            std::memset(dst + size, 0, m_info.block_size - size);
+        }
+
+        m_block_index = block;
+        return true;
+    }
+
+    bool Decoder::LoadHistory(u32 block) {
+        if (!block) {
+            for (u32 c = 0; c < m_channels; c++) {
+                m_hist1[c] = m_info.channel[c].hist1;
+                m_hist2[c] = m_info.channel[c].hist2;
+            }
+            return true;
+        }
+
+        u8 entry[4 * CHANNELS_MAX];
+        const auto offset = m_info.seek_offset + s64(block) * m_info.channels * 4;
+        if (!m_info.seek_offset || !m_read(m_user, offset, entry, m_channels * 4)) {
+            return false;
+        }
+
+        const View v{entry, sizeof(entry), m_info.big_endian};
+        for (u32 c = 0; c < m_channels; c++) {
+            m_hist1[c] = s16(v.U16(c * 4 + 0));
+            m_hist2[c] = s16(v.U16(c * 4 + 2));
+        }
+        return true;
+    }
+
+    void Decoder::DecodeBlock(u32 first, u32 count, s16 *out) {
+        for (u32 c = 0; c < m_channels; c++) {
+            const auto src = m_block + c * m_info.block_size;
+            auto dst = out + c;
+
+            switch (m_info.codec) {
+                case Codec::DspAdpcm:
+                    for (u32 sample = first, left = count; left;) {
+                        const u32 frame = sample / DSP_FRAME_SAMPLES;
+                        const u32 offset = sample % DSP_FRAME_SAMPLES;
+                        const u32 n = std::min(DSP_FRAME_SAMPLES - offset, left);
+                        DecodeDspFrame(src + frame * DSP_FRAME_SIZE, m_info.channel[c].coefs, &m_hist1[c], &m_hist2[c], dst, m_channels, offset, n);
+                        dst += n * m_channels;
+                        sample += n;
+                        left -= n;
+                    }
+                    break;
+                case Codec::Pcm16:
+                    for (u32 i = 0; i < count; i++) {
+                        const auto p = src + (first + i) * 2;
+                        dst[i * m_channels] = m_info.big_endian ? (p[0] << 8 | p[1]) : (p[1] << 8 | p[0]);
+                    }
+                    break;
+                case Codec::Pcm8:
+                    for (u32 i = 0; i < count; i++) {
+                        dst[i * m_channels] = s8(src[first + i]) << 8;
+                    }
+                    break;
+            }
+        }
+    }
+
+}
+
+#endif
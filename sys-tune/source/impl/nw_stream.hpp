@@ -0,0 +1,109 @@
+#pragma once
+
+#include <switch.h>
+
+// nintendoware streams, bfstm (wii u, switch), bcstm (3ds) and brstm (wii).
+// audio is stored in blocks, each block holds a run of every channel in turn.
+namespace tune::impl::nw_stream {
+
+    // only the first track is decoded, the rest are usually alternate mixes.
+    constexpr u32 CHANNELS_MAX = 2;
+    constexpr u32 BLOCK_SIZE_MAX = 1024 * 64;
+    // a dsp-adpcm frame is a header byte and 14 nibbles.
+    constexpr u32 DSP_FRAME_SIZE = 8;
+    constexpr u32 DSP_FRAME_SAMPLES = 14;
+
+    enum class Codec : u8 {
+        Pcm8,
+        Pcm16,
+        DspAdpcm,
+    };
+
+    struct Channel {
+        s16 coefs[16];
+        s16 hist1;
+        s16 hist2;
+        // decoder state at the loop start, lets the wrap skip decoding up to it.
+        s16 loop_hist1;
+        s16 loop_hist2;
+    };
+
+    struct StreamInfo {
+        Codec codec;
+        bool big_endian;
+        bool loop;
+        u32 channels;
+        u32 sample_rate;
+        u32 loop_start;
+        u32 total_samples;
+        u32 block_count;
+        u32 block_size;
+        u32 block_samples;
+        u32 last_block_size;
+        u32 last_block_samples;
+        u32 last_block_padded_size;
+        // first block, from the start of the file.
+        s64 data_offset;
+        // adpcm history at the start of every block, 0 if the file has none.
+        s64 seek_offset;
+        Channel channel[CHANNELS_MAX];
+    };
+
+    using ReadFunc = bool (*)(void *user, s64 offset, void *buffer, u64 size);
+
+    bool Probe(const u8 *data, size_t size);
+    bool ParseHeader(ReadFunc read, void *user, s64 file_size, StreamInfo *out);
+
+    // decodes count samples of one frame starting at first, every stride'th sample of out.
+    // hist1/hist2 carry the filter state from one call to the next.
+    void DecodeDspFrame(const u8 *frame, const s16 *coefs, s16 *hist1, s16 *hist2, s16 *out, u32 stride, u32 first, u32 count);
+
+    // interleaved s16 out of a stream, reading one block at a time through read.
+    class Decoder {
+      private:
+        ReadFunc m_read{};
+        void *m_user{};
+        StreamInfo m_info{};
+        u32 m_channels{};
+        // compressed data of the current block, one run per decoded channel.
+        u8 *m_block{};
+        u32 m_block_index{UINT32_MAX};
+        u64 m_position{};
+        s16 m_hist1[CHANNELS_MAX]{};
+        s16 m_hist2[CHANNELS_MAX]{};
+
+      public:
+        Decoder() = default;
+        ~Decoder();
+
+        Decoder(const Decoder &) = delete;
+        Decoder &operator=(const Decoder &) = delete;
+
+        bool Open(ReadFunc read, void *user, s64 file_size);
+
+        const StreamInfo &GetInfo() const {
+            return m_info;
+        }
+
+        // at most CHANNELS_MAX, the rest of the stream is skipped.
+        u32 GetChannelCount() const {
+            return m_channels;
+        }
+
+        u64 GetPosition() const {
+            return m_position;
+        }
+
+        // returns the number of frames written, short only at the end of the stream.
+        u64 Decode(s16 *out, u64 frames);
+        bool Seek(u64 target);
+
+      private:
+        bool IsLastBlock(u32 block) const;
+        bool LoadBlock(u32 block);
+        // adpcm history at the start of a block, from the seek table.
+        bool LoadHistory(u32 block);
+        void DecodeBlock(u32 first, u32 count, s16 *out);
+    };
+
+}
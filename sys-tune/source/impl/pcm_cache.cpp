@@ -0,0 +1,511 @@
+#include "pcm_cache.hpp"
+#include "background.hpp"
+#include "source.hpp"
+#include "sdmc/sdmc.hpp"
+
+#include <nxExt.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace tune::impl::pcm_cache {
+
+    namespace {
+
+        constexpr u32 CACHE_MAGIC = 0x4D435054; // "TPCM"
+        constexpr u32 CACHE_VERSION = 2;
+        constexpr const char CACHE_DIR[]{"/config/sys-tune/cache"};
+        constexpr auto PENDING_MAX = 8;
+        // entries kept on the card, the least recently played goes when a new one doesn't fit.
+        constexpr u32 INDEX_SIZE_MAX = 128;
+        constexpr auto PATH_SIZE_MAX = 256;
+        // rendered and written in blocks of this size.
+        constexpr size_t WRITE_SIZE = 1024 * 16;
+
+        struct Header {
+            u32 magic;
+            u32 version;
+            Key key;
+            // 0 until the whole track was written.
+            u64 total_frames;
+            u64 loop_start;
+            u64 loop_end;
+            u32 has_loop;
+            u32 loop_count;
+            // bumped whenever the entry is played, the lowest is evicted first.
+            u64 last_used;
+        };
+        static_assert(sizeof(Header) <= DATA_OFFSET);
+
+        // what the card holds, read once by the background thread so nothing else scans it.
+        struct IndexEntry {
+            Key key;
+            // bytes on the card, header included.
+            s64 size;
+            u64 last_used;
+            // played since the stamp in the header was written.
+            bool dirty;
+        };
+
+        enum class RenderResult {
+            Done,
+            Failed,
+            // the home menu was left, the track stays pending.
+            Interrupted,
+        };
+
+        LockableMutex g_mutex;
+        char g_pending[PENDING_MAX][PATH_SIZE_MAX];
+        u32 g_pending_count = 0;
+
+        // guards the index, never held across sd card access.
+        LockableMutex g_index_mutex;
+        IndexEntry g_index[INDEX_SIZE_MAX];
+        u32 g_index_count = 0;
+        s64 g_index_used = 0;
+        u64 g_clock = 0;
+        std::atomic<bool> g_index_loaded{};
+
+        std::atomic<s64> g_size_max{};
+        std::atomic<bool> g_idle{};
+
+        void GetCachePath(u64 path_hash, char *out, size_t size) {
+            std::snprintf(out, size, "%s/%016lX.pcm", CACHE_DIR, path_hash);
+        }
+
+        bool MakeKey(const char *path, Key *out) {
+            FsFile file;
+            if (R_FAILED(sdmc::OpenFile(&file, path))) {
+                return false;
+            }
+
+            s64 size = 0;
+            const auto rc = fsFileGetSize(&file, &size);
+            fsFileClose(&file);
+
+            u64 modified;
+            if (R_FAILED(rc) || R_FAILED(sdmc::GetModifiedTime(path, &modified))) {
+                return false;
+            }
+
+            out->path_hash = sdmc::HashPath(path);
+            out->size = size;
+            out->modified = modified;
+            return true;
+        }
+
+        bool ReadHeader(FsFile *file, Header *out) {
+            u64 bytes_read = 0;
+            return R_SUCCEEDED(fsFileRead(file, 0, out, sizeof(*out), 0, &bytes_read)) && bytes_read == sizeof(*out) &&
+                   out->magic == CACHE_MAGIC && out->version == CACHE_VERSION;
+        }
+
+        // complete entry for this exact version of the file.
+        bool ReadEntry(FsFile *file, const Key &key, Header *out) {
+            return ReadHeader(file, out) && !std::memcmp(&out->key, &key, sizeof(key)) && out->total_frames;
+        }
+
+        IndexEntry *FindEntry(u64 path_hash) {
+            for (u32 i = 0; i < g_index_count; i++) {
+                if (g_index[i].key.path_hash == path_hash) {
+                    return &g_index[i];
+                }
+            }
+            return nullptr;
+        }
+
+        void RemoveEntry(u64 path_hash) {
+            if (const auto entry = FindEntry(path_hash)) {
+                g_index_used -= entry->size;
+                *entry = g_index[--g_index_count];
+            }
+        }
+
+        // the caller made room, a full index only happens when the card had more than fits.
+        bool AddEntry(const IndexEntry &entry) {
+            RemoveEntry(entry.key.path_hash);
+            if (g_index_count >= INDEX_SIZE_MAX) {
+                return false;
+            }
+
+            g_index[g_index_count++] = entry;
+            g_index_used += entry.size;
+            g_clock = std::max(g_clock, entry.last_used);
+            return true;
+        }
+
+        // entries that can't be read, like one left by a crash mid render, are deleted.
+        void LoadIndex(const char *) {
+            if (g_index_loaded) {
+                return;
+            }
+
+            FsDir dir;
+            if (R_SUCCEEDED(sdmc::OpenDir(&dir, CACHE_DIR, FsDirOpenMode_ReadFiles))) {
+                FsDirectoryEntry entry;
+                s64 total;
+                char path[FS_MAX_PATH];
+                while (R_SUCCEEDED(fsDirRead(&dir, &total, 1, &entry)) && total) {
+                    const auto len = std::strlen(entry.name);
+                    if (len < 4 || std::strcmp(entry.name + len - 4, ".pcm")) {
+                        continue;
+                    }
+
+                    std::snprintf(path, sizeof(path), "%s/%s", CACHE_DIR, entry.name);
+
+                    Header header;
+                    bool complete = false;
+                    FsFile file;
+                    if (R_SUCCEEDED(sdmc::OpenFile(&file, path))) {
+                        complete = ReadHeader(&file, &header) && header.total_frames;
+                        fsFileClose(&file);
+                    }
+
+                    // a file that isn't named after its own key would never be found again.
+                    bool added = false;
+                    if (char expected[FS_MAX_PATH]; complete) {
+                        GetCachePath(header.key.path_hash, expected, sizeof(expected));
+                        std::scoped_lock lk(g_index_mutex);
+                        added = !std::strcmp(path, expected) && AddEntry({header.key, entry.file_size, header.last_used, false});
+                    }
+
+                    if (!added) {
+                        sdmc::DeleteFile(path);
+                    }
+                }
+
+                fsDirClose(&dir);
+            }
+
+            g_index_loaded = true;
+        }
+
+        // plays are only counted in memory on the tune thread, they reach the card from here.
+        void SaveStamps(const char *) {
+            struct Stamp {
+                u64 path_hash;
+                u64 last_used;
+            } stamps[INDEX_SIZE_MAX];
+            u32 count = 0;
+
+            {
+                std::scoped_lock lk(g_index_mutex);
+
+                for (u32 i = 0; i < g_index_count; i++) {
+                    if (g_index[i].dirty) {
+                        g_index[i].dirty = false;
+                        stamps[count++] = {g_index[i].key.path_hash, g_index[i].last_used};
+                    }
+                }
+            }
+
+            // the entry that is playing can't be opened for writing, it is tried again next time.
+            char path[FS_MAX_PATH];
+            for (u32 i = 0; i < count; i++) {
+                GetCachePath(stamps[i].path_hash, path, sizeof(path));
+                FsFile file;
+                bool saved = false;
+                if (R_SUCCEEDED(sdmc::OpenFile(&file, path, FsOpenMode_Write))) {
+                    saved = R_SUCCEEDED(fsFileWrite(&file, offsetof(Header, last_used), &stamps[i].last_used, sizeof(stamps[i].last_used), FsWriteOption_None));
+                    fsFileClose(&file);
+                }
+
+                if (!saved) {
+                    std::scoped_lock lk(g_index_mutex);
+                    if (const auto entry = FindEntry(stamps[i].path_hash)) {
+                        entry->dirty = true;
+                    }
+                }
+            }
+        }
+
+        // evicts least recently played first, sorted once instead of searched for each entry.
+        bool MakeRoom(s64 size) {
+            u64 victims[INDEX_SIZE_MAX];
+            u32 victim_count = 0;
+
+            {
+                std::scoped_lock lk(g_index_mutex);
+
+                u8 order[INDEX_SIZE_MAX];
+                for (u32 i = 0; i < g_index_count; i++) {
+                    order[i] = i;
+                }
+                std::sort(order, order + g_index_count, [](u8 a, u8 b) { return g_index[a].last_used < g_index[b].last_used; });
+
+                s64 used = g_index_used;
+                for (u32 i = 0; i < g_index_count && (used + size > g_size_max || g_index_count - victim_count >= INDEX_SIZE_MAX); i++) {
+                    used -= g_index[order[i]].size;
+                    victims[victim_count++] = g_index[order[i]].key.path_hash;
+                }
+            }
+
+            // the entry that is playing can't be deleted, it stays and the render waits for next time.
+            char path[FS_MAX_PATH];
+            for (u32 i = 0; i < victim_count; i++) {
+                GetCachePath(victims[i], path, sizeof(path));
+                if (R_SUCCEEDED(sdmc::DeleteFile(path))) {
+                    std::scoped_lock lk(g_index_mutex);
+                    RemoveEntry(victims[i]);
+                }
+            }
+
+            std::scoped_lock lk(g_index_mutex);
+            return g_index_used + size <= g_size_max && g_index_count < INDEX_SIZE_MAX;
+        }
+
+        void RemovePending(const char *path) {
+            std::scoped_lock lk(g_mutex);
+
+            for (u32 i = 0; i < g_pending_count; i++) {
+                if (!std::strcmp(g_pending[i], path)) {
+                    std::memmove(g_pending[i], g_pending[i + 1], (--g_pending_count - i) * PATH_SIZE_MAX);
+                    return;
+                }
+            }
+        }
+
+        bool ShouldInterrupt() {
+            return !g_idle || !g_size_max || background::ShouldStop();
+        }
+
+        RenderResult Render(const char *path, const Key &key, const char *cache_path) {
+            auto source = OpenFile(path);
+            if (!source || !source->IsOpen()) {
+                return RenderResult::Failed;
+            }
+
+            // only resampling is worth a copy, a channel map costs nothing at play time.
+            const u64 sample_rate = source->GetSampleRate();
+            if (sample_rate == SAMPLE_RATE) {
+                return RenderResult::Failed;
+            }
+
+            const auto [current, total] = source->Tell();
+            // nothing else is running, so the copy always gets the best filter.
+            if (!total || !source->SetupResampler(CHANNELS, SAMPLE_RATE, SDL_RESAMPLER_SINC)) {
+                return RenderResult::Failed;
+            }
+
+            // a second on top for the resampler tail and estimated lengths.
+            const s64 size = DATA_OFFSET + (u64(total) * SAMPLE_RATE / sample_rate + SAMPLE_RATE) * FRAME_SIZE;
+            if (size > g_size_max) {
+                return RenderResult::Failed;
+            }
+
+            // the loop is stored instead of rendered, so repeat and loops still work on the copy.
+            Header header{
+                .magic = CACHE_MAGIC,
+                .version = CACHE_VERSION,
+                .key = key,
+            };
+            if (u64 loop_start, loop_end; source->TakeLoopPoints(&loop_start, &loop_end, &header.loop_count)) {
+                header.has_loop = true;
+                header.loop_start = loop_start * SAMPLE_RATE / sample_rate;
+                header.loop_end = loop_end * SAMPLE_RATE / sample_rate;
+            }
+
+            sdmc::CreateFolder("/config");
+            sdmc::CreateFolder("/config/sys-tune");
+            sdmc::CreateFolder(CACHE_DIR);
+
+            {
+                std::scoped_lock lk(g_index_mutex);
+                RemoveEntry(key.path_hash);
+            }
+            sdmc::DeleteFile(cache_path);
+            if (!MakeRoom(size) || R_FAILED(sdmc::CreateFile(cache_path, 0))) {
+                return RenderResult::Failed;
+            }
+
+            FsFile file;
+            if (R_FAILED(sdmc::OpenFile(&file, cache_path, FsOpenMode_Write | FsOpenMode_Append))) {
+                sdmc::DeleteFile(cache_path);
+                return RenderResult::Failed;
+            }
+
+            const u8 blank[DATA_OFFSET]{};
+            auto result = R_SUCCEEDED(fsFileWrite(&file, 0, blank, sizeof(blank), FsWriteOption_None)) ? RenderResult::Done : RenderResult::Failed;
+
+            const auto buffer = std::make_unique<u8[]>(WRITE_SIZE);
+            s64 offset = DATA_OFFSET;
+            while (result == RenderResult::Done) {
+                if (ShouldInterrupt()) {
+                    result = RenderResult::Interrupted;
+                    break;
+                }
+
+                const auto got = source->Resample(buffer.get(), WRITE_SIZE);
+                if (got <= 0) {
+                    result = got < 0 ? RenderResult::Failed : RenderResult::Done;
+                    break;
+                }
+
+                if (offset + got > size || R_FAILED(fsFileWrite(&file, offset, buffer.get(), got, FsWriteOption_None))) {
+                    result = RenderResult::Failed;
+                    break;
+                }
+                offset += got;
+            }
+
+            // the header goes in last, a partial file never looks complete.
+            if (result == RenderResult::Done) {
+                header.total_frames = (offset - DATA_OFFSET) / FRAME_SIZE;
+                {
+                    std::scoped_lock lk(g_index_mutex);
+                    header.last_used = ++g_clock;
+                }
+                if (!header.total_frames || R_FAILED(fsFileWrite(&file, 0, &header, sizeof(header), FsWriteOption_Flush))) {
+                    result = RenderResult::Failed;
+                }
+            }
+
+            fsFileClose(&file);
+            if (result == RenderResult::Done) {
+                std::scoped_lock lk(g_index_mutex);
+                if (!AddEntry({key, offset, header.last_used, false})) {
+                    result = RenderResult::Failed;
+                }
+            }
+            if (result != RenderResult::Done) {
+                sdmc::DeleteFile(cache_path);
+            }
+
+            return result;
+        }
+
+    }
+
+    void SetSizeMax(s64 size) {
+        g_size_max = size;
+        if (size) {
+            background::Post(LoadIndex, "");
+        }
+    }
+
+    void SetIdle(bool idle) {
+        g_idle = idle;
+        if (!idle) {
+            return;
+        }
+
+        background::Post(SaveStamps, "");
+
+        std::scoped_lock lk(g_mutex);
+
+        // the background queue is short, whatever doesn't fit is posted again next time.
+        for (u32 i = 0; i < g_pending_count; i++) {
+            background::Post(Build, g_pending[i]);
+        }
+    }
+
+    bool Open(const char *path, FsFile *out, char *cache_path, size_t cache_path_size, Entry *entry) {
+        if (!g_size_max || !g_index_loaded) {
+            return false;
+        }
+
+        // tracks that were never rendered don't touch the card here.
+        Key key;
+        {
+            std::scoped_lock lk(g_index_mutex);
+            const auto found = FindEntry(sdmc::HashPath(path));
+            if (!found) {
+                return false;
+            }
+            key = found->key;
+        }
+
+        Key current;
+        if (!MakeKey(path, &current) || std::memcmp(&current, &key, sizeof(key))) {
+            return false;
+        }
+
+        GetCachePath(key.path_hash, cache_path, cache_path_size);
+        if (R_FAILED(sdmc::OpenFile(out, cache_path))) {
+            return false;
+        }
+
+        Header header;
+        if (!ReadEntry(out, key, &header)) {
+            fsFileClose(out);
+            return false;
+        }
+
+        {
+            std::scoped_lock lk(g_index_mutex);
+            if (const auto found = FindEntry(key.path_hash)) {
+                found->last_used = ++g_clock;
+                found->dirty = true;
+            }
+        }
+
+        entry->total_frames = header.total_frames;
+        entry->has_loop = header.has_loop;
+        entry->loop_start = header.loop_start;
+        entry->loop_end = header.loop_end;
+        entry->loop_count = header.loop_count;
+        return true;
+    }
+
+    void Request(const char *path) {
+        if (!g_size_max || std::strlen(path) >= PATH_SIZE_MAX) {
+            return;
+        }
+
+        {
+            std::scoped_lock lk(g_mutex);
+
+            bool found = false;
+            for (u32 i = 0; i < g_pending_count; i++) {
+                found |= !std::strcmp(g_pending[i], path);
+            }
+
+            if (!found) {
+                if (g_pending_count >= PENDING_MAX) {
+                    return;
+                }
+                std::strcpy(g_pending[g_pending_count++], path);
+            }
+        }
+
+        if (g_idle) {
+            background::Post(Build, path);
+        }
+    }
+
+    void Build(const char *path) {
+        if (ShouldInterrupt()) {
+            return;
+        }
+
+        LoadIndex("");
+
+        Key key;
+        if (!MakeKey(path, &key)) {
+            RemovePending(path);
+            return;
+        }
+
+        bool cached;
+        {
+            std::scoped_lock lk(g_index_mutex);
+            const auto found = FindEntry(key.path_hash);
+            cached = found && !std::memcmp(&found->key, &key, sizeof(key));
+        }
+        if (cached) {
+            RemovePending(path);
+            return;
+        }
+
+        char cache_path[FS_MAX_PATH];
+        GetCachePath(key.path_hash, cache_path, sizeof(cache_path));
+
+        if (Render(path, key, cache_path) != RenderResult::Interrupted) {
+            RemovePending(path);
+        }
+    }
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <switch.h>
+
+// tracks that need resampling are rendered once to raw pcm at the output format,
+// so playing them again is a plain read into the audio buffers. rendering only
+// happens from the background thread while the home menu is in front. the index of
+// what is on the card is loaded there too, playback only ever looks it up in memory.
+namespace tune::impl::pcm_cache {
+
+    constexpr u32 SAMPLE_RATE = 48000;
+    constexpr u32 CHANNELS = 2;
+    constexpr u32 FRAME_SIZE = CHANNELS * sizeof(s16);
+    // the samples start after the header, at the same offset in every entry.
+    constexpr s64 DATA_OFFSET = 0x80;
+
+    struct Key {
+        u64 path_hash;
+        s64 size;
+        u64 modified;
+    };
+
+    struct Entry {
+        u64 total_frames;
+        bool has_loop;
+        // in frames at SAMPLE_RATE, loop_end is 0 when the loop runs to the end.
+        u64 loop_start;
+        u64 loop_end;
+        u32 loop_count;
+    };
+
+    // total size of the cache on the sd card, 0 disables it.
+    void SetSizeMax(s64 size);
+    // renders only run while this is set, anything cut short is retried next time.
+    void SetIdle(bool idle);
+
+    // opens the rendered copy of path, if there is one for the file as it is now. nothing is
+    // written, the play is recorded in memory and saved on the next idle period.
+    bool Open(const char *path, FsFile *out, char *cache_path, size_t cache_path_size, Entry *entry);
+    // remembers path for the next idle period.
+    void Request(const char *path);
+
+    // background task, renders the track and evicts the least recently played entries to fit.
+    void Build(const char *path);
+
+}
@@ -0,0 +1,384 @@
+#include "read_ahead.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+    using Block = ReadAhead::Block;
+    using State = ReadAhead::State;
+
+    // libnx mutex and condvar are valid zero initialised.
+    Mutex g_mutex;
+    CondVar g_request_cv;
+    CondVar g_done_cv;
+    Block *g_queue_head = nullptr;
+    Block *g_queue_tail = nullptr;
+    bool g_should_run = true;
+
+    std::atomic<s64> g_memory_used{};
+
+    constexpr s64 AlignBlockSize(s64 size) {
+        return (size + 0xFFF) & ~0xFFF;
+    }
+
+    void Enqueue(Block *block) {
+        mutexLock(&g_mutex);
+
+        if (g_should_run) {
+            block->state = State::Queued;
+            block->next  = nullptr;
+            if (g_queue_tail) {
+                g_queue_tail->next = block;
+            } else {
+                g_queue_head = block;
+            }
+            g_queue_tail = block;
+            condvarWakeOne(&g_request_cv);
+        }
+
+        mutexUnlock(&g_mutex);
+    }
+
+    // takes a queued block back out, or waits for the io thread if it is already reading it.
+    void Drop(Block *block) {
+        mutexLock(&g_mutex);
+
+        if (block->state == State::Queued) {
+            Block *prev = nullptr;
+            for (auto it = g_queue_head; it; prev = it, it = it->next) {
+                if (it == block) {
+                    (prev ? prev->next : g_queue_head) = it->next;
+                    if (g_queue_tail == block) {
+                        g_queue_tail = prev;
+                    }
+                    break;
+                }
+            }
+            block->state = State::Idle;
+        }
+
+        while (block->state == State::Reading) {
+            condvarWait(&g_done_cv, &g_mutex);
+        }
+
+        mutexUnlock(&g_mutex);
+    }
+
+    void Wait(Block *block) {
+        if (block->state == State::Ready || block->state == State::Idle) {
+            return;
+        }
+
+        mutexLock(&g_mutex);
+        while (block->state == State::Queued || block->state == State::Reading) {
+            condvarWait(&g_done_cv, &g_mutex);
+        }
+        mutexUnlock(&g_mutex);
+    }
+
+}
+
+ReadAhead::ReadAhead(FsFile *file, const sdmc::FileKey &key) : m_file(file), m_key(key), m_file_size(key.size) {
+    for (auto &block : m_blocks) {
+        block.owner = this;
+        block.off   = 0;
+        block.size  = 0;
+        block.state = State::Idle;
+        block.next  = nullptr;
+        block.data  = nullptr;
+    }
+
+    Resize(BLOCK_SIZE_DEFAULT);
+}
+
+ReadAhead::~ReadAhead() {
+    Cancel();
+    Resize(0);
+}
+
+size_t ReadAhead::Read(s64 offset, void *buffer, size_t read_size) {
+    auto dst = static_cast<u8 *>(buffer);
+    size_t amount = 0;
+
+    // re-evaluated every few blocks, only resized when the window is off by a lot.
+    if (m_reads_since_resize >= 8) {
+        m_reads_since_resize = 0;
+        const auto target = GetTargetBlockSize();
+        if (target > m_block_size * 3 / 2 || target < m_block_size / 2) {
+            Resize(target);
+        }
+    }
+
+    while (read_size && offset < m_file_size) {
+        auto block = Find(offset);
+
+        if (!block) {
+            // big reads go straight into dst, caching them would only evict the read-ahead.
+            if (!m_data || s64(read_size) >= m_block_size) {
+                u64 bytes_read = 0;
+                const auto start = armGetSystemTick();
+                if (R_SUCCEEDED(sdmc::ReadFile(m_file, m_key, offset, dst, read_size, &bytes_read))) {
+                    UpdateStats(armTicksToNs(armGetSystemTick() - start), bytes_read);
+                    amount += bytes_read;
+                }
+                break;
+            }
+
+            block = Claim(nullptr);
+            if (!Fill(block, offset)) {
+                break;
+            }
+        }
+
+        Wait(block);
+        // a failed read ahead is retried in place before giving up.
+        if (offset >= block->off + block->size && !Fill(block, offset)) {
+            break;
+        }
+
+        Prefetch(block);
+
+        const auto size = std::min<s64>(read_size, block->off + block->size - offset);
+        std::memcpy(dst, block->data + (offset - block->off), size);
+        dst += size;
+        offset += size;
+        amount += size;
+        read_size -= size;
+    }
+
+    return amount;
+}
+
+void ReadAhead::Seek(s64 offset) {
+    if (Find(offset)) {
+        return;
+    }
+
+    for (auto &block : m_blocks) {
+        if (block.state == State::Queued) {
+            Drop(&block);
+        }
+    }
+}
+
+void ReadAhead::Cancel() {
+    for (auto &block : m_blocks) {
+        Drop(&block);
+        block.state = State::Idle;
+        block.size  = 0;
+    }
+}
+
+void ReadAhead::Release() {
+    Resize(0);
+}
+
+void ReadAhead::Restore() {
+    if (!m_data) {
+        Resize(GetTargetBlockSize());
+    }
+}
+
+void ReadAhead::SetByteRate(u64 byte_rate) {
+    m_byte_rate = byte_rate;
+
+    const auto target = GetTargetBlockSize();
+    if (target != m_block_size) {
+        Resize(target);
+    }
+}
+
+u32 ReadAhead::GetWindowSize() const {
+    return m_data ? m_block_size * BLOCK_COUNT : 0;
+}
+
+u32 ReadAhead::GetLatency() const {
+    return m_latency_us;
+}
+
+u32 ReadAhead::GetThroughput() const {
+    return m_throughput_kib;
+}
+
+u32 ReadAhead::GetMemoryUsed() {
+    return g_memory_used;
+}
+
+bool ReadAhead::ReadBlock(Block *block) {
+    const auto owner = block->owner;
+    u64 bytes_read = 0;
+
+    const auto start = armGetSystemTick();
+    if (R_FAILED(sdmc::ReadFile(owner->m_file, owner->m_key, block->off, block->data, owner->m_block_size, &bytes_read))) {
+        bytes_read = 0;
+    }
+    owner->UpdateStats(armTicksToNs(armGetSystemTick() - start), bytes_read);
+
+    block->size = bytes_read;
+    return bytes_read != 0;
+}
+
+ReadAhead::Block *ReadAhead::Find(s64 offset) {
+    for (auto &block : m_blocks) {
+        const auto state = block.state.load();
+        if (state == State::Idle) {
+            continue;
+        }
+
+        // a block still in flight is assumed to come back full.
+        const auto size = state == State::Ready ? block.size : m_block_size;
+        if (offset >= block.off && offset < block.off + size) {
+            return &block;
+        }
+    }
+
+    return nullptr;
+}
+
+ReadAhead::Block *ReadAhead::Claim(const Block *keep) {
+    for (auto &block : m_blocks) {
+        if (&block != keep && (block.state == State::Idle || block.state == State::Ready)) {
+            return &block;
+        }
+    }
+
+    // every other block is still in flight for an old position.
+    for (auto &block : m_blocks) {
+        if (&block != keep) {
+            Drop(&block);
+            return &block;
+        }
+    }
+
+    return nullptr;
+}
+
+bool ReadAhead::Fill(Block *block, s64 offset) {
+    block->off  = offset;
+    block->size = 0;
+
+    const bool ok = ReadBlock(block);
+    block->state = ok ? State::Ready : State::Idle;
+    m_reads_since_resize++;
+    return ok;
+}
+
+void ReadAhead::Prefetch(const Block *current) {
+    const auto next_off = current->off + m_block_size;
+    if (next_off >= m_file_size || Find(next_off)) {
+        return;
+    }
+
+    if (auto block = Claim(current)) {
+        block->state = State::Idle;
+        block->off   = next_off;
+        block->size  = 0;
+        m_reads_since_resize++;
+        Enqueue(block);
+    }
+}
+
+s64 ReadAhead::GetTargetBlockSize() const {
+    if (!m_byte_rate) {
+        return BLOCK_SIZE_DEFAULT;
+    }
+
+    // hold TARGET_MS of audio, or enough to ride out a few reads at the measured latency.
+    const u64 target_ms = std::max<u64>(TARGET_MS, u64(m_latency_us) * 4 / 1000);
+    const s64 window = m_byte_rate * target_ms / 1000;
+    return std::clamp(AlignBlockSize(window / BLOCK_COUNT), BLOCK_SIZE_MIN, BLOCK_SIZE_MAX);
+}
+
+void ReadAhead::Resize(s64 block_size) {
+    Cancel();
+
+    if (m_data) {
+        std::free(m_data);
+        g_memory_used -= m_block_size * BLOCK_COUNT;
+        m_data = nullptr;
+    }
+
+    m_block_size = block_size;
+    if (!block_size) {
+        return;
+    }
+
+    // shrink to whatever is left of the shared budget, but always keep the minimum.
+    const auto available = MEMORY_MAX - g_memory_used;
+    if (m_block_size * BLOCK_COUNT > available) {
+        m_block_size = std::max(BLOCK_SIZE_MIN, (available / BLOCK_COUNT) & ~0xFFF);
+    }
+
+    m_data = static_cast<u8 *>(std::malloc(m_block_size * BLOCK_COUNT));
+    if (!m_data) {
+        // reads go straight to the file without read-ahead.
+        return;
+    }
+
+    g_memory_used += m_block_size * BLOCK_COUNT;
+    for (u32 i = 0; i < BLOCK_COUNT; i++) {
+        m_blocks[i].data = m_data + i * m_block_size;
+    }
+}
+
+void ReadAhead::UpdateStats(u64 ns, u64 bytes) {
+    if (!ns || !bytes) {
+        return;
+    }
+
+    // moving average over roughly the last 8 reads.
+    const u32 latency_us = ns / 1000;
+    const u32 throughput_kib = bytes * 1'000'000'000 / ns / 1024;
+    const u32 old_latency = m_latency_us;
+    const u32 old_throughput = m_throughput_kib;
+    m_latency_us = old_latency ? (old_latency * 7 + latency_us) / 8 : latency_us;
+    m_throughput_kib = old_throughput ? (old_throughput * 7 + throughput_kib) / 8 : throughput_kib;
+}
+
+namespace tune::impl::read_ahead {
+
+    void ThreadFunc(void *) {
+        mutexLock(&g_mutex);
+
+        while (g_should_run) {
+            if (!g_queue_head) {
+                condvarWait(&g_request_cv, &g_mutex);
+                continue;
+            }
+
+            auto block = g_queue_head;
+            g_queue_head = block->next;
+            if (!g_queue_head) {
+                g_queue_tail = nullptr;
+            }
+            block->state = State::Reading;
+            mutexUnlock(&g_mutex);
+
+            ReadAhead::ReadBlock(block);
+
+            mutexLock(&g_mutex);
+            block->state = State::Ready;
+            condvarWakeAll(&g_done_cv);
+        }
+
+        // nothing will read the rest of the queue, release anyone waiting on it.
+        for (auto block = g_queue_head; block; block = block->next) {
+            block->size  = 0;
+            block->state = State::Ready;
+        }
+        g_queue_head = g_queue_tail = nullptr;
+        condvarWakeAll(&g_done_cv);
+
+        mutexUnlock(&g_mutex);
+    }
+
+    void Exit() {
+        mutexLock(&g_mutex);
+        g_should_run = false;
+        condvarWakeAll(&g_request_cv);
+        mutexUnlock(&g_mutex);
+    }
+
+}
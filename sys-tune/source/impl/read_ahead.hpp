@@ -0,0 +1,91 @@
+#pragma once
+
+#include <switch.h>
+#include <atomic>
+#include "sdmc/sdmc.hpp"
+
+// double buffered file reads, the io thread fills the next block while the
+// decoder consumes the current one.
+class ReadAhead {
+  public:
+    static constexpr u32 BLOCK_COUNT = 2;
+    static constexpr s64 BLOCK_SIZE_MIN = 1024 * 8;
+    static constexpr s64 BLOCK_SIZE_MAX = 1024 * 64;
+    // used until the byte rate of the track is known.
+    static constexpr s64 BLOCK_SIZE_DEFAULT = 1024 * 32;
+    // shared by every open source, the heap has to hold this on top of the decoders.
+    static constexpr s64 MEMORY_MAX = 1024 * 192;
+    // how much compressed audio the window tries to hold.
+    static constexpr u64 TARGET_MS = 1000;
+
+    enum class State : u32 {
+        Idle,
+        Queued,
+        Reading,
+        Ready,
+    };
+
+    struct Block {
+        ReadAhead *owner;
+        s64 off;
+        s64 size;
+        std::atomic<State> state;
+        Block *next;
+        u8 *data;
+    };
+
+  private:
+    FsFile *m_file;
+    sdmc::FileKey m_key;
+    s64 m_file_size;
+    Block m_blocks[BLOCK_COUNT];
+    u8 *m_data{};
+    s64 m_block_size{};
+    u64 m_byte_rate{};
+    u32 m_reads_since_resize{};
+    // updated by whichever thread did the read.
+    std::atomic<u32> m_latency_us{};
+    std::atomic<u32> m_throughput_kib{};
+
+  public:
+    ReadAhead(FsFile *file, const sdmc::FileKey &key);
+    ~ReadAhead();
+
+    // only ever called from the thread that decodes the source.
+    size_t Read(s64 offset, void *buffer, size_t read_size);
+    // drops queued blocks that don't cover offset, blocks already being read are left to finish.
+    void Seek(s64 offset);
+    // drops everything and waits for in flight reads, must be called before the file is closed.
+    void Cancel();
+    // frees the window, for sources that don't read from the file any more.
+    void Release();
+    // brings a released window back at the size it had.
+    void Restore();
+
+    // compressed bytes per second of playback, sizes the window.
+    void SetByteRate(u64 byte_rate);
+
+    u32 GetWindowSize() const;
+    u32 GetLatency() const;
+    u32 GetThroughput() const;
+    static u32 GetMemoryUsed();
+
+    // called by the io thread, or inline on a miss.
+    static bool ReadBlock(Block *block);
+
+  private:
+    Block *Find(s64 offset);
+    Block *Claim(const Block *keep);
+    bool Fill(Block *block, s64 offset);
+    void Prefetch(const Block *current);
+    s64 GetTargetBlockSize() const;
+    void Resize(s64 block_size);
+    void UpdateStats(u64 ns, u64 bytes);
+};
+
+namespace tune::impl::read_ahead {
+
+    void ThreadFunc(void *);
+    void Exit();
+
+}
@@ -2160,6 +2160,378 @@ SDL_ResampleAudio(const int chans, const int inrate, const int outrate,
     return outframes * chans * sizeof (float);
 }
 
+/* Polyphase version of SDL_ResampleAudio() for rates with a small common divisor,
+   44100 -> 48000 repeats every 160 output frames (147:160). Output frame i always
+   starts from source frame (i * inrate) / outrate with the same fractional
+   position, so the weights for each of those phases are worked out once. The
+   SDL_ResamplerQualityEX tiers only differ in how the taps are made. */
+#define RESAMPLER_TAPS ((RESAMPLER_ZERO_CROSSINGS + 1) * 2)
+/* tests/resample_bench builds with 0 to time the generic path. */
+#ifndef RESAMPLER_PHASES_MAX
+#define RESAMPLER_PHASES_MAX 512
+#endif
+/* in floats, fewer taps allow more phases. */
+#define RESAMPLER_TABLE_MAX (RESAMPLER_PHASES_MAX * RESAMPLER_TAPS)
+
+static int
+ResamplerGcd(int a, int b)
+{
+    while (b) {
+        const int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* a multiple of 4 for the simd paths, except linear which is done with scalars anyway. */
+static int
+ResamplerTaps(const SDL_ResamplerQualityEX quality)
+{
+    switch (quality) {
+        case SDL_RESAMPLER_LINEAR: return 2;
+        case SDL_RESAMPLER_CUBIC: return 4;
+        case SDL_RESAMPLER_SINC_SHORT: return 8;
+        default: return RESAMPLER_TAPS;
+    }
+}
+
+/* a Kaiser-sinc as wide as the taps, worked out for the phase rather than read from the
+   SDL_ResampleAudio() table. with few taps the window has to be sharper than the table's
+   80dB one, and the sum of the taps ripples by phase, so each phase is normalized. */
+static void
+ResamplerKaiserTaps(float *taps, const int tapcount, const double t, const double dB)
+{
+    const double beta = 0.1102 * (dB - 8.7);
+    const double half = tapcount / 2;
+    const double i0beta = bessel(beta);
+    double sum = 0.0;
+    int k;
+
+    for (k = 0; k < tapcount; k++) {
+        const double x = (k - (tapcount / 2) + 1) - t;
+        const double r = x / half;
+        const double kaiser = (r * r < 1.0) ? bessel(beta * sqrt(1.0 - (r * r))) / i0beta : 0.0;
+        const double sinc = (x == 0.0) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+        taps[k] = (float) (kaiser * sinc);
+        sum += kaiser * sinc;
+    }
+    for (k = 0; k < tapcount; k++) {
+        taps[k] = (float) (taps[k] / sum);
+    }
+}
+
+/* taps[k] weighs source frame (srcindex - tapcount / 2 + 1 + k). NULL if the ratio needs too many phases. */
+static float *
+SDL_BuildResamplePhaseTable(const SDL_ResamplerQualityEX quality, const int inrate, const int outrate,
+                            int *phases, int *step, int *tapcount)
+{
+    const int divisor = ResamplerGcd(inrate, outrate);
+    const int phasecount = outrate / divisor;
+    const int count = ResamplerTaps(quality);
+    float *table;
+    int phase;
+
+    if (phasecount <= 0 || phasecount * count > RESAMPLER_TABLE_MAX) {
+        return NULL;
+    }
+
+    table = (float *) calloc(phasecount * count, sizeof (float));
+    if (!table) {
+        return NULL;
+    }
+
+    for (phase = 0; phase < phasecount; phase++) {
+        const double t = ((double) phase) / ((double) phasecount);
+        float *taps = table + (phase * count);
+
+        switch (quality) {
+            case SDL_RESAMPLER_LINEAR:
+                taps[0] = (float) (1.0 - t);
+                taps[1] = (float) t;
+                break;
+            case SDL_RESAMPLER_CUBIC:
+                /* Catmull-Rom through the two frames either side. */
+                taps[0] = (float) (((-t + 2.0) * t - 1.0) * t * 0.5);
+                taps[1] = (float) (((3.0 * t - 5.0) * t * t + 2.0) * 0.5);
+                taps[2] = (float) (((-3.0 * t + 4.0) * t + 1.0) * t * 0.5);
+                taps[3] = (float) ((t - 1.0) * t * t * 0.5);
+                break;
+            case SDL_RESAMPLER_SINC_SHORT:
+                ResamplerKaiserTaps(taps, count, t, 100.0);
+                break;
+            default:
+                ResamplerKaiserTaps(taps, count, t, 115.0);
+                break;
+        }
+    }
+
+    *phases = phasecount;
+    *step = inrate / divisor;
+    *tapcount = count;
+    return table;
+}
+
+/* stereo frames, two taps per vector so the interleaved input is used as is. */
+static void
+ResamplePhaseStereo(const float *taps, const int tapcount, const float *in, float *dst)
+{
+    int k;
+#if HAVE_NEON_INTRINSICS
+    if ((tapcount & 3) == 0) {
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (k = 0; k < tapcount; k += 4) {
+            const float32x4_t c = vld1q_f32(taps + k);
+            const float32x4x2_t cc = vzipq_f32(c, c);
+            acc = vmlaq_f32(acc, vld1q_f32(in + (k * 2)), cc.val[0]);
+            acc = vmlaq_f32(acc, vld1q_f32(in + (k * 2) + 4), cc.val[1]);
+        }
+        vst1_f32(dst, vadd_f32(vget_low_f32(acc), vget_high_f32(acc)));
+        return;
+    }
+#elif HAVE_SSE2_INTRINSICS
+    if ((tapcount & 3) == 0) {
+        __m128 acc = _mm_setzero_ps();
+        for (k = 0; k < tapcount; k += 4) {
+            const __m128 c = _mm_loadu_ps(taps + k);
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(in + (k * 2)), _mm_unpacklo_ps(c, c)));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(in + (k * 2) + 4), _mm_unpackhi_ps(c, c)));
+        }
+        _mm_storel_pi((__m64 *) dst, _mm_add_ps(acc, _mm_movehl_ps(acc, acc)));
+        return;
+    }
+#endif
+    {
+        float left = 0.0f, right = 0.0f;
+        for (k = 0; k < tapcount; k++) {
+            left += in[k * 2] * taps[k];
+            right += in[(k * 2) + 1] * taps[k];
+        }
+        dst[0] = left;
+        dst[1] = right;
+    }
+}
+
+/* same contract as SDL_ResampleAudio(), except rpadding has to follow inbuf directly. */
+static int
+SDL_ResampleAudioPolyphase(const int chans, const int inrate, const int outrate,
+                           const float *table, const int phases, const int step, const int tapcount,
+                           const float *lpadding, const float *inbuf, const int inbuflen,
+                           float *outbuf, const int outbuflen)
+{
+    const double ratio = ((float) outrate) / ((float) inrate);
+    const int paddinglen = ResamplerPadding(inrate, outrate);
+    const int framelen = chans * (int)sizeof (float);
+    const int inframes = inbuflen / framelen;
+    const int wantedoutframes = (int) (inframes * ratio);
+    const int maxoutframes = outbuflen / framelen;
+    const int outframes = SDL_minEX(wantedoutframes, maxoutframes);
+    const int wholestep = step / phases;
+    const int phasestep = step % phases;
+    float *dst = outbuf;
+    int srcindex = 0;
+    int phase = 0;
+    int i, k, chan;
+
+    for (i = 0; i < outframes; i++) {
+        const float *taps = table + (phase * tapcount);
+        const int first = srcindex - (tapcount / 2) + 1;
+
+        if (first < 0) {
+            /* only the first few frames reach back into the previous put. */
+            for (chan = 0; chan < chans; chan++) {
+                float outsample = 0.0f;
+                for (k = 0; k < tapcount; k++) {
+                    const int srcframe = first + k;
+                    const float insample = (srcframe < 0) ? lpadding[((paddinglen + srcframe) * chans) + chan] : inbuf[(srcframe * chans) + chan];
+                    outsample += insample * taps[k];
+                }
+                dst[chan] = outsample;
+            }
+        } else if (chans == 2) {
+            ResamplePhaseStereo(taps, tapcount, inbuf + (first * 2), dst);
+        } else {
+            const float *in = inbuf + (first * chans);
+            for (chan = 0; chan < chans; chan++) {
+                float outsample = 0.0f;
+                for (k = 0; k < tapcount; k++) {
+                    outsample += in[(k * chans) + chan] * taps[k];
+                }
+                dst[chan] = outsample;
+            }
+        }
+        dst += chans;
+
+        srcindex += wholestep;
+        phase += phasestep;
+        if (phase >= phases) {
+            phase -= phases;
+            srcindex++;
+        }
+    }
+
+    return outframes * chans * sizeof (float);
+}
+
+/* s16 to s16 version of SDL_ResampleAudioPolyphase(). The taps are rounded to Q14
+   and each output sample is one 32-bit multiply-accumulate over the input as it
+   came in, so the stream skips both float conversions and the passes they make.
+   Q14 rather than Q15 since the short sinc is normalized per phase and its taps
+   go slightly past 1.0. */
+#define RESAMPLER_FIXED_BITS 14
+
+static int16_t *
+SDL_BuildFixedPhaseTable(const float *table, const int phases, const int tapcount)
+{
+    int16_t *fixed = (int16_t *) malloc(phases * tapcount * sizeof (int16_t));
+    int phase, k;
+
+    if (!fixed) {
+        return NULL;
+    }
+
+    for (phase = 0; phase < phases; phase++) {
+        const float *taps = table + (phase * tapcount);
+        int16_t *out = fixed + (phase * tapcount);
+        float sum = 0.0f;
+        int fixedsum = 0, largest = 0;
+
+        for (k = 0; k < tapcount; k++) {
+            out[k] = (int16_t) lrintf(taps[k] * (float) (1 << RESAMPLER_FIXED_BITS));
+            sum += taps[k];
+            fixedsum += out[k];
+            if (out[k] > out[largest]) {
+                largest = k;
+            }
+        }
+
+        /* the rounding errors add up to a gain that changes with the phase, which is
+           heard as noise. the largest tap takes them so the phase keeps its gain. */
+        out[largest] += (int16_t) (lrintf(sum * (float) (1 << RESAMPLER_FIXED_BITS)) - fixedsum);
+    }
+
+    return fixed;
+}
+
+static int16_t
+ResamplerSaturate(const int32_t acc)
+{
+    const int32_t sample = (acc + (1 << (RESAMPLER_FIXED_BITS - 1))) >> RESAMPLER_FIXED_BITS;
+    return (int16_t) ((sample > 32767) ? 32767 : ((sample < -32768) ? -32768 : sample));
+}
+
+static void
+ResamplePhaseStereoFixed(const int16_t *taps, const int tapcount, const int16_t *in, int16_t *dst)
+{
+    int k;
+#if HAVE_NEON_INTRINSICS
+    if ((tapcount & 3) == 0) {
+        int32x4_t acc0 = vdupq_n_s32(0);
+        int32x4_t acc1 = vdupq_n_s32(0);
+        int32x2_t sum;
+        for (k = 0; k < tapcount; k += 4) {
+            const int16x4_t c = vld1_s16(taps + k);
+            const int16x4x2_t cc = vzip_s16(c, c);
+            const int16x8_t x = vld1q_s16(in + (k * 2));
+            acc0 = vmlal_s16(acc0, vget_low_s16(x), cc.val[0]);
+            acc1 = vmlal_s16(acc1, vget_high_s16(x), cc.val[1]);
+        }
+        acc0 = vaddq_s32(acc0, acc1);
+        sum = vadd_s32(vget_low_s32(acc0), vget_high_s32(acc0));
+        vst1_lane_s32((int32_t *) dst, vreinterpret_s32_s16(vqrshrn_n_s32(vcombine_s32(sum, sum), RESAMPLER_FIXED_BITS)), 0);
+        return;
+    }
+#elif HAVE_SSE2_INTRINSICS
+    if ((tapcount & 3) == 0) {
+        /* madd sums neighbouring lanes, so the frames are paired up by channel first. */
+        __m128i acc = _mm_setzero_si128();
+        for (k = 0; k < tapcount; k += 4) {
+            const __m128i c = _mm_loadl_epi64((const __m128i *) (taps + k));
+            __m128i x = _mm_loadu_si128((const __m128i *) (in + (k * 2)));
+            x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(x, _mm_unpacklo_epi32(c, c)));
+        }
+        acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+        acc = _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(1 << (RESAMPLER_FIXED_BITS - 1))), RESAMPLER_FIXED_BITS);
+        *(int32_t *) dst = _mm_cvtsi128_si32(_mm_packs_epi32(acc, acc));
+        return;
+    }
+#endif
+    if (tapcount == 2) {
+        /* the linear weights never add up to more than 1.0, so it can't clip. */
+        dst[0] = (int16_t) (((in[0] * taps[0]) + (in[2] * taps[1]) + (1 << (RESAMPLER_FIXED_BITS - 1))) >> RESAMPLER_FIXED_BITS);
+        dst[1] = (int16_t) (((in[1] * taps[0]) + (in[3] * taps[1]) + (1 << (RESAMPLER_FIXED_BITS - 1))) >> RESAMPLER_FIXED_BITS);
+    } else {
+        int32_t left = 0, right = 0;
+        for (k = 0; k < tapcount; k++) {
+            left += in[k * 2] * taps[k];
+            right += in[(k * 2) + 1] * taps[k];
+        }
+        dst[0] = ResamplerSaturate(left);
+        dst[1] = ResamplerSaturate(right);
+    }
+}
+
+/* same contract as SDL_ResampleAudioPolyphase(), in s16 samples. */
+static int
+SDL_ResampleAudioFixed(const int chans, const int inrate, const int outrate,
+                       const int16_t *table, const int phases, const int step, const int tapcount,
+                       const int16_t *lpadding, const int16_t *inbuf, const int inbuflen,
+                       int16_t *outbuf, const int outbuflen)
+{
+    const double ratio = ((float) outrate) / ((float) inrate);
+    const int paddinglen = ResamplerPadding(inrate, outrate);
+    const int framelen = chans * (int)sizeof (int16_t);
+    const int inframes = inbuflen / framelen;
+    const int wantedoutframes = (int) (inframes * ratio);
+    const int maxoutframes = outbuflen / framelen;
+    const int outframes = SDL_minEX(wantedoutframes, maxoutframes);
+    const int wholestep = step / phases;
+    const int phasestep = step % phases;
+    int16_t *dst = outbuf;
+    int srcindex = 0;
+    int phase = 0;
+    int i, k, chan;
+
+    for (i = 0; i < outframes; i++) {
+        const int16_t *taps = table + (phase * tapcount);
+        const int first = srcindex - (tapcount / 2) + 1;
+
+        if (first < 0) {
+            for (chan = 0; chan < chans; chan++) {
+                int32_t outsample = 0;
+                for (k = 0; k < tapcount; k++) {
+                    const int srcframe = first + k;
+                    const int16_t insample = (srcframe < 0) ? lpadding[((paddinglen + srcframe) * chans) + chan] : inbuf[(srcframe * chans) + chan];
+                    outsample += insample * taps[k];
+                }
+                dst[chan] = ResamplerSaturate(outsample);
+            }
+        } else if (chans == 2) {
+            ResamplePhaseStereoFixed(taps, tapcount, inbuf + (first * 2), dst);
+        } else {
+            const int16_t *in = inbuf + (first * chans);
+            for (chan = 0; chan < chans; chan++) {
+                int32_t outsample = 0;
+                for (k = 0; k < tapcount; k++) {
+                    outsample += in[(k * chans) + chan] * taps[k];
+                }
+                dst[chan] = ResamplerSaturate(outsample);
+            }
+        }
+        dst += chans;
+
+        srcindex += wholestep;
+        phase += phasestep;
+        if (phase >= phases) {
+            phase -= phases;
+            srcindex++;
+        }
+    }
+
+    return outframes * chans * sizeof (int16_t);
+}
+
 int
 SDL_ConvertAudio_EX(SDL_AudioCVT_EX * cvt)
 {
@@ -2746,6 +3118,15 @@ struct _SDL_AudioStream
     int resampler_padding_samples;
     float *resampler_padding;
     void *resampler_state;
+    /* set when the rates have few enough phases for SDL_ResampleAudioPolyphase(). */
+    float *resampler_phase_table;
+    int resampler_phases;
+    int resampler_step;
+    int resampler_taps;
+    /* Q14 copy of the phase table when both ends are s16, nothing is converted to float then. */
+    int16_t *resampler_fixed_table;
+    /* bytes per sample handed to resampler_func, the padding is kept in the same format. */
+    int resampler_sample_size;
     SDL_ResampleAudioStreamFunc resampler_func;
     SDL_ResetAudioStreamResamplerFunc reset_resampler_func;
     SDL_CleanupAudioStreamResamplerFunc cleanup_resampler_func;
@@ -2874,25 +3255,95 @@ SDL_ResampleAudioStream(SDL_AudioStream *stream, const void *_inbuf, const int i
 
     assert(inbuf != ((const float *) outbuf));  /* SDL_AudioStreamPutEX() shouldn't allow in-place resamples. */
 
-    retval = SDL_ResampleAudio(chans, inrate, outrate, lpadding, rpadding, inbuf, inbuflen, outbuf, outbuflen);
+    if (stream->resampler_phase_table) {
+        retval = SDL_ResampleAudioPolyphase(chans, inrate, outrate, stream->resampler_phase_table, stream->resampler_phases,
+                                            stream->resampler_step, stream->resampler_taps, lpadding, inbuf, inbuflen, outbuf, outbuflen);
+    } else {
+        retval = SDL_ResampleAudio(chans, inrate, outrate, lpadding, rpadding, inbuf, inbuflen, outbuf, outbuflen);
+    }
 
     /* update our left padding with end of current input, for next run. */
     memcpy((lpadding + paddingsamples) - (cpy / sizeof (float)), inbufend - cpy, cpy);
     return retval;
 }
 
+static int
+SDL_ResampleAudioStreamFixed(SDL_AudioStream *stream, const void *_inbuf, const int inbuflen, void *_outbuf, const int outbuflen)
+{
+    const uint8_t *inbufend = ((const uint8_t *) _inbuf) + inbuflen;
+    const int chans = (int) stream->pre_resample_channels;
+    const int paddingsamples = stream->resampler_padding_samples;
+    const int paddingbytes = paddingsamples * sizeof (int16_t);
+    int16_t *lpadding = (int16_t *) stream->resampler_state;
+    const int cpy = SDL_minEX(inbuflen, paddingbytes);
+    int retval;
+
+    assert(_inbuf != _outbuf);
+
+    retval = SDL_ResampleAudioFixed(chans, stream->src_rate, stream->dst_rate, stream->resampler_fixed_table, stream->resampler_phases,
+                                    stream->resampler_step, stream->resampler_taps, lpadding, (const int16_t *) _inbuf, inbuflen,
+                                    (int16_t *) _outbuf, outbuflen);
+
+    memcpy((lpadding + paddingsamples) - (cpy / sizeof (int16_t)), inbufend - cpy, cpy);
+    return retval;
+}
+
 static void
 SDL_ResetAudioStreamResampler(SDL_AudioStream *stream)
 {
     /* set all the padding to silence. */
     const int len = stream->resampler_padding_samples;
-    memset(stream->resampler_state, '\0', len * sizeof (float));
+    memset(stream->resampler_state, '\0', len * stream->resampler_sample_size);
 }
 
 static void
 SDL_CleanupAudioStreamResampler(SDL_AudioStream *stream)
 {
     free(stream->resampler_state);
+    free(stream->resampler_phase_table);
+    free(stream->resampler_fixed_table);
+}
+
+/* s16 to s16 at the same channel count, anything else goes through float. */
+static bool
+SetupFixedResampling(SDL_AudioStream *stream, const SDL_ResamplerQualityEX quality)
+{
+    float *table;
+
+    if (stream->src_format != AUDIO_S16SYS || stream->dst_format != AUDIO_S16SYS || stream->src_channels != stream->dst_channels) {
+        return false;
+    }
+    /* 12 taps rounded to Q14 add more noise than the full sinc takes out, it stays in float. */
+    if (quality == SDL_RESAMPLER_SINC) {
+        return false;
+    }
+
+    if (SDL_PrepareResampleFilter() < 0) {
+        return false;
+    }
+
+    table = SDL_BuildResamplePhaseTable(quality, stream->src_rate, stream->dst_rate, &stream->resampler_phases,
+                                        &stream->resampler_step, &stream->resampler_taps);
+    if (!table) {
+        return false;
+    }
+
+    stream->resampler_fixed_table = SDL_BuildFixedPhaseTable(table, stream->resampler_phases, stream->resampler_taps);
+    free(table);
+    stream->resampler_state = calloc(stream->resampler_padding_samples, sizeof (int16_t));
+    if (!stream->resampler_fixed_table || !stream->resampler_state) {
+        free(stream->resampler_fixed_table);
+        free(stream->resampler_state);
+        stream->resampler_fixed_table = NULL;
+        stream->resampler_state = NULL;
+        return false;
+    }
+
+    stream->resampler_sample_size = sizeof (int16_t);
+    stream->resampler_func = SDL_ResampleAudioStreamFixed;
+    stream->reset_resampler_func = SDL_ResetAudioStreamResampler;
+    stream->cleanup_resampler_func = SDL_CleanupAudioStreamResampler;
+    return true;
 }
 
 SDL_AudioStream *
@@ -2901,7 +3352,8 @@ SDL_NewAudioStreamEX(const SDL_AudioFormat src_format,
                    const int src_rate,
                    const SDL_AudioFormat dst_format,
                    const uint8_t dst_channels,
-                   const int dst_rate)
+                   const int dst_rate,
+                   const SDL_ResamplerQualityEX quality)
 {
     const int packetlen = 4096;  /* !!! FIXME: good enough for now. */
     uint8_t pre_resample_channels;
@@ -2930,6 +3382,7 @@ SDL_NewAudioStreamEX(const SDL_AudioFormat src_format,
     retval->pre_resample_channels = pre_resample_channels;
     retval->packetlen = packetlen;
     retval->rate_incr = ((double) dst_rate) / ((double) src_rate);
+    retval->resampler_sample_size = sizeof (float);
     retval->resampler_padding_samples = ResamplerPadding(retval->src_rate, retval->dst_rate) * pre_resample_channels;
     retval->resampler_padding = (float *) calloc(retval->resampler_padding_samples ? retval->resampler_padding_samples : 1, sizeof (float));
 
@@ -2956,6 +3409,8 @@ SDL_NewAudioStreamEX(const SDL_AudioFormat src_format,
             SDL_FreeAudioStreamEX(retval);
             return NULL;  /* SDL_BuildAudioCVT_EX should have called fprintf.stderr,  */
         }
+    } else if (SetupFixedResampling(retval, quality)) {
+        /* no conversions either side, the input is resampled as it is. */
     } else {
         /* Don't resample at first. Just get us to Float32 format. */
         /* !!! FIXME: convert to int32 on devices without hardware float. */
@@ -2983,6 +3438,10 @@ SDL_NewAudioStreamEX(const SDL_AudioFormat src_format,
                 return NULL;
             }
 
+            /* the scalar path covers any ratio the table would be too big for. */
+            retval->resampler_phase_table = SDL_BuildResamplePhaseTable(quality, src_rate, dst_rate, &retval->resampler_phases,
+                                                                        &retval->resampler_step, &retval->resampler_taps);
+
             retval->resampler_func = SDL_ResampleAudioStream;
             retval->reset_resampler_func = SDL_ResetAudioStreamResampler;
             retval->cleanup_resampler_func = SDL_CleanupAudioStreamResampler;
@@ -3024,7 +3483,7 @@ SDL_AudioStreamPutInternal(SDL_AudioStream *stream, const void *buf, int len, in
        !!! FIXME:  a few samples at the end and convert them separately. */
 
     /* no padding prepended on first run. */
-    neededpaddingbytes = stream->resampler_padding_samples * sizeof (float);
+    neededpaddingbytes = stream->resampler_padding_samples * stream->resampler_sample_size;
     paddingbytes = stream->first_run ? 0 : neededpaddingbytes;
     stream->first_run = false;
 
@@ -3036,7 +3495,7 @@ SDL_AudioStreamPutInternal(SDL_AudioStream *stream, const void *buf, int len, in
 
     if (stream->dst_rate != stream->src_rate) {
         /* resamples can't happen in place, so make space for second buf. */
-        const int framesize = stream->pre_resample_channels * sizeof (float);
+        const int framesize = stream->pre_resample_channels * stream->resampler_sample_size;
         const int frames = workbuflen / framesize;
         resamplebuflen = ((int) ceil(frames * stream->rate_incr)) * framesize;
         #if DEBUG_AUDIOSTREAM
@@ -3292,6 +3751,218 @@ SDL_AudioStreamClearEX(SDL_AudioStream *stream)
     }
 }
 
+/* xorshift32, the two halves of one draw make a triangular value between -1 and 1. */
+static float
+DitherDraw(uint32_t *state)
+{
+    uint32_t s = *state;
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    *state = s;
+    return ((float) (s & 0xFFFF) - (float) (s >> 16)) * (1.0f / 65536.0f);
+}
+
+void
+SDL_ConvertF32ToS16EX(const float *src, int16_t *dst, const int samples, uint32_t *dither)
+{
+    int i = 0;
+
+#if HAVE_NEON_INTRINSICS
+    {
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t negone = vdupq_n_f32(-1.0f);
+        const float32x4_t mulby32767 = vdupq_n_f32(32767.0f);
+        if (dither) {
+            const uint32x4_t low = vdupq_n_u32(0xFFFF);
+            const float32x4_t lsb = vdupq_n_f32(1.0f / 65536.0f);
+            uint32x4_t s = vld1q_u32(dither);
+            for (; i + 4 <= samples; i += 4) {
+                float32x4_t d;
+                s = veorq_u32(s, vshlq_n_u32(s, 13));
+                s = veorq_u32(s, vshrq_n_u32(s, 17));
+                s = veorq_u32(s, vshlq_n_u32(s, 5));
+                d = vmulq_f32(vsubq_f32(vcvtq_f32_u32(vandq_u32(s, low)), vcvtq_f32_u32(vshrq_n_u32(s, 16))), lsb);
+                d = vmlaq_f32(d, vminq_f32(vmaxq_f32(negone, vld1q_f32(src + i)), one), mulby32767);
+                vst1_s16(dst + i, vqmovn_s32(vcvtnq_s32_f32(d)));
+            }
+            vst1q_u32(dither, s);
+        } else {
+            for (; i + 4 <= samples; i += 4) {
+                const float32x4_t v = vmulq_f32(vminq_f32(vmaxq_f32(negone, vld1q_f32(src + i)), one), mulby32767);
+                vst1_s16(dst + i, vqmovn_s32(vcvtnq_s32_f32(v)));
+            }
+        }
+    }
+#elif HAVE_SSE2_INTRINSICS
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 negone = _mm_set1_ps(-1.0f);
+        const __m128 mulby32767 = _mm_set1_ps(32767.0f);
+        if (dither) {
+            const __m128i low = _mm_set1_epi32(0xFFFF);
+            const __m128 lsb = _mm_set1_ps(1.0f / 65536.0f);
+            __m128i s = _mm_loadu_si128((const __m128i *) dither);
+            for (; i + 4 <= samples; i += 4) {
+                __m128 d;
+                __m128i v;
+                s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+                s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+                s = _mm_xor_si128(s, _mm_slli_epi32(s, 5));
+                /* both halves fit in 16 bits, so the signed conversion is exact. */
+                d = _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_and_si128(s, low)), _mm_cvtepi32_ps(_mm_srli_epi32(s, 16))), lsb);
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_min_ps(_mm_max_ps(negone, _mm_loadu_ps(src + i)), one), mulby32767));
+                v = _mm_cvtps_epi32(d);
+                _mm_storel_epi64((__m128i *) (dst + i), _mm_packs_epi32(v, v));
+            }
+            _mm_storeu_si128((__m128i *) dither, s);
+        } else {
+            for (; i + 4 <= samples; i += 4) {
+                const __m128i v = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(negone, _mm_loadu_ps(src + i)), one), mulby32767));
+                _mm_storel_epi64((__m128i *) (dst + i), _mm_packs_epi32(v, v));
+            }
+        }
+    }
+#endif
+
+    for (; i < samples; i++) {
+        const float sample = (src[i] >= 1.0f) ? 1.0f : ((src[i] <= -1.0f) ? -1.0f : src[i]);
+        const long value = lrintf((sample * 32767.0f) + (dither ? DitherDraw(dither) : 0.0f));
+        dst[i] = (int16_t) ((value > 32767) ? 32767 : ((value < -32768) ? -32768 : value));
+    }
+}
+
+/* Q15 versions of the stream's downmix chains:
+   quad -> stereo      (F + B) / 2
+   5.1  -> stereo      (F + C / 2 + B) / 2.5
+   7.1  -> 5.1 -> stereo  (F + C / 2 + B + S) / 3.75 */
+#define CHANNELMAP_HALF 16384
+#define CHANNELMAP_51_SIDE 13107
+#define CHANNELMAP_51_CENTER 6554
+#define CHANNELMAP_71_SIDE 8738
+#define CHANNELMAP_71_CENTER 4369
+
+static int16_t
+ChannelMapRound(const int32_t acc)
+{
+    const int32_t sample = (acc + (1 << 14)) >> 15;
+    return (int16_t) ((sample > 32767) ? 32767 : ((sample < -32768) ? -32768 : sample));
+}
+
+static void
+SDL_ChannelMapMonoToStereo(const int16_t *src, int16_t *dst, const int frames)
+{
+    int i = 0;
+#if HAVE_NEON_INTRINSICS
+    for (; i + 8 <= frames; i += 8) {
+        const int16x8_t x = vld1q_s16(src + i);
+        vst2q_s16(dst + (i * 2), (int16x8x2_t) {{ x, x }});
+    }
+#elif HAVE_SSE2_INTRINSICS
+    for (; i + 8 <= frames; i += 8) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + (i * 2)), _mm_unpacklo_epi16(x, x));
+        _mm_storeu_si128((__m128i *) (dst + (i * 2) + 8), _mm_unpackhi_epi16(x, x));
+    }
+#endif
+    for (; i < frames; i++) {
+        dst[i * 2] = dst[(i * 2) + 1] = src[i];
+    }
+}
+
+static void
+SDL_ChannelMapQuadToStereo(const int16_t *src, int16_t *dst, const int frames)
+{
+    int i = 0;
+#if HAVE_NEON_INTRINSICS
+    /* each left/right pair is loaded as one 32-bit lane, so vld2 splits fronts from backs. */
+    for (; i + 4 <= frames; i += 4) {
+        const int32x4x2_t x = vld2q_s32((const int32_t *) (src + (i * 4)));
+        vst1q_s16(dst + (i * 2), vrhaddq_s16(vreinterpretq_s16_s32(x.val[0]), vreinterpretq_s16_s32(x.val[1])));
+    }
+#endif
+    for (; i < frames; i++) {
+        const int16_t *in = src + (i * 4);
+        dst[i * 2] = ChannelMapRound((in[0] + in[2]) * CHANNELMAP_HALF);
+        dst[(i * 2) + 1] = ChannelMapRound((in[1] + in[3]) * CHANNELMAP_HALF);
+    }
+}
+
+#if HAVE_NEON_INTRINSICS
+/* front, center and back as left/right pairs of 4 frames, the center duplicated into both. */
+static int16x8_t
+ChannelMapFold(const int16x8_t front, const int16x8_t center, const int16x8_t back, const int16x8_t sides,
+               const int16_t side_weight, const int16_t center_weight)
+{
+    const int16x8_t c = vtrnq_s16(center, center).val[0];
+    int32x4_t lo = vmull_n_s16(vget_low_s16(front), side_weight);
+    int32x4_t hi = vmull_n_s16(vget_high_s16(front), side_weight);
+    lo = vmlal_n_s16(lo, vget_low_s16(back), side_weight);
+    hi = vmlal_n_s16(hi, vget_high_s16(back), side_weight);
+    lo = vmlal_n_s16(lo, vget_low_s16(sides), side_weight);
+    hi = vmlal_n_s16(hi, vget_high_s16(sides), side_weight);
+    lo = vmlal_n_s16(lo, vget_low_s16(c), center_weight);
+    hi = vmlal_n_s16(hi, vget_high_s16(c), center_weight);
+    return vcombine_s16(vqrshrn_n_s32(lo, 15), vqrshrn_n_s32(hi, 15));
+}
+#endif
+
+/* SDL's 5.1 layout: FL+FR+FC+LFE+BL+BR */
+static void
+SDL_ChannelMap51ToStereo(const int16_t *src, int16_t *dst, const int frames)
+{
+    int i = 0;
+#if HAVE_NEON_INTRINSICS
+    for (; i + 4 <= frames; i += 4) {
+        const int32x4x3_t x = vld3q_s32((const int32_t *) (src + (i * 6)));
+        vst1q_s16(dst + (i * 2), ChannelMapFold(vreinterpretq_s16_s32(x.val[0]), vreinterpretq_s16_s32(x.val[1]),
+                                                vreinterpretq_s16_s32(x.val[2]), vdupq_n_s16(0),
+                                                CHANNELMAP_51_SIDE, CHANNELMAP_51_CENTER));
+    }
+#endif
+    for (; i < frames; i++) {
+        const int16_t *in = src + (i * 6);
+        dst[i * 2] = ChannelMapRound(((in[0] + in[4]) * CHANNELMAP_51_SIDE) + (in[2] * CHANNELMAP_51_CENTER));
+        dst[(i * 2) + 1] = ChannelMapRound(((in[1] + in[5]) * CHANNELMAP_51_SIDE) + (in[2] * CHANNELMAP_51_CENTER));
+    }
+}
+
+/* SDL's 7.1 layout: FL+FR+FC+LFE+BL+BR+SL+SR */
+static void
+SDL_ChannelMap71ToStereo(const int16_t *src, int16_t *dst, const int frames)
+{
+    int i = 0;
+#if HAVE_NEON_INTRINSICS
+    for (; i + 4 <= frames; i += 4) {
+        const int32x4x4_t x = vld4q_s32((const int32_t *) (src + (i * 8)));
+        vst1q_s16(dst + (i * 2), ChannelMapFold(vreinterpretq_s16_s32(x.val[0]), vreinterpretq_s16_s32(x.val[1]),
+                                                vreinterpretq_s16_s32(x.val[2]), vreinterpretq_s16_s32(x.val[3]),
+                                                CHANNELMAP_71_SIDE, CHANNELMAP_71_CENTER));
+    }
+#endif
+    for (; i < frames; i++) {
+        const int16_t *in = src + (i * 8);
+        dst[i * 2] = ChannelMapRound(((in[0] + in[4] + in[6]) * CHANNELMAP_71_SIDE) + (in[2] * CHANNELMAP_71_CENTER));
+        dst[(i * 2) + 1] = ChannelMapRound(((in[1] + in[5] + in[7]) * CHANNELMAP_71_SIDE) + (in[2] * CHANNELMAP_71_CENTER));
+    }
+}
+
+SDL_ChannelMapFuncEX
+SDL_GetChannelMapEX(const int src_channels, const int dst_channels)
+{
+    if (dst_channels != 2) {
+        return NULL;
+    }
+
+    switch (src_channels) {
+        case 1: return SDL_ChannelMapMonoToStereo;
+        case 4: return SDL_ChannelMapQuadToStereo;
+        case 6: return SDL_ChannelMap51ToStereo;
+        case 8: return SDL_ChannelMap71ToStereo;
+        default: return NULL;
+    }
+}
+
 /* dispose of a stream */
 void
 SDL_FreeAudioStreamEX(SDL_AudioStream *stream)
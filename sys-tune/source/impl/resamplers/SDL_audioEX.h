@@ -219,6 +219,19 @@ int SDL_ConvertAudio_EX(SDL_AudioCVT_EX * cvt);
 struct _SDL_AudioStream;
 typedef struct _SDL_AudioStream SDL_AudioStream;
 
+/**
+ *  Filter used by an audio stream when the rates differ, cost grows with the
+ *  taps per output frame. Rate pairs with too many filter phases for a
+ *  precomputed table use the unoptimized full sinc whatever is picked.
+ */
+typedef enum
+{
+    SDL_RESAMPLER_LINEAR,     /**< 2 taps, aliases audibly on downsampling */
+    SDL_RESAMPLER_CUBIC,      /**< 4 taps, Catmull-Rom */
+    SDL_RESAMPLER_SINC_SHORT, /**< 8 taps, Kaiser-windowed sinc with 4 zero crossings */
+    SDL_RESAMPLER_SINC        /**< 12 taps, Kaiser-windowed sinc with 6 zero crossings, float even for s16 */
+} SDL_ResamplerQualityEX;
+
 /**
  *  Create a new audio stream
  *
@@ -228,8 +241,12 @@ typedef struct _SDL_AudioStream SDL_AudioStream;
  *  \param dst_format The format of the desired audio output
  *  \param dst_channels The number of channels of the desired audio output
  *  \param dst_rate The sampling rate of the desired audio output
+ *  \param quality The filter used when the sampling rates differ
  *  \return 0 on success, or -1 on error.
  *
+ *  AUDIO_S16SYS on both ends with the same channel count is resampled in
+ *  Q15 fixed point straight from the input, without going through float.
+ *
  *  \sa SDL_AudioStreamPutEX
  *  \sa SDL_AudioStreamGetEX
  *  \sa SDL_AudioStreamAvailableEX
@@ -242,7 +259,8 @@ SDL_AudioStream * SDL_NewAudioStreamEX(const SDL_AudioFormat src_format,
                                            const int src_rate,
                                            const SDL_AudioFormat dst_format,
                                            const uint8_t dst_channels,
-                                           const int dst_rate);
+                                           const int dst_rate,
+                                           const SDL_ResamplerQualityEX quality);
 
 /**
  *  Add data to be converted/resampled to the stream
@@ -334,6 +352,33 @@ void SDL_AudioStreamClearEX(SDL_AudioStream *stream);
  */
 void SDL_FreeAudioStreamEX(SDL_AudioStream *stream);
 
+/**
+ *  Convert float samples to s16 with the same scale and clipping as an
+ *  AUDIO_F32SYS -> AUDIO_S16SYS stream, rounding to nearest.
+ *
+ *  \param src The float samples
+ *  \param dst Where the s16 samples are written, may not overlap src
+ *  \param samples The number of samples
+ *  \param dither NULL, or 4 non-zero words of generator state. Triangular
+ *                dither of +-1 lsb is added before rounding and the state is
+ *                carried on, so consecutive calls continue the sequence.
+ */
+void SDL_ConvertF32ToS16EX(const float *src, int16_t *dst, int samples, uint32_t *dither);
+
+/**
+ *  Mixes s16 frames from one channel layout to another at the same rate, with
+ *  the same matrices as an audio stream: mono is duplicated, the rear (and side)
+ *  channels are folded into the fronts and LFE is dropped.
+ */
+typedef void (*SDL_ChannelMapFuncEX)(const int16_t *src, int16_t *dst, int frames);
+
+/**
+ *  Get the kernel for mono, quad, 5.1 or 7.1 to stereo.
+ *
+ *  \return NULL when there is none, an audio stream has to do the conversion then.
+ */
+SDL_ChannelMapFuncEX SDL_GetChannelMapEX(int src_channels, int dst_channels);
+
 #define SDL_MIX_MAXVOLUME 128
 
 // /* Ends C function definitions when using C++ */
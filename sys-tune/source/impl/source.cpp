@@ -1,13 +1,24 @@
 #include "source.hpp"
 
 #include "sdmc/sdmc.hpp"
+#include "decode_worker.hpp"
+#include "pcm_cache.hpp"
 
+#include <cstdlib>
 #include <cstring>
+#include <strings.h>
 
 // NOTE: when updating dr_libs, check for TUNE-FIX comment for patches.
+#ifndef WANT_SIMD
+#define DRFLAC_NO_NEON
+#define DR_MP3_NO_SIMD
+#endif
+
 #ifdef WANT_FLAC
 #define DR_FLAC_IMPLEMENTATION
+#ifndef WANT_OGG
 #define DR_FLAC_NO_OGG
+#endif
 #define DR_FLAC_NO_STDIO
 #include "dr_flac.h"
 #endif
@@ -15,8 +26,32 @@
 #ifdef WANT_MP3
 #define DR_MP3_IMPLEMENTATION
 #define DR_MP3_NO_STDIO
+#ifdef WANT_FLOAT
+// mp3 synthesis is float anyway, this skips the round trip through s16 inside dr_mp3.
+#define DR_MP3_FLOAT_OUTPUT
+#endif
 #define DRMP3_DATA_CHUNK_SIZE DRMP3_MIN_DATA_CHUNK_SIZE
 #include "dr_mp3.h"
+#include "mp3_index.hpp"
+#include "background.hpp"
+#endif
+
+// armv8-a always has NEON, fail the build rather than quietly decoding with the scalar paths.
+#if defined(WANT_SIMD) && defined(__aarch64__)
+#if defined(WANT_FLAC) && !defined(DRFLAC_SUPPORT_NEON)
+#error "WANT_SIMD set, but dr_flac was built without NEON"
+#endif
+#if defined(WANT_MP3) && !DRMP3_HAVE_SIMD
+#error "WANT_SIMD set, but dr_mp3 was built without NEON"
+#endif
+#endif
+
+#ifdef WANT_BFSTM
+#include "nw_stream.hpp"
+#endif
+
+#ifdef WANT_OGG
+#include "vorbis.hpp"
 #endif
 
 #ifdef WANT_WAV
@@ -25,8 +60,60 @@
 #include "dr_wav.h"
 #endif
 
+// a whole file held in memory.
+struct Preload {
+    sdmc::FileKey key;
+    u8 *data;
+
+    ~Preload() {
+        std::free(data);
+    }
+};
+
 namespace {
 
+    // the last preloaded file is kept around, so repeat and going back to it skip the sd card.
+    std::shared_ptr<const Preload> g_last_preload;
+    LockableMutex g_preload_mutex;
+    s64 g_preload_size_max = 0;
+
+    // split hi-res flac decoding with the decode worker, when there is one.
+    bool g_parallel_decode = false;
+    bool g_dither = true;
+    u32 g_stream_loops = 0;
+    // both buffers of a parallel source, larger blocks are decoded inline.
+    constexpr u64 PARALLEL_MEMORY_MAX = 1024 * 64;
+
+    std::shared_ptr<const Preload> GetPreload(FsFile *file, const sdmc::FileKey &key) {
+        if (key.size <= 0 || key.size > g_preload_size_max) {
+            return nullptr;
+        }
+
+        std::scoped_lock lk(g_preload_mutex);
+
+        // the key holds the modification time, a file replaced in place is read again.
+        if (g_last_preload && g_last_preload->key == key) {
+            return g_last_preload;
+        }
+
+        auto data = static_cast<u8 *>(std::malloc(key.size));
+        if (!data) {
+            return nullptr;
+        }
+
+        u64 bytes_read = 0;
+        if (R_FAILED(fsFileRead(file, 0, data, key.size, 0, &bytes_read)) || s64(bytes_read) != key.size) {
+            std::free(data);
+            return nullptr;
+        }
+
+        auto preload = std::make_shared<Preload>();
+        preload->key  = key;
+        preload->data = data;
+        g_last_preload = preload;
+        return preload;
+    }
+
     enum SeekOrigin {
         SeekOrigin_SET,
         SeekOrigin_CUR,
@@ -84,164 +171,294 @@ namespace {
     }
 #endif
 
-#ifdef DEBUG
-    void *log_malloc(size_t sz, void *) {
-        std::printf("malloc: 0x%lX\n", sz);
-        return malloc(sz);
+    s64 GetSize(FsFile *file) {
+        s64 size;
+        if (R_FAILED(fsFileGetSize(file, &size)))
+            return 0;
+        return size;
+    }
+
+    // a tagged loop plays this many extra times, then the track runs on to its end.
+    constexpr u32 TAGGED_LOOP_COUNT = 1;
+
+    // LOOPSTART/LOOPLENGTH/LOOPEND as written by game music rippers, in frames.
+    struct LoopTags {
+        s64 start  = -1;
+        s64 length = -1;
+        s64 end    = -1;
+    };
+
+    void ParseLoopTag(const char *key, size_t key_len, const char *value, size_t value_len, LoopTags *tags) {
+        char number[24];
+        if (!value_len || value_len >= sizeof(number)) {
+            return;
+        }
+
+        std::memcpy(number, value, value_len);
+        number[value_len] = '\0';
+        char *end;
+        const auto v = std::strtoll(number, &end, 10);
+        if (end == number || v < 0) {
+            return;
+        }
+
+        const auto is = [key, key_len](const char *name) {
+            return key_len == std::strlen(name) && !strncasecmp(key, name, key_len);
+        };
+
+        if (is("LOOPSTART")) {
+            tags->start = v;
+        } else if (is("LOOPLENGTH")) {
+            tags->length = v;
+        } else if (is("LOOPEND")) {
+            tags->end = v;
+        }
     }
-    void *log_realloc(void *p, size_t sz, void *) {
-        std::printf("realloc: %p, 0x%lX\n", p, sz);
-        return realloc(p, sz);
+
+    // end is exclusive, 0 when the loop runs to the end of the file.
+    bool ResolveLoopTags(const LoopTags &tags, u64 total, u64 *start, u64 *end) {
+        if (tags.start < 0) {
+            return false;
+        }
+
+        *start = tags.start;
+        *end   = tags.length > 0 ? tags.start + tags.length : std::max<s64>(tags.end, 0);
+        if (total && *end > total) {
+            *end = 0;
+        }
+
+        return *start < (*end ? *end : total);
     }
-    void log_free(void *p, void *) {
-        std::printf("free: %p\n", p);
-        free(p);
+
+    u32 ReadLE32(const u8 *p) {
+        return p[0] | p[1] << 8 | p[2] << 16 | u32(p[3]) << 24;
+    }
+
+    u32 ReadBE32(const u8 *p) {
+        return u32(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+    }
+
+    u32 ReadSyncSafe(const u8 *p) {
+        return p[0] << 21 | p[1] << 14 | p[2] << 7 | p[3];
+    }
+
+    // the comments are parsed straight from the file, dr_flac would also load any embedded pictures.
+    void ReadFlacLoopTags(Source *source, LoopTags *tags) {
+        u8 header[4];
+        if (source->ReadFile(header, sizeof(header)) != sizeof(header) || std::memcmp(header, "fLaC", 4)) {
+            return;
+        }
+
+        for (;;) {
+            if (source->ReadFile(header, sizeof(header)) != sizeof(header)) {
+                return;
+            }
+
+            const u32 size = header[1] << 16 | header[2] << 8 | header[3];
+            if ((header[0] & 0x7F) == DRFLAC_METADATA_BLOCK_TYPE_VORBIS_COMMENT) {
+                // loop tags are short, anything past the first few KiB is lyrics or art.
+                const u32 read_size = std::min<u32>(size, 1024 * 16);
+                const auto block = static_cast<u8 *>(std::malloc(read_size));
+                if (!block) {
+                    return;
+                }
+
+                if (source->ReadFile(block, read_size) == read_size && read_size >= 8) {
+                    u32 off = 4 + ReadLE32(block);
+                    u32 count = off + 4 <= read_size ? ReadLE32(block + off) : 0;
+                    off += 4;
+
+                    while (count-- && off + 4 <= read_size) {
+                        const u32 len = ReadLE32(block + off);
+                        off += 4;
+                        if (len > read_size - off) {
+                            break;
+                        }
+
+                        const auto comment = reinterpret_cast<const char *>(block + off);
+                        if (const auto eq = static_cast<const char *>(std::memchr(comment, '=', len))) {
+                            ParseLoopTag(comment, eq - comment, eq + 1, comment + len - eq - 1, tags);
+                        }
+                        off += len;
+                    }
+                }
+
+                std::free(block);
+                return;
+            }
+
+            if ((header[0] & 0x80) || !source->SeekFile(size, SeekOrigin_CUR)) {
+                return;
+            }
+        }
+    }
+
+    // TXXX frames from an id3v2.3/2.4 tag, the description and value narrowed to ascii.
+    void ReadId3LoopTags(Source *source, LoopTags *tags) {
+        u8 header[10];
+        if (source->ReadFile(header, sizeof(header)) != sizeof(header) || std::memcmp(header, "ID3", 3) || header[3] < 3 || header[3] > 4) {
+            return;
+        }
+
+        const bool v24 = header[3] == 4;
+        const s64 tag_end = 10 + ReadSyncSafe(header + 6);
+        s64 offset = 10;
+        if (header[5] & 0x40) {
+            u8 ext[4];
+            if (source->ReadFile(ext, sizeof(ext)) != sizeof(ext)) {
+                return;
+            }
+            offset += v24 ? ReadSyncSafe(ext) : 4 + ReadBE32(ext);
+        }
+
+        while (offset + 10 <= tag_end) {
+            u8 frame[10];
+            if (!source->SeekFile(offset, SeekOrigin_SET) || source->ReadFile(frame, sizeof(frame)) != sizeof(frame) || !frame[0]) {
+                return;
+            }
+
+            const u32 size = v24 ? ReadSyncSafe(frame + 4) : ReadBE32(frame + 4);
+            char text[128];
+            u8 data[256];
+            if (!std::memcmp(frame, "TXXX", 4) && size > 1 && size <= sizeof(data) && source->ReadFile(data, size) == size) {
+                // utf-16 is 1 with a bom, 2 big endian without, latin-1 and utf-8 are read as is.
+                const u32 encoding = data[0];
+                const bool wide = encoding == 1 || encoding == 2;
+                bool big_endian = encoding == 2;
+                u32 len = 0;
+
+                for (u32 i = 1; i + (wide ? 1 : 0) < size && len < sizeof(text); i += wide ? 2 : 1) {
+                    u32 c = data[i];
+                    if (wide) {
+                        c = big_endian ? data[i] << 8 | data[i + 1] : data[i + 1] << 8 | data[i];
+                        // a bom read the wrong way round flips the byte order.
+                        if (c == 0xFFFE) {
+                            big_endian = !big_endian;
+                        }
+                        if (c == 0xFEFF || c == 0xFFFE) {
+                            continue;
+                        }
+                    }
+                    text[len++] = c < 0x80 ? c : '?';
+                }
+
+                if (const auto sep = static_cast<const char *>(std::memchr(text, '\0', len))) {
+                    const auto value = sep + 1;
+                    auto value_len = text + len - value;
+                    while (value_len && value[value_len - 1] == '\0') {
+                        value_len--;
+                    }
+                    ParseLoopTag(text, sep - text, value, value_len, tags);
+                }
+            }
+
+            offset += 10 + size;
+        }
     }
-    constexpr const drflac_allocation_callbacks flac_alloc = {
-        .onMalloc  = log_malloc,
-        .onRealloc = log_realloc,
-        .onFree    = log_free,
-    };
-    constexpr const drmp3_allocation_callbacks mp3_alloc = {
-        .onMalloc  = log_malloc,
-        .onRealloc = log_realloc,
-        .onFree    = log_free,
-    };
-    constexpr const drwav_allocation_callbacks wav_alloc = {
-        .onMalloc  = log_malloc,
-        .onRealloc = log_realloc,
-        .onFree    = log_free,
-    };
-    constexpr const drflac_allocation_callbacks *flac_alloc_ptr = &flac_alloc;
-    constexpr const drmp3_allocation_callbacks *mp3_alloc_ptr   = &mp3_alloc;
-    constexpr const drwav_allocation_callbacks *wav_alloc_ptr   = &wav_alloc;
-#else
-#ifdef WANT_FLAC
-    constexpr const drflac_allocation_callbacks *flac_alloc_ptr = nullptr;
-#endif
-#ifdef WANT_MP3
-    constexpr const drmp3_allocation_callbacks *mp3_alloc_ptr   = nullptr;
-#endif
-#ifdef WANT_WAV
-    constexpr const drwav_allocation_callbacks *wav_alloc_ptr   = nullptr;
-#endif
-#endif
 
 }
 
-Source::Source(FsFile &&file) : m_file(file), m_offset(0), m_size(0) {
+Source::Source(FsFile &&file, const char *path) : m_file(file), m_offset(0), m_size(GetSize(&m_file)), m_key(sdmc::MakeFileKey(path, m_size)), m_read_ahead(&m_file, m_key) {
     file = {};
-    m_buffered.off = m_buffered.size = 0;
-    if (R_FAILED(fsFileGetSize(&this->m_file, &this->m_size)))
-        this->m_size = 0;
+
+    if ((m_preload = GetPreload(&m_file, m_key))) {
+        m_read_ahead.Release();
+    }
 }
 
 Source::~Source() {
+    // the io thread may still be reading into this source.
+    m_read_ahead.Cancel();
     fsFileClose(&this->m_file);
     this->m_offset = 0;
     this->m_size   = 0;
 }
 
-bool Source::SetupResampler(int output_channels, int output_sample_rate) {
+bool Source::SetupResampler(int output_channels, int output_sample_rate, SDL_ResamplerQualityEX quality) {
+    // the decoder is set up by now, so the read-ahead can be sized for the bitrate.
+    if (const auto [current, total] = Tell(); total && !m_preload && !m_unbuffered) {
+        m_read_ahead.SetByteRate(u64(m_size) * GetSampleRate() / total);
+    }
+
     // check if we even need the resampler.
-    m_native_stream = GetChannelCount() == output_channels && GetSampleRate() == output_sample_rate;
+    m_output_channels = output_channels;
+    m_native_stream = SetupPassthrough(output_channels, output_sample_rate) ||
+                      (GetChannelCount() == output_channels && GetSampleRate() == output_sample_rate);
+    m_frame_channels = m_native_stream ? output_channels : GetChannelCount();
     if (m_native_stream) {
         return true;
     }
 
+    // mono and surround at the output rate only need mixing, which is cheaper than any stream.
+    if (GetSampleRate() == output_sample_rate) {
+        m_channel_map = SDL_GetChannelMapEX(GetChannelCount(), output_channels);
+        if (m_channel_map) {
+            return true;
+        }
+    }
+
+#ifdef WANT_FLOAT
+    // float from the decoder through the resampler, converted once as the block is written.
+    if (CanDecodeFloat()) {
+        m_float_stream = true;
+        m_sdl_stream = UniqueAudioStream{
+            SDL_NewAudioStreamEX(
+            AUDIO_F32SYS, GetChannelCount(), GetSampleRate(),
+            AUDIO_F32SYS, output_channels, output_sample_rate, quality)
+        };
+
+        return m_sdl_stream != nullptr;
+    }
+#endif
+
     m_sdl_stream = UniqueAudioStream{
         SDL_NewAudioStreamEX(
         AUDIO_S16, GetChannelCount(), GetSampleRate(),
-        AUDIO_S16, output_channels, output_sample_rate)
+        AUDIO_S16, output_channels, output_sample_rate, quality)
     };
 
     return m_sdl_stream != nullptr;
 }
 
-s64 Source::Resample(u8* out, std::size_t size) {
-    if (!out || !size) {
-        return -1;
-    }
-
-    if (m_native_stream) {
-        return Decode(size / sizeof(s16), (s16*)out);
-    } else {
-        s64 data_read = 0;
-        while (size > 0) {
-            const auto sz = SDL_AudioStreamGetEX(m_sdl_stream.get(), out, size);
-
-            if (sz < 0) {
-                return -1;
-            } else if (sz > 0) {
-                size -= sz;
-                out += sz;
-                data_read += sz;
-            } else {
-                const auto dec_got = Decode(m_resample_buffer.size(), m_resample_buffer.data());
-                if (dec_got == 0) {
-                    return data_read;
-                }
-                if (0 != SDL_AudioStreamPutEX(m_sdl_stream.get(), m_resample_buffer.data(), dec_got)) {
-                    return -1;
-                }
-            }
-        }
-
-        return data_read;
-    }
+#ifdef WANT_FLOAT
+void Source::ConvertOut(const float *in, s16 *out, int samples) {
+    SDL_ConvertF32ToS16EX(in, out, samples, g_dither ? m_dither : nullptr);
 }
+#endif
 
-size_t Source::ReadFile(void *_buffer, size_t read_size) {
-    auto dst = static_cast<u8*>(_buffer);
-    size_t amount = 0;
+size_t Source::ReadFile(void *buffer, size_t read_size) {
+    if (m_preload) {
+        return ReadPreload(buffer, read_size);
+    }
 
-    // check if we already have this data buffered.
-    if (m_buffered.size) {
-        // check if we can read this data into the beginning of dst.
-        if (this->m_offset < m_buffered.off + m_buffered.size && this->m_offset >= m_buffered.off) {
-            const auto off = this->m_offset - m_buffered.off;
-            const auto size = std::min<s64>(read_size, m_buffered.size - off);
-            std::memcpy(dst, m_buffered.data + off, size);
+    const auto amount = m_read_ahead.Read(this->m_offset, buffer, read_size);
+    this->m_offset += amount;
+    return amount;
+}
 
-            read_size -= size;
-            m_offset += size;
-            amount += size;
-            dst += size;
-        }
+size_t Source::ReadFileUnbuffered(void *buffer, size_t read_size) {
+    if (m_preload) {
+        return ReadPreload(buffer, read_size);
     }
 
-    if (read_size) {
-        u64 bytes_read = 0;
-
-        // if the dst dst is big enough, read data in place.
-        if (read_size >= sizeof(m_buffered.data)) {
-            if (R_SUCCEEDED(fsFileRead(&this->m_file, this->m_offset, dst, read_size, 0, &bytes_read)) && bytes_read) {
-                read_size -= bytes_read;
-                m_offset += bytes_read;
-                amount += bytes_read;
-                dst += bytes_read;
-
-                // save the last chunk of data to the m_buffered io.
-                const auto max_advance = std::min(amount, sizeof(m_buffered.data));
-                m_buffered.off = m_offset - max_advance;
-                m_buffered.size = max_advance;
-                std::memcpy(m_buffered.data, dst - max_advance, max_advance);
-            }
-        } else if (R_SUCCEEDED(fsFileRead(&this->m_file, this->m_offset, m_buffered.data, sizeof(m_buffered.data), 0, &bytes_read)) && bytes_read) {
-            const auto max_advance = std::min(read_size, bytes_read);
-            std::memcpy(dst, m_buffered.data, max_advance);
+    u64 bytes_read = 0;
+    if (R_FAILED(sdmc::ReadFile(&this->m_file, this->m_key, this->m_offset, buffer, read_size, &bytes_read))) {
+        return 0;
+    }
 
-            m_buffered.off = m_offset;
-            m_buffered.size = bytes_read;
+    this->m_offset += bytes_read;
+    return bytes_read;
+}
 
-            read_size -= max_advance;
-            m_offset += max_advance;
-            amount += max_advance;
-            dst += max_advance;
-        }
+size_t Source::ReadPreload(void *buffer, size_t read_size) {
+    const auto size = std::min<s64>(read_size, this->m_size - this->m_offset);
+    if (size <= 0) {
+        return 0;
     }
 
-    return amount;
+    std::memcpy(buffer, m_preload->data + this->m_offset, size);
+    this->m_offset += size;
+    return size;
 }
 
 bool Source::SeekFile(s64 offset, int origin) {
@@ -262,6 +479,7 @@ bool Source::SeekFile(s64 offset, int origin) {
 
     if (new_offset >= 0 && new_offset <= this->m_size) {
         this->m_offset = new_offset;
+        m_read_ahead.Seek(new_offset);
         return true;
     } else {
         return false;
@@ -272,22 +490,139 @@ s64 Source::TellFile() {
     return this->m_offset;
 }
 
+s64 Source::GetFileSize() const {
+    return this->m_size;
+}
+
+const ReadAhead &Source::GetReadAhead() const {
+    return this->m_read_ahead;
+}
+
+std::pair<u32, u32> Source::Tell() const {
+    return {this->m_position, this->m_total};
+}
+
+void Source::SetPosition(u64 current, u64 total) {
+    this->m_position = current;
+    this->m_total    = total;
+}
+
+void Source::SetRepeat(bool repeat) {
+    m_repeat = repeat;
+}
+
+void Source::SetLoopPoints(u64 start, u64 end, u32 count) {
+    m_loop_start = start;
+    m_loop_end   = end;
+    m_loops_left = m_loop_count = count;
+}
+
+bool Source::TakeLoopPoints(u64 *start, u64 *end, u32 *count) {
+    if (!m_loops_left) {
+        return false;
+    }
+
+    *start = m_loop_start;
+    *end   = m_loop_end;
+    *count = m_loop_count;
+    m_loops_left = 0;
+    return true;
+}
+
+void Source::Suspend() {
+    m_read_ahead.Release();
+}
+
+void Source::Resume() {
+    if (!m_preload && !m_unbuffered) {
+        m_read_ahead.Restore();
+    }
+}
+
+void Source::DisableReadAhead() {
+    m_unbuffered = true;
+    m_read_ahead.Release();
+}
+
+bool Source::WillWrap() const {
+    return m_repeat || m_loops_left;
+}
+
 bool Source::Done() {
+    // the next decode wraps around.
+    if (WillWrap()) {
+        return false;
+    }
+
     auto [current, total] = this->Tell();
+    if (current != total) {
+        return false;
+    }
 
-    return current == total;
+    return m_native_stream || (m_stream_flushed && SDL_AudioStreamAvailableEX(m_sdl_stream.get()) == 0);
 }
 
 #ifdef WANT_FLAC
-class FlacFile final : public Source {
+class FlacFile final : public SourceBase<FlacFile> {
   private:
+    // the worker's share of the track is decoded through its own handle and decoder.
+    struct WorkerStream {
+        FsFile file;
+        s64 offset;
+        s64 size;
+    };
+
+    // frames [first, first + frames) decoded by the worker into buffer.
+    struct Job {
+        bool active;
+        u32 buffer;
+        u64 first;
+        u64 frames;
+        // where the frame after the job starts, checked by the worker.
+        s64 end_offset;
+        // the frame after the job doesn't start where the job ends, the split can't be trusted.
+        bool mismatch;
+    };
+
     drflac *m_flac;
+    drflac *m_worker{};
+    WorkerStream m_stream{};
+    Job m_job{};
+    s16 *m_buffers[2]{};
+    // worker output that is being played out.
+    u32 m_serve_buffer{};
+    u64 m_serve_pos{};
+    u64 m_serve_frames{};
+    u64 m_chunk{};
+    u64 m_frame{};
+    // no new job before this frame, set when finding a split point failed.
+    u64 m_next_job_frame{};
 
   public:
-    FlacFile(FsFile &&file) : Source(std::move(file)) {
-        this->m_flac = drflac_open(ReadCallback, FlacSeekCallback, FlacTellCallback, this, flac_alloc_ptr);
+    FlacFile(FsFile &&file, const char *path) : SourceBase(std::move(file), path) {
+        LoopTags tags;
+        ReadFlacLoopTags(this, &tags);
+        SeekFile(0, SeekOrigin_SET);
+
+        const auto alloc = m_arena.GetCallbacks<drflac_allocation_callbacks>();
+        this->m_flac = drflac_open(ReadCallback, FlacSeekCallback, FlacTellCallback, this, &alloc);
+
+        if (u64 start, end; this->m_flac && ResolveLoopTags(tags, this->m_flac->totalPCMFrameCount, &start, &end)) {
+            SetLoopPoints(start, end, TAGGED_LOOP_COUNT);
+        }
+
+        // the worker seeks by byte offset, which only works in a native flac stream.
+        if (this->m_flac && g_parallel_decode && this->m_flac->container == drflac_container_native) {
+            OpenWorker(path);
+        }
     }
     ~FlacFile() {
+        CancelJob();
+        if (this->m_worker != nullptr) {
+            drflac_close(this->m_worker);
+            fsFileClose(&this->m_stream.file);
+        }
+        std::free(this->m_buffers[0]);
         if (this->m_flac != nullptr)
             drflac_close(this->m_flac);
     }
@@ -296,22 +631,78 @@ class FlacFile final : public Source {
         return this->m_flac != nullptr;
     }
 
-    size_t Decode(size_t sample_count, s16 *data) override {
-        std::scoped_lock lk(this->m_mutex);
+    size_t DecodeSamples(size_t sample_count, s16 *data) {
+        const auto channels = GetChannelCount();
+        const u64 wanted = sample_count / channels;
+        u64 done = 0;
+
+        while (done < wanted) {
+            if (this->m_serve_pos < this->m_serve_frames) {
+                const auto count = std::min(wanted - done, this->m_serve_frames - this->m_serve_pos);
+                std::memcpy(data + done * channels, this->m_buffers[this->m_serve_buffer] + this->m_serve_pos * channels, count * channels * sizeof(s16));
+                this->m_serve_pos += count;
+                this->m_frame += count;
+                done += count;
+                continue;
+            }
+
+            if (this->m_job.active && this->m_frame >= this->m_job.first) {
+                FinishJob();
+                StartJob();
+                continue;
+            }
+
+            if (!this->m_job.active && StartJob()) {
+                continue;
+            }
+
+            // decode inline, up to where the worker's share starts.
+            auto count = wanted - done;
+            if (this->m_job.active) {
+                count = std::min(count, this->m_job.first - this->m_frame);
+            }
+
+            const auto frames = drflac_read_pcm_frames_s16(this->m_flac, count, data + done * channels);
+            if (!frames) {
+                break;
+            }
+            this->m_frame = this->m_flac->currentPCMFrame;
+            done += frames;
+        }
+
+        return channels * sizeof(s16) * done;
+    }
+
+#ifdef WANT_FLOAT
+    // keeps 24 bit tracks at full precision, the worker's share is only ever s16.
+    bool CanDecodeFloat() override {
+        return this->m_worker == nullptr;
+    }
 
-        return GetChannelCount() * sizeof(s16) * drflac_read_pcm_frames_s16(this->m_flac, sample_count / GetChannelCount(), data);
+    size_t DecodeSamples(size_t sample_count, float *data) {
+        const auto frames = drflac_read_pcm_frames_f32(this->m_flac, sample_count / GetChannelCount(), data);
+        this->m_frame = this->m_flac->currentPCMFrame;
+        return GetChannelCount() * sizeof(float) * frames;
     }
+#endif
 
-    std::pair<u32, u32> Tell() override {
-        std::scoped_lock lk(this->m_mutex);
+    u64 GetPosition() {
+        return this->m_frame;
+    }
 
-        return {this->m_flac->currentPCMFrame, this->m_flac->totalPCMFrameCount};
+    u64 GetTotal() {
+        return this->m_flac->totalPCMFrameCount;
     }
 
-    bool Seek(u64 target) override {
-        std::scoped_lock lk(this->m_mutex);
+    bool SeekFrames(u64 target) {
+        CancelJob();
+        this->m_serve_frames   = 0;
+        this->m_serve_pos      = 0;
+        this->m_next_job_frame = 0;
 
-        return drflac_seek_to_pcm_frame(this->m_flac, target);
+        const auto result = drflac_seek_to_pcm_frame(this->m_flac, target);
+        this->m_frame = this->m_flac->currentPCMFrame;
+        return result;
     }
 
     int GetSampleRate() override {
@@ -321,142 +712,1121 @@ class FlacFile final : public Source {
     int GetChannelCount() override {
         return this->m_flac->channels;
     }
-};
-#endif
 
-#ifdef WANT_MP3
-class Mp3File final : public Source {
   private:
-    drmp3 m_mp3;
-    bool initialized;
-    u64 m_total_frame_count;
+    // only hi-res tracks are split, everything else is cheap enough to decode on one core.
+    void OpenWorker(const char *path) {
+        if (this->m_flac->sampleRate <= 48000 || this->m_flac->channels > 2 || !this->m_flac->totalPCMFrameCount) {
+            return;
+        }
 
-  public:
-    Mp3File(FsFile &&file) : Source(std::move(file)) {
-        if (drmp3_init(&this->m_mp3, ReadCallback, Mp3SeekCallback, Mp3TellCallback, nullptr, this, mp3_alloc_ptr)) {
-            this->m_total_frame_count = drmp3_get_pcm_frame_count(&this->m_mp3);
-            this->initialized         = true;
+        if (!tune::impl::decode_worker::IsAvailable()) {
+            return;
         }
-    }
-    ~Mp3File() {
-        if (initialized)
-            drmp3_uninit(&this->m_mp3);
-    }
 
-    bool IsOpen() override {
-        return initialized;
-    }
+        // the worker decodes at least one block, and finishes the block it is in.
+        this->m_chunk = this->m_flac->maxBlockSizeInPCMFrames;
+        const u64 buffer_size = this->m_chunk * 2 * this->m_flac->channels * sizeof(s16);
+        if (buffer_size * 2 > PARALLEL_MEMORY_MAX) {
+            return;
+        }
 
-    size_t Decode(size_t sample_count, s16 *data) override {
-        std::scoped_lock lk(this->m_mutex);
+        if (R_FAILED(sdmc::OpenFile(&this->m_stream.file, path))) {
+            return;
+        }
+        this->m_stream.size = GetSize(&this->m_stream.file);
 
-        return GetChannelCount() * sizeof(s16) * drmp3_read_pcm_frames_s16(&this->m_mp3, sample_count / GetChannelCount(), data);
-    }
+        this->m_buffers[0] = static_cast<s16 *>(std::malloc(buffer_size * 2));
+        if (this->m_buffers[0]) {
+            this->m_buffers[1] = this->m_buffers[0] + buffer_size / sizeof(s16);
 
-    std::pair<u32, u32> Tell() override {
-        std::scoped_lock lk(this->m_mutex);
+            const auto alloc = m_arena.GetCallbacks<drflac_allocation_callbacks>();
+            this->m_worker = drflac_open(WorkerRead, WorkerSeek, WorkerTell, &this->m_stream, &alloc);
+        }
 
-        return {this->m_mp3.currentPCMFrame, this->m_total_frame_count};
+        if (!this->m_worker) {
+            std::free(this->m_buffers[0]);
+            this->m_buffers[0] = this->m_buffers[1] = nullptr;
+            fsFileClose(&this->m_stream.file);
+        }
     }
 
-    bool Seek(u64 target) override {
-        std::scoped_lock lk(this->m_mutex);
+    // finds a frame header ahead of the inline decoder for the worker to start on.
+    bool StartJob() {
+        if (!this->m_worker || this->m_frame < this->m_next_job_frame) {
+            return false;
+        }
 
-        return drmp3_seek_to_pcm_frame(&this->m_mp3, target);
-    }
+        const auto data_size = GetFileSize() - s64(this->m_flac->firstFLACFramePosInBytes);
+        const auto hint = TellFile() + s64(this->m_chunk * data_size / this->m_flac->totalPCMFrameCount);
+        const auto inline_end = this->m_flac->currentPCMFrame + this->m_flac->currentFLACFrame.pcmFramesRemaining;
 
-    int GetSampleRate() override {
-        return this->m_mp3.sampleRate;
-    }
+        drflac_uint64 first;
+        if (hint >= GetFileSize() || !drflac_find_flac_frame(this->m_worker, hint, inline_end, &first)) {
+            this->m_next_job_frame = this->m_frame + this->m_chunk;
+            return false;
+        }
 
-    int GetChannelCount() override {
-        return this->m_mp3.channels;
+        this->m_job = Job{
+            .active     = true,
+            .buffer     = this->m_serve_buffer ^ 1,
+            .first      = first,
+            .frames     = 0,
+            .end_offset = 0,
+            .mismatch   = false,
+        };
+
+        if (!tune::impl::decode_worker::Submit(JobFunc, this)) {
+            this->m_job.active = false;
+            this->m_next_job_frame = this->m_frame + this->m_chunk;
+            return false;
+        }
+
+        return true;
     }
-};
-#endif
 
-#ifdef WANT_WAV
-class WavFile final : public Source {
-  private:
-    drwav m_wav;
-    bool initialized;
-    s32 m_bytes_per_pcm;
+    // the inline decoder has reached the worker's share, play it out and skip past it.
+    void FinishJob() {
+        tune::impl::decode_worker::Wait(this);
+        this->m_job.active = false;
 
-  public:
-    WavFile(FsFile &&file) : Source(std::move(file)) {
-        if (drwav_init(&this->m_wav, ReadCallback, WavSeekCallback, WavTellCallback, this, wav_alloc_ptr)) {
-            this->m_bytes_per_pcm = drwav_get_bytes_per_pcm_frame(&this->m_wav);
-            this->initialized     = true;
+        // the inline decoder has to stop exactly where the worker's share starts.
+        if (this->m_job.frames && (this->m_flac->currentPCMFrame != this->m_job.first || this->m_flac->currentFLACFrame.pcmFramesRemaining)) {
+            this->m_job.mismatch = true;
         }
-    }
-    ~WavFile() {
-        if (initialized)
-            drwav_uninit(&this->m_wav);
+
+        if (this->m_job.mismatch) {
+            // frame numbers don't line up, decode the rest of the track inline.
+            this->m_next_job_frame = UINT64_MAX;
+            return;
+        }
+
+        if (!this->m_job.frames) {
+            // the worker failed, keep decoding inline from here for a while.
+            this->m_next_job_frame = this->m_frame + this->m_chunk;
+            return;
+        }
+
+        // the worker already found the next frame at end_offset, so this only fails on a read error.
+        const auto end = this->m_job.first + this->m_job.frames;
+        drflac_uint64 first;
+        if (end >= GetTotal() || !drflac_find_flac_frame(this->m_flac, this->m_job.end_offset, end, &first) || first != end ||
+            !drflac_decode_flac_frame(this->m_flac)) {
+            drflac_seek_to_pcm_frame(this->m_flac, end);
+        }
+
+        this->m_serve_buffer = this->m_job.buffer;
+        this->m_serve_pos    = 0;
+        this->m_serve_frames = this->m_job.frames;
     }
 
-    bool IsOpen() override {
-        return initialized;
+    void CancelJob() {
+        if (this->m_job.active) {
+            tune::impl::decode_worker::Wait(this);
+            this->m_job.active = false;
+        }
     }
 
-    size_t Decode(size_t sample_count, s16 *data) override {
-        std::scoped_lock lk(this->m_mutex);
+    // runs on the worker, the inline decoder doesn't touch m_worker until it is done.
+    static void JobFunc(void *user) {
+        auto self = static_cast<FlacFile *>(user);
+        auto flac = self->m_worker;
+        auto &job = self->m_job;
+        const auto out = self->m_buffers[job.buffer];
+        const auto capacity = self->m_chunk * 2;
 
-        return GetChannelCount() * sizeof(s16) * drwav_read_pcm_frames_s16(&this->m_wav, sample_count / GetChannelCount(), data);
-    }
+        if (!drflac_decode_flac_frame(flac)) {
+            return;
+        }
 
-    std::pair<u32, u32> Tell() override {
-        std::scoped_lock lk(this->m_mutex);
+        // stop on a frame boundary, that is where the inline decoder picks up again.
+        while (job.frames < self->m_chunk || flac->currentFLACFrame.pcmFramesRemaining) {
+            const u64 remaining = flac->currentFLACFrame.pcmFramesRemaining;
+            const auto count = std::min<u64>(remaining ? remaining : 1, capacity - job.frames);
+            const auto frames = drflac_read_pcm_frames_s16(flac, count, out + job.frames * flac->channels);
+            if (!frames) {
+                break;
+            }
+            job.frames += frames;
+        }
 
-        u64 byte_position = this->m_wav.dataChunkDataSize - this->m_wav.bytesRemaining;
-        return {byte_position / this->m_bytes_per_pcm, this->m_wav.totalPCMFrameCount};
+        // the share ended on a frame boundary, the next header has to be right there and
+        // continue the frame numbers, or the inline decoder would skip or repeat audio.
+        const auto end = job.first + job.frames;
+        job.end_offset = self->m_stream.offset - s64(drflac_get_unread_byte_count(flac));
+        if (end < flac->totalPCMFrameCount) {
+            drflac_uint64 next;
+            if (!drflac_find_flac_frame(flac, job.end_offset, 0, &next) || next != end) {
+                job.frames   = 0;
+                job.mismatch = true;
+            }
+        }
     }
 
-    bool Seek(u64 target) override {
-        std::scoped_lock lk(this->m_mutex);
+    static size_t WorkerRead(void *pUserData, void *pBufferOut, size_t bytesToRead) {
+        auto stream = static_cast<WorkerStream *>(pUserData);
 
-        return drwav_seek_to_pcm_frame(&this->m_wav, target);
+        u64 bytes_read = 0;
+        if (R_FAILED(fsFileRead(&stream->file, stream->offset, pBufferOut, bytesToRead, 0, &bytes_read))) {
+            return 0;
+        }
+        stream->offset += bytes_read;
+        return bytes_read;
     }
 
-    int GetSampleRate() override {
-        return this->m_wav.sampleRate;
-    }
+    static drflac_bool32 WorkerSeek(void *pUserData, int offset, drflac_seek_origin origin) {
+        auto stream = static_cast<WorkerStream *>(pUserData);
 
-    int GetChannelCount() override {
-        return this->m_wav.channels;
+        switch (origin) {
+            case DRFLAC_SEEK_SET: stream->offset = offset; break;
+            case DRFLAC_SEEK_CUR: stream->offset += offset; break;
+            case DRFLAC_SEEK_END: stream->offset = stream->size + offset; break;
+        }
+        return stream->offset >= 0 && stream->offset <= stream->size;
+    }
+
+    static drflac_bool32 WorkerTell(void *pUserData, drflac_int64* pCursor) {
+        *pCursor = static_cast<WorkerStream *>(pUserData)->offset;
+        return true;
     }
 };
 #endif
 
-std::unique_ptr<Source> OpenFile(const char *path) {
-    const auto type = GetSourceType(path);
-    if (type == SourceType::NONE)
-        return nullptr;
+#ifdef WANT_MP3
+class Mp3File final : public SourceBase<Mp3File> {
+  private:
+    drmp3 m_mp3;
+    bool initialized;
+    u64 m_total_frame_count;
+    // set while m_total_frame_count is a guess from the header, until the exact count is known.
+    bool m_total_estimated{};
+    tune::impl::mp3_index::Key m_index_key{};
+    std::shared_ptr<tune::impl::mp3_index::Index> m_index;
+    u32 m_index_generation{};
 
-    FsFile file;
+  public:
+    Mp3File(FsFile &&file, const char *path) : SourceBase(std::move(file), path) {
+        LoopTags tags;
+        ReadId3LoopTags(this, &tags);
+        SeekFile(0, SeekOrigin_SET);
+
+        const auto alloc = m_arena.GetCallbacks<drmp3_allocation_callbacks>();
+        if (drmp3_init(&this->m_mp3, ReadCallback, Mp3SeekCallback, Mp3TellCallback, nullptr, this, &alloc)) {
+            this->initialized = true;
+
+            this->m_index_generation = tune::impl::mp3_index::GetGeneration();
+            if (tune::impl::mp3_index::MakeKey(path, GetFileSize(), &this->m_index_key) && !UseIndex(tune::impl::mp3_index::Load(this->m_index_key))) {
+                tune::impl::background::Post(tune::impl::mp3_index::Build, path);
+            }
 
-    if (R_FAILED(sdmc::OpenFile(&file, path)))
-        return nullptr;
+            // the exact count needs every frame header in the file, so only do that
+            // here when neither the tags, the index or the bitrate give an answer.
+            if (!this->m_index && !ProbeFrameCount()) {
+                this->m_total_frame_count = drmp3_get_pcm_frame_count(&this->m_mp3);
+            }
+
+            const auto total = this->m_total_estimated ? 0 : this->m_total_frame_count;
+            if (u64 start, end; ResolveLoopTags(tags, total, &start, &end)) {
+                SetLoopPoints(start, end, TAGGED_LOOP_COUNT);
+            }
+        }
+    }
+    ~Mp3File() {
+        if (initialized)
+            drmp3_uninit(&this->m_mp3);
+    }
+
+    bool IsOpen() override {
+        return initialized;
+    }
+
+    size_t DecodeSamples(size_t sample_count, s16 *data) {
+        RefreshIndex();
+
+        const auto frames = drmp3_read_pcm_frames_s16(&this->m_mp3, sample_count / GetChannelCount(), data);
+        if (!frames && this->m_total_estimated) {
+            // reached the end, so now we know.
+            this->m_total_frame_count = this->m_mp3.currentPCMFrame;
+            this->m_total_estimated   = false;
+        }
+
+        return GetChannelCount() * sizeof(s16) * frames;
+    }
+
+#ifdef WANT_FLOAT
+    bool CanDecodeFloat() override {
+        return true;
+    }
+
+    size_t DecodeSamples(size_t sample_count, float *data) {
+        RefreshIndex();
+
+        const auto frames = drmp3_read_pcm_frames_f32(&this->m_mp3, sample_count / GetChannelCount(), data);
+        if (!frames && this->m_total_estimated) {
+            this->m_total_frame_count = this->m_mp3.currentPCMFrame;
+            this->m_total_estimated   = false;
+        }
+
+        return GetChannelCount() * sizeof(float) * frames;
+    }
+#endif
+
+    u64 GetPosition() {
+        return this->m_mp3.currentPCMFrame;
+    }
+
+    u64 GetTotal() {
+        // an estimate can be short, never report the end before the decoder reaches it.
+        if (this->m_total_estimated) {
+            return std::max<u64>(this->m_total_frame_count, this->m_mp3.currentPCMFrame + 1);
+        }
+
+        return this->m_total_frame_count;
+    }
+
+    bool SeekFrames(u64 target) {
+        RefreshIndex();
+
+        return drmp3_seek_to_pcm_frame(&this->m_mp3, target);
+    }
+
+    int GetSampleRate() override {
+        return this->m_mp3.sampleRate;
+    }
+
+    int GetChannelCount() override {
+        return this->m_mp3.channels;
+    }
+
+  private:
+    bool UseIndex(std::shared_ptr<tune::impl::mp3_index::Index> &&index) {
+        if (!index) {
+            return false;
+        }
+        this->m_index = std::move(index);
+
+        // xing/info counts are exact and already account for the encoder delay and padding.
+        if (this->m_mp3.totalPCMFrameCount == DRMP3_UINT64_MAX) {
+            this->m_total_frame_count = this->m_index->total_pcm_frames;
+            this->m_total_estimated   = false;
+        } else {
+            this->m_total_frame_count = drmp3_get_pcm_frame_count(&this->m_mp3);
+        }
+
+        return drmp3_bind_seek_table(&this->m_mp3, this->m_index->seek_point_count, this->m_index->seek_points.get());
+    }
+
+    // pick up an index the background thread finished after the track was opened, it is
+    // handed over in memory so the decode thread never waits on the sd card here.
+    void RefreshIndex() {
+        if (this->m_index || !this->m_index_key.IsValid()) {
+            return;
+        }
+
+        const auto generation = tune::impl::mp3_index::GetGeneration();
+        if (generation != this->m_index_generation) {
+            this->m_index_generation = generation;
+            UseIndex(tune::impl::mp3_index::TakeBuilt(this->m_index_key));
+        }
+    }
+
+    // xing/info is parsed by drmp3_init, vbri is not, cbr files have neither.
+    bool ProbeFrameCount() {
+        if (this->m_mp3.totalPCMFrameCount != DRMP3_UINT64_MAX) {
+            this->m_total_frame_count = drmp3_get_pcm_frame_count(&this->m_mp3);
+            return true;
+        }
+
+        const auto header = this->m_mp3.decoder.header;
+        const u64 frame_samples = drmp3_hdr_frame_samples(header);
+        const auto start = this->m_mp3.streamStartOffset;
+
+        // vbri sits 32 bytes after the header of the first frame.
+        u8 vbri[4 + 32 + 18];
+        const auto offset = TellFile();
+        const bool has_vbri = SeekFile(start, SeekOrigin_SET) && ReadFile(vbri, sizeof(vbri)) == sizeof(vbri);
+        SeekFile(offset, SeekOrigin_SET);
+
+        if (has_vbri && vbri[0] == 0xFF && !std::memcmp(vbri + 36, "VBRI", 4)) {
+            const u32 frames = vbri[50] << 24 | vbri[51] << 16 | vbri[52] << 8 | vbri[53];
+            if (frames) {
+                this->m_total_frame_count = frames * frame_samples;
+                this->m_total_estimated   = true;
+                return true;
+            }
+        }
+
+        const u64 kbps = drmp3_hdr_bitrate_kbps(header);
+        if (!kbps || GetFileSize() <= s64(start)) {
+            return false;
+        }
+
+        // assume cbr, bytes per frame are fixed by the bitrate of the first frame.
+        const u64 bytes = GetFileSize() - start;
+        this->m_total_frame_count = bytes * 8 * this->m_mp3.sampleRate / (kbps * 1000);
+        this->m_total_estimated   = true;
+        return true;
+    }
+};
+#endif
+
+#ifdef WANT_WAV
+class WavFile final : public SourceBase<WavFile> {
+  private:
+    drwav m_wav;
+    bool initialized;
+    s32 m_bytes_per_pcm;
+    bool m_passthrough{};
+    bool m_byteswap{};
+
+  public:
+    WavFile(FsFile &&file, const char *path) : SourceBase(std::move(file), path) {
+        const auto alloc = m_arena.GetCallbacks<drwav_allocation_callbacks>();
+        if (drwav_init(&this->m_wav, ReadCallback, WavSeekCallback, WavTellCallback, this, &alloc)) {
+            this->m_bytes_per_pcm = drwav_get_bytes_per_pcm_frame(&this->m_wav);
+            this->initialized     = true;
+        }
+    }
+    ~WavFile() {
+        if (initialized)
+            drwav_uninit(&this->m_wav);
+    }
+
+    bool IsOpen() override {
+        return initialized;
+    }
+
+    size_t DecodeSamples(size_t sample_count, s16 *data) {
+        if (this->m_passthrough) {
+            return DecodePassthrough(sample_count, data);
+        }
+
+        return GetChannelCount() * sizeof(s16) * drwav_read_pcm_frames_s16(&this->m_wav, sample_count / GetChannelCount(), data);
+    }
+
+#ifdef WANT_FLOAT
+    // passthrough only happens when no stream is set up, so it never gets here.
+    bool CanDecodeFloat() override {
+        return true;
+    }
+
+    size_t DecodeSamples(size_t sample_count, float *data) {
+        return GetChannelCount() * sizeof(float) * drwav_read_pcm_frames_f32(&this->m_wav, sample_count / GetChannelCount(), data);
+    }
+#endif
+
+    u64 GetPosition() {
+        u64 byte_position = this->m_wav.dataChunkDataSize - this->m_wav.bytesRemaining;
+        return byte_position / this->m_bytes_per_pcm;
+    }
+
+    u64 GetTotal() {
+        return this->m_wav.totalPCMFrameCount;
+    }
+
+    bool SeekFrames(u64 target) {
+        return drwav_seek_to_pcm_frame(&this->m_wav, target);
+    }
+
+    int GetSampleRate() override {
+        return this->m_wav.sampleRate;
+    }
+
+    int GetChannelCount() override {
+        return this->m_wav.channels;
+    }
+
+  protected:
+    // 16 bit pcm at the output rate only needs a byteswap or mono to stereo at most,
+    // so dr_wav is skipped and the data chunk is copied from the read-ahead into the output buffer.
+    bool SetupPassthrough(int output_channels, int output_sample_rate) override {
+        if (this->m_wav.translatedFormatTag != DR_WAVE_FORMAT_PCM || this->m_wav.bitsPerSample != 16) {
+            return false;
+        }
+
+        if (GetSampleRate() != output_sample_rate || this->m_bytes_per_pcm != GetChannelCount() * s32(sizeof(s16))) {
+            return false;
+        }
+
+        if (GetChannelCount() != output_channels && !(GetChannelCount() == 1 && output_channels == 2)) {
+            return false;
+        }
+
+        this->m_passthrough     = true;
+        this->m_byteswap        = this->m_wav.container == drwav_container_rifx ||
+                                  (this->m_wav.container == drwav_container_aiff && !this->m_wav.aiff.isLE);
+        return true;
+    }
+
+  private:
+    // keeps the dr_wav cursor in step so Tell() and Seek() still work. reads go through
+    // the read-ahead like dr_wav's would, so the io thread keeps the next block coming.
+    size_t DecodePassthrough(size_t sample_count, s16 *data) {
+        const auto channels = GetChannelCount();
+        const u64 frames = std::min<u64>(sample_count / this->m_output_channels, this->m_wav.bytesRemaining / this->m_bytes_per_pcm);
+
+        // mono is read into the back half of the buffer and widened in place.
+        s16 *in = data + frames * (this->m_output_channels - channels);
+
+        const auto bytes_read = ReadFile(in, frames * this->m_bytes_per_pcm);
+        const u64 got = bytes_read / this->m_bytes_per_pcm;
+        if (bytes_read != got * this->m_bytes_per_pcm) {
+            SeekFile(-s64(bytes_read - got * this->m_bytes_per_pcm), SeekOrigin_CUR);
+        }
+
+        this->m_wav.bytesRemaining -= got * this->m_bytes_per_pcm;
+        this->m_wav.readCursorInPCMFrames += got;
+
+        if (this->m_byteswap) {
+            for (u64 i = 0; i < got * channels; i++) {
+                in[i] = __builtin_bswap16(in[i]);
+            }
+        }
+
+        if (channels != this->m_output_channels) {
+            for (u64 i = 0; i < got; i++) {
+                data[i * 2 + 0] = data[i * 2 + 1] = in[i];
+            }
+        }
+
+        return got * this->m_output_channels * sizeof(s16);
+    }
+};
+#endif
+
+namespace pcm_cache = tune::impl::pcm_cache;
+
+// a track rendered ahead of time at the output format, read straight into the output buffer.
+class PcmFile final : public SourceBase<PcmFile> {
+  private:
+    u64 m_total{};
+    u64 m_position{};
+
+  public:
+    PcmFile(FsFile &&file, const char *path, const pcm_cache::Entry &entry) : SourceBase(std::move(file), path) {
+        DisableReadAhead();
+        if (!SeekFile(pcm_cache::DATA_OFFSET, SeekOrigin_SET)) {
+            return;
+        }
+
+        this->m_total = entry.total_frames;
+        if (entry.has_loop) {
+            SetLoopPoints(entry.loop_start, entry.loop_end, entry.loop_count);
+        }
+    }
+
+    bool IsOpen() override {
+        return this->m_total != 0;
+    }
+
+    size_t DecodeSamples(size_t sample_count, s16 *data) {
+        const u64 frames = std::min<u64>(sample_count / pcm_cache::CHANNELS, this->m_total - this->m_position);
+
+        const auto bytes_read = ReadFileUnbuffered(data, frames * pcm_cache::FRAME_SIZE);
+        const u64 got = bytes_read / pcm_cache::FRAME_SIZE;
+        if (bytes_read != got * pcm_cache::FRAME_SIZE) {
+            SeekFile(-s64(bytes_read - got * pcm_cache::FRAME_SIZE), SeekOrigin_CUR);
+        }
+
+        this->m_position += got;
+        return got * pcm_cache::FRAME_SIZE;
+    }
+
+    u64 GetPosition() {
+        return this->m_position;
+    }
+
+    u64 GetTotal() {
+        return this->m_total;
+    }
+
+    bool SeekFrames(u64 target) {
+        target = std::min(target, this->m_total);
+        if (!SeekFile(pcm_cache::DATA_OFFSET + target * pcm_cache::FRAME_SIZE, SeekOrigin_SET)) {
+            return false;
+        }
+
+        this->m_position = target;
+        return true;
+    }
+
+    int GetSampleRate() override {
+        return pcm_cache::SAMPLE_RATE;
+    }
+
+    int GetChannelCount() override {
+        return pcm_cache::CHANNELS;
+    }
+};
+
+#ifdef WANT_BFSTM
+namespace nw_stream = tune::impl::nw_stream;
+
+class BfstmFile final : public SourceBase<BfstmFile> {
+  private:
+    nw_stream::Decoder m_decoder;
+    bool m_open{};
+
+  public:
+    BfstmFile(FsFile &&file, const char *path) : SourceBase(std::move(file), path) {
+        if (!this->m_decoder.Open(ReadAtCallback, this, GetFileSize())) {
+            return;
+        }
+        this->m_open = true;
+
+        // the loop runs to the end of the stream and, like in the games, forever unless stream_loops is set.
+        if (const auto &info = this->m_decoder.GetInfo(); info.loop) {
+            SetLoopPoints(info.loop_start, info.total_samples, g_stream_loops ? g_stream_loops : LOOP_FOREVER);
+        }
+    }
+
+    bool IsOpen() override {
+        return this->m_open;
+    }
+
+    size_t DecodeSamples(size_t sample_count, s16 *data) {
+        const auto channels = GetChannelCount();
+        return this->m_decoder.Decode(data, sample_count / channels) * channels * sizeof(s16);
+    }
+
+    u64 GetPosition() {
+        return this->m_decoder.GetPosition();
+    }
+
+    u64 GetTotal() {
+        return this->m_decoder.GetInfo().total_samples;
+    }
+
+    bool SeekFrames(u64 target) {
+        return this->m_decoder.Seek(target);
+    }
+
+    int GetSampleRate() override {
+        return this->m_decoder.GetInfo().sample_rate;
+    }
+
+    int GetChannelCount() override {
+        return this->m_decoder.GetChannelCount();
+    }
+
+  private:
+    static bool ReadAtCallback(void *user, s64 offset, void *buffer, u64 size) {
+        auto source = static_cast<Source *>(user);
+
+        return source->SeekFile(offset, SeekOrigin_SET) && source->ReadFile(buffer, size) == size;
+    }
+};
+#endif
+
+#ifdef WANT_OGG
+namespace vorbis = tune::impl::vorbis;
+
+class VorbisFile final : public SourceBase<VorbisFile> {
+  private:
+    vorbis::Decoder m_decoder;
+    bool m_open{};
+
+  public:
+    VorbisFile(FsFile &&file, const char *path) : SourceBase(std::move(file), path) {
+        LoopTags tags;
+        const auto alloc = m_arena.GetCallbacks<vorbis::AllocationCallbacks>();
+        if (!this->m_decoder.Open(ReadAtCallback, this, GetFileSize(), alloc, CommentCallback, &tags)) {
+            return;
+        }
+        this->m_open = true;
+
+        if (u64 start, end; ResolveLoopTags(tags, GetTotal(), &start, &end)) {
+            SetLoopPoints(start, end, TAGGED_LOOP_COUNT);
+        }
+    }
+
+    bool IsOpen() override {
+        return this->m_open;
+    }
+
+    size_t DecodeSamples(size_t sample_count, s16 *data) {
+        const auto channels = GetChannelCount();
+        return this->m_decoder.Decode(data, sample_count / channels) * channels * sizeof(s16);
+    }
+
+#ifdef WANT_FLOAT
+    // vorbis synthesis is float, this skips the round trip through s16.
+    bool CanDecodeFloat() override {
+        return true;
+    }
+
+    size_t DecodeSamples(size_t sample_count, float *data) {
+        const auto channels = GetChannelCount();
+        return this->m_decoder.Decode(data, sample_count / channels) * channels * sizeof(float);
+    }
+#endif
+
+    u64 GetPosition() {
+        return this->m_decoder.GetPosition();
+    }
+
+    u64 GetTotal() {
+        return this->m_decoder.GetInfo().total_frames;
+    }
+
+    bool SeekFrames(u64 target) {
+        return this->m_decoder.Seek(target);
+    }
+
+    int GetSampleRate() override {
+        return this->m_decoder.GetInfo().sample_rate;
+    }
+
+    int GetChannelCount() override {
+        return this->m_decoder.GetInfo().channels;
+    }
+
+  private:
+    static bool ReadAtCallback(void *user, s64 offset, void *buffer, u64 size) {
+        auto source = static_cast<Source *>(user);
+
+        return source->SeekFile(offset, SeekOrigin_SET) && source->ReadFile(buffer, size) == size;
+    }
+
+    static void CommentCallback(void *user, const char *comment, size_t size) {
+        if (const auto eq = static_cast<const char *>(std::memchr(comment, '=', size))) {
+            ParseLoopTag(comment, eq - comment, eq + 1, comment + size - eq - 1, static_cast<LoopTags *>(user));
+        }
+    }
+};
+#endif
+
+namespace {
+
+    // enough for every probe below, comes out of the sdmc page cache the decoder reads next.
+    constexpr size_t PROBE_SIZE = 40;
+
+#ifdef WANT_FLAC
+    bool ProbeFlac(const u8 *data, size_t size) {
+        return size >= 4 && !std::memcmp(data, "fLaC", 4);
+    }
+#endif
+
+#if defined(WANT_FLAC) && defined(WANT_OGG)
+    // offset of the first packet in the first page, the flac mapping header.
+    size_t OggFirstPacket(const u8 *data, size_t size) {
+        if (size < 27 || std::memcmp(data, "OggS", 4)) {
+            return 0;
+        }
+        return 27 + data[26];
+    }
+
+    bool ProbeOgg(const u8 *data, size_t size) {
+        const auto packet = OggFirstPacket(data, size);
+        return packet && packet + 5 <= size && data[packet] == 0x7F && !std::memcmp(data + packet + 1, "FLAC", 4);
+    }
+#endif
 
-    if (false) {}
 #ifdef WANT_MP3
-    else if (type == SourceType::MP3) {
-        return std::make_unique<Mp3File>(std::move(file));
+    bool ProbeMp3(const u8 *data, size_t size) {
+        if (size >= 3 && !std::memcmp(data, "ID3", 3)) {
+            return true;
+        }
+
+        // frame sync, a valid layer, bitrate and sample rate.
+        return size >= 4 && data[0] == 0xFF && (data[1] & 0xE0) == 0xE0 && (data[1] & 0x06) != 0 &&
+               (data[2] & 0xF0) != 0xF0 && (data[2] & 0x0C) != 0x0C;
+    }
+#endif
+
+#ifdef WANT_WAV
+    bool ProbeWav(const u8 *data, size_t size) {
+        if (size < 12) {
+            return false;
+        }
+
+        const bool riff = !std::memcmp(data, "RIFF", 4) || !std::memcmp(data, "RIFX", 4) || !std::memcmp(data, "RF64", 4);
+        const bool form = !std::memcmp(data, "FORM", 4);
+        return (riff && !std::memcmp(data + 8, "WAVE", 4)) ||
+               (form && (!std::memcmp(data + 8, "AIFF", 4) || !std::memcmp(data + 8, "AIFC", 4))) ||
+               !std::memcmp(data, "riff", 4); // wave64 guid
+    }
+#endif
+
+    bool ReadAt(FsFile *file, const sdmc::FileKey &key, s64 offset, void *buffer, u64 size) {
+        u64 bytes_read = 0;
+        return R_SUCCEEDED(sdmc::ReadFile(file, key, offset, buffer, size, &bytes_read)) && bytes_read == size;
+    }
+
+#if defined(WANT_BFSTM) || defined(WANT_OGG)
+    // lets the parsers shared with the decoders read through the sdmc page cache.
+    struct InfoReader {
+        FsFile *file;
+        const sdmc::FileKey *key;
+    };
+#endif
+
+#ifdef WANT_BFSTM
+    bool InfoBfstm(FsFile *file, const sdmc::FileKey &key, ProbeInfo *out) {
+        InfoReader reader{file, &key};
+        const auto read = [](void *user, s64 offset, void *buffer, u64 size) {
+            const auto reader = static_cast<InfoReader *>(user);
+            return ReadAt(reader->file, *reader->key, offset, buffer, size);
+        };
+
+        nw_stream::StreamInfo info;
+        if (!nw_stream::ParseHeader(read, &reader, key.size, &info)) {
+            return false;
+        }
+
+        out->sample_rate     = info.sample_rate;
+        out->channels        = std::min(info.channels, nw_stream::CHANNELS_MAX);
+        out->bits_per_sample = info.codec == nw_stream::Codec::Pcm16 ? 16 : info.codec == nw_stream::Codec::Pcm8 ? 8 : 0;
+        out->total_frames    = info.total_samples;
+        out->bitrate_kbps    = u64(key.size) * 8 * info.sample_rate / info.total_samples / 1000;
+        return true;
     }
 #endif
+
 #ifdef WANT_FLAC
-    else if (type == SourceType::FLAC) {
-        return std::make_unique<FlacFile>(std::move(file));
+    // streaminfo is always the first block, the rest (pictures, padding) is only stepped over.
+    bool InfoFlac(FsFile *file, const sdmc::FileKey &key, ProbeInfo *out) {
+        u8 streaminfo[4 + 4 + 34];
+        if (!ReadAt(file, key, 0, streaminfo, sizeof(streaminfo)) || (streaminfo[4] & 0x7F) != 0) {
+            return false;
+        }
+
+        const auto info = streaminfo + 8;
+        out->sample_rate     = info[10] << 12 | info[11] << 4 | info[12] >> 4;
+        out->channels        = ((info[12] >> 1) & 0x7) + 1;
+        out->bits_per_sample = ((info[12] & 0x1) << 4 | info[13] >> 4) + 1;
+        out->total_frames    = u64(info[13] & 0xF) << 32 | ReadBE32(info + 14);
+
+        // walk the block headers to find where the audio starts, for the bitrate.
+        s64 offset = 4;
+        for (bool last = false; !last;) {
+            u8 header[4];
+            if (!ReadAt(file, key, offset, header, sizeof(header))) {
+                return false;
+            }
+            last = header[0] & 0x80;
+            offset += 4 + (header[1] << 16 | header[2] << 8 | header[3]);
+        }
+
+        if (out->total_frames && out->sample_rate && key.size > offset) {
+            out->bitrate_kbps = u64(key.size - offset) * 8 * out->sample_rate / out->total_frames / 1000;
+        }
+
+        return out->sample_rate != 0;
+    }
+#endif
+
+#ifdef WANT_OGG
+    bool InfoVorbis(FsFile *file, const sdmc::FileKey &key, ProbeInfo *out) {
+        InfoReader reader{file, &key};
+        const auto read = [](void *user, s64 offset, void *buffer, u64 size) {
+            const auto reader = static_cast<InfoReader *>(user);
+            return ReadAt(reader->file, *reader->key, offset, buffer, size);
+        };
+
+        vorbis::StreamInfo info;
+        if (!vorbis::ParseInfo(read, &reader, key.size, &info)) {
+            return false;
+        }
+
+        out->sample_rate  = info.sample_rate;
+        out->channels     = info.channels;
+        out->total_frames = info.total_frames;
+        // the nominal rate is only a hint and often unset, the file size is what the track really takes.
+        if (info.total_frames) {
+            out->bitrate_kbps = u64(key.size) * 8 * info.sample_rate / info.total_frames / 1000;
+        } else {
+            out->bitrate_kbps = info.bitrate_nominal / 1000;
+        }
+        return true;
+    }
+#endif
+
+#if defined(WANT_FLAC) && defined(WANT_OGG)
+    // the first page holds the mapping header followed by a plain streaminfo block.
+    bool InfoOgg(FsFile *file, const sdmc::FileKey &key, ProbeInfo *out) {
+        u8 page[27 + 255];
+        if (!ReadAt(file, key, 0, page, 27) || !ReadAt(file, key, 27, page + 27, page[26])) {
+            return false;
+        }
+
+        u8 header[9 + 4 + 4 + 34];
+        const auto packet = OggFirstPacket(page, 27 + page[26]);
+        if (!packet || !ReadAt(file, key, packet, header, sizeof(header)) || header[0] != 0x7F || std::memcmp(header + 1, "FLAC", 4) ||
+            std::memcmp(header + 9, "fLaC", 4) || (header[13] & 0x7F) != 0) {
+            return false;
+        }
+
+        const auto info = header + 17;
+        out->sample_rate     = info[10] << 12 | info[11] << 4 | info[12] >> 4;
+        out->channels        = ((info[12] >> 1) & 0x7) + 1;
+        out->bits_per_sample = ((info[12] & 0x1) << 4 | info[13] >> 4) + 1;
+        out->total_frames    = u64(info[13] & 0xF) << 32 | ReadBE32(info + 14);
+
+        // page overhead is small enough to leave in.
+        if (out->total_frames && out->sample_rate) {
+            out->bitrate_kbps = u64(key.size) * 8 * out->sample_rate / out->total_frames / 1000;
+        }
+
+        return out->sample_rate != 0;
+    }
+#endif
+
+#ifdef WANT_MP3
+    // first frame header after the id3v2 tag, plus the xing/info/vbri tag inside that frame.
+    bool InfoMp3(FsFile *file, const sdmc::FileKey &key, ProbeInfo *out) {
+        s64 start = 0;
+        u8 id3[10];
+        if (ReadAt(file, key, 0, id3, sizeof(id3)) && !std::memcmp(id3, "ID3", 3)) {
+            start = 10 + (id3[6] << 21 | id3[7] << 14 | id3[8] << 7 | id3[9]);
+            if (id3[5] & 0x10) {
+                start += 10; // footer
+            }
+        }
+
+        u8 frame[4 + 32 + 2 + 4 + 8 + 4];
+        if (!ReadAt(file, key, start, frame, sizeof(frame))) {
+            return false;
+        }
+
+        const auto h = frame;
+        if (h[0] != 0xFF || (h[1] & 0xE0) != 0xE0 || !drmp3_hdr_valid(h)) {
+            return false;
+        }
+
+        const u64 frame_samples = drmp3_hdr_frame_samples(h);
+        out->sample_rate  = drmp3_hdr_sample_rate_hz(h);
+        out->channels     = DRMP3_HDR_IS_MONO(h) ? 1 : 2;
+        out->bitrate_kbps = drmp3_hdr_bitrate_kbps(h);
+
+        // side info size decides where the xing tag sits.
+        u32 xing = 4 + (DRMP3_HDR_IS_CRC(h) ? 2 : 0);
+        if (DRMP3_HDR_TEST_MPEG1(h)) {
+            xing += DRMP3_HDR_IS_MONO(h) ? 17 : 32;
+        } else {
+            xing += DRMP3_HDR_IS_MONO(h) ? 9 : 17;
+        }
+
+        if (xing + 12 <= sizeof(frame) && (!std::memcmp(frame + xing, "Xing", 4) || !std::memcmp(frame + xing, "Info", 4)) && (frame[xing + 7] & 0x1)) {
+            out->total_frames = ReadBE32(frame + xing + 8) * frame_samples;
+        } else if (!std::memcmp(frame + 36, "VBRI", 4)) {
+            out->total_frames = ReadBE32(frame + 36 + 14) * frame_samples;
+        }
+
+        // a tag size past the end of the file leaves no audio to estimate from, not a huge length.
+        const u64 audio_size = std::max<s64>(key.size - start, 0);
+        if (out->total_frames) {
+            if (out->sample_rate) {
+                out->bitrate_kbps = audio_size * 8 * out->sample_rate / out->total_frames / 1000;
+            }
+        } else if (out->bitrate_kbps) {
+            out->total_frames    = audio_size * 8 * out->sample_rate / (out->bitrate_kbps * 1000);
+            out->total_estimated = true;
+        }
+
+        return out->sample_rate != 0;
     }
 #endif
+
 #ifdef WANT_WAV
-    else if (type == SourceType::WAV) {
-        return std::make_unique<WavFile>(std::move(file));
+    // plain riff/rifx only, other containers can be played but not probed.
+    bool InfoWav(FsFile *file, const sdmc::FileKey &key, ProbeInfo *out) {
+        u8 riff[12];
+        if (!ReadAt(file, key, 0, riff, sizeof(riff)) || std::memcmp(riff + 8, "WAVE", 4)) {
+            return false;
+        }
+
+        const bool be = !std::memcmp(riff, "RIFX", 4);
+        if (!be && std::memcmp(riff, "RIFF", 4)) {
+            return false;
+        }
+
+        const auto read16 = [be](const u8 *d) -> u32 { return be ? (d[0] << 8 | d[1]) : (d[1] << 8 | d[0]); };
+        const auto read32 = [be](const u8 *d) -> u32 { return be ? ReadBE32(d) : ReadLE32(d); };
+
+        u32 block_align = 0;
+        for (s64 offset = 12; offset + 8 <= key.size;) {
+            u8 chunk[8 + 16];
+            if (!ReadAt(file, key, offset, chunk, 8)) {
+                return false;
+            }
+
+            const u32 size = read32(chunk + 4);
+            if (!std::memcmp(chunk, "fmt ", 4)) {
+                if (size < 16 || !ReadAt(file, key, offset + 8, chunk + 8, 16)) {
+                    return false;
+                }
+                out->channels        = read16(chunk + 10);
+                out->sample_rate     = read32(chunk + 12);
+                out->bitrate_kbps    = u64(read32(chunk + 16)) * 8 / 1000;
+                block_align          = read16(chunk + 20);
+                out->bits_per_sample = read16(chunk + 22);
+            } else if (!std::memcmp(chunk, "data", 4)) {
+                if (!block_align) {
+                    return false;
+                }
+                out->total_frames = std::min<s64>(size, key.size - offset - 8) / block_align;
+                return out->sample_rate != 0;
+            }
+
+            // chunks are padded to an even size.
+            offset += 8 + size + (size & 1);
+        }
+
+        return false;
     }
 #endif
-    else {
-        fsFileClose(&file);
+
+    template<typename T>
+    std::unique_ptr<Source> Open(FsFile &&file, const char *path) {
+        auto source = std::make_unique<T>(std::move(file), path);
+        if (source->IsOpen()) {
+            source->Publish();
+        }
+        return source;
+    }
+
+    struct Decoder {
+        SourceType type;
+        const char *extensions[3];
+        bool (*probe)(const u8 *data, size_t size);
+        std::unique_ptr<Source> (*open)(FsFile &&file, const char *path);
+        // header only metadata, the probe fails when it returns false.
+        bool (*info)(FsFile *file, const sdmc::FileKey &key, ProbeInfo *out);
+    };
+
+    // probes are checked strongest first, mp3 frame sync is the easiest to hit by accident.
+    constexpr Decoder DECODERS[] = {
+#ifdef WANT_FLAC
+        {SourceType::FLAC, {".flac"}, ProbeFlac, Open<FlacFile>, InfoFlac},
+#endif
+#ifdef WANT_OGG
+        {SourceType::OGG, {".ogg", ".oga"}, vorbis::Probe, Open<VorbisFile>, InfoVorbis},
+#endif
+#if defined(WANT_FLAC) && defined(WANT_OGG)
+        // flac in ogg shares the extensions, it is found by probing once vorbis doesn't match.
+        {SourceType::OGG, {}, ProbeOgg, Open<FlacFile>, InfoOgg},
+#endif
+#ifdef WANT_WAV
+        {SourceType::WAV, {".wav", ".wave"}, ProbeWav, Open<WavFile>, InfoWav},
+#endif
+#ifdef WANT_BFSTM
+        {SourceType::BFSTM, {".bfstm", ".bcstm", ".brstm"}, nw_stream::Probe, Open<BfstmFile>, InfoBfstm},
+#endif
+#ifdef WANT_MP3
+        {SourceType::MP3, {".mp3"}, ProbeMp3, Open<Mp3File>, InfoMp3},
+#endif
+        {SourceType::NONE, {}, nullptr, nullptr, nullptr},
+    };
+
+    const Decoder *FindDecoder(SourceType type) {
+        for (const auto &decoder : DECODERS) {
+            if (decoder.type == type) {
+                return &decoder;
+            }
+        }
+        return nullptr;
+    }
+
+}
+
+namespace {
+
+    // opens the file and picks the decoder, the file is closed again on failure.
+    const Decoder *SelectDecoder(const char *path, FsFile *file, sdmc::FileKey *key) {
+        const auto type = GetSourceType(path);
+        if (type == SourceType::NONE)
+            return nullptr;
+
+        if (R_FAILED(sdmc::OpenFile(file, path)))
+            return nullptr;
+
+        u8 header[PROBE_SIZE];
+        u64 header_size = 0;
+        s64 file_size = 0;
+        if (R_FAILED(fsFileGetSize(file, &file_size)) ||
+            R_FAILED(sdmc::ReadFile(file, *key = sdmc::MakeFileKey(path, file_size), 0, header, sizeof(header), &header_size))) {
+            fsFileClose(file);
+            return nullptr;
+        }
+
+        // trust the extension if the content agrees, otherwise go by content.
+        auto decoder = FindDecoder(type);
+        if (!decoder->probe(header, header_size)) {
+            decoder = nullptr;
+            for (const auto &it : DECODERS) {
+                if (it.probe && it.probe(header, header_size)) {
+                    decoder = &it;
+                    break;
+                }
+            }
+        }
+
+        if (!decoder) {
+            fsFileClose(file);
+        }
+
+        return decoder;
+    }
+
+}
+
+std::unique_ptr<Source> OpenFile(const char *path) {
+    FsFile file;
+    sdmc::FileKey key;
+
+    char cache_path[FS_MAX_PATH];
+    if (pcm_cache::Entry entry; pcm_cache::Open(path, &file, cache_path, sizeof(cache_path), &entry)) {
+        auto source = std::make_unique<PcmFile>(std::move(file), cache_path, entry);
+        if (source->IsOpen()) {
+            source->Publish();
+            return source;
+        }
+    }
+
+    const auto decoder = SelectDecoder(path, &file, &key);
+    if (!decoder) {
         return nullptr;
     }
+
+    return decoder->open(std::move(file), path);
+}
+
+bool Probe(const char *path, ProbeInfo *out) {
+    FsFile file;
+    sdmc::FileKey key;
+
+    const auto decoder = SelectDecoder(path, &file, &key);
+    if (!decoder) {
+        return false;
+    }
+
+    // never opens a decoder, a probe may run while two tracks already hold theirs.
+    *out = {};
+    out->type = decoder->type;
+    const bool ok = decoder->info && decoder->info(&file, key, out);
+    fsFileClose(&file);
+    return ok;
+}
+
+void SetPreloadSizeMax(s64 size) {
+    std::scoped_lock lk(g_preload_mutex);
+    g_preload_size_max = size;
+    if (!size) {
+        g_last_preload.reset();
+    }
+}
+
+void SetParallelDecode(bool enable) {
+    g_parallel_decode = enable;
+}
+
+void SetDither(bool enable) {
+    g_dither = enable;
+}
+
+void SetStreamLoops(u32 count) {
+    g_stream_loops = count;
 }
 
 SourceType GetSourceType(const char* path) {
@@ -465,12 +1835,12 @@ SourceType GetSourceType(const char* path) {
         return SourceType::NONE;
     }
 
-    if (!strcasecmp(ext, ".mp3")) {
-        return SourceType::MP3;
-    } else if (!strcasecmp(ext, ".flac")) {
-        return SourceType::FLAC;
-    } else if (!strcasecmp(ext, ".wav") || !strcasecmp(ext, ".wave")) {
-        return SourceType::WAV;
+    for (const auto &decoder : DECODERS) {
+        for (const auto extension : decoder.extensions) {
+            if (extension && !strcasecmp(ext, extension)) {
+                return decoder.type;
+            }
+        }
     }
 
     return SourceType::NONE;
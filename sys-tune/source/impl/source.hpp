@@ -1,14 +1,23 @@
 #pragma once
 
 #include <nxExt.h>
+#include <atomic>
 #include <memory>
+#include <type_traits>
 #include "resamplers/SDL_audioEX.h"
+#include "read_ahead.hpp"
+#include "arena.hpp"
 
+struct Preload;
+
+// same order as TuneCodec.
 enum class SourceType {
     NONE,
     MP3,
     FLAC,
     WAV,
+    BFSTM,
+    OGG,
 };
 
 class Source {
@@ -16,6 +25,13 @@ class Source {
     FsFile m_file = {};
     s64 m_offset = 0;
     s64 m_size = 0;
+    sdmc::FileKey m_key;
+    // reads the next block of the file while the current one is decoded.
+    ReadAhead m_read_ahead;
+    // set when the whole file fits in memory, m_read_ahead is unused then.
+    std::shared_ptr<const Preload> m_preload;
+    // the source only reads with ReadFileUnbuffered, m_read_ahead is released for good.
+    bool m_unbuffered{};
 
   protected:
     // SOURCE: https://dev.krzaq.cc/post/you-dont-need-a-stateful-deleter-in-your-unique_ptr-usually/
@@ -30,46 +46,305 @@ class Source {
     template<auto func>
     using Deleter = FunctionCaller<func>;
 
-    template<size_t Size>
-    struct BufferedFileData {
-        u8 data[Size];
-        s64 off;
-        s64 size;
-  };
-
   protected:
+    // per source, so the next track can be opened while the current one still plays.
     // increasing the size of this buffer also increases the memory used by the resampler.
-    static inline std::array<s16, 1024 * 4> m_resample_buffer;
-    // increasing this reduces io calls.
-    static inline BufferedFileData<1024 * 64> m_buffered;
-    LockableMutex m_mutex;
+    std::array<s16, 1024 * 4> m_resample_buffer;
+#ifdef WANT_FLOAT
+    // same job and byte size as m_resample_buffer for sources decoding to float. it
+    // also takes the stream's float output before ConvertOut() writes the block.
+    std::array<float, 1024 * 2> m_float_buffer;
+#endif
+    // decoder allocations, released in one go when the source closes.
+    Arena m_arena;
 
-  private:
+  protected:
     using UniqueAudioStream = std::unique_ptr<SDL_AudioStream, Deleter<&SDL_FreeAudioStreamEX>>;
     UniqueAudioStream m_sdl_stream{nullptr};
     bool m_native_stream{};
+    // set once the resampler tail has been pushed out at the end of the track.
+    bool m_stream_flushed{};
+    // set instead of a stream when only the channel count differs.
+    SDL_ChannelMapFuncEX m_channel_map{};
+    // channels of the blocks handed to audout.
+    int m_output_channels{};
+#ifdef WANT_FLOAT
+    // the decoder writes float into a float stream, nothing is converted until ConvertOut().
+    bool m_float_stream{};
+    // per source, so the next track doesn't pick up the current one's sequence.
+    u32 m_dither[4]{0x9E3779B9, 0x7F4A7C15, 0x94D049BB, 0xBF58476D};
+#endif
+
+    // channels of what Decode writes, the output channels when passing through.
+    int m_frame_channels{};
+    // wrap points, m_loop_end is exclusive and 0 wraps at the end of the file.
+    u64 m_loop_start{};
+    u64 m_loop_end{};
+    bool m_repeat{};
+    // loops are played this many more times before the track runs on to its end.
+    u32 m_loops_left{};
+    // what m_loops_left started at, for the pcm cache.
+    u32 m_loop_count{};
+
+  private:
+    // written by the decode thread after every block, read by anyone without a lock.
+    std::atomic<u64> m_position{};
+    std::atomic<u64> m_total{};
 
   public:
-    Source(FsFile &&file);
+    Source(FsFile &&file, const char *path);
     virtual ~Source();
 
-    bool SetupResampler(int output_channels, int output_sample_rate);
-    s64 Resample(u8* out, std::size_t size);
+    // quality only matters when the rate has to change.
+    bool SetupResampler(int output_channels, int output_sample_rate, SDL_ResamplerQualityEX quality);
+    // fills a whole output block, one virtual call per block.
+    virtual s64 Resample(u8* out, std::size_t size) = 0;
 
     size_t ReadFile(void *buffer, size_t read_size);
+    // reads straight into buffer, for sources that can decode without a copy.
+    size_t ReadFileUnbuffered(void *buffer, size_t read_size);
     s64 TellFile();
+    s64 GetFileSize() const;
+    const ReadAhead &GetReadAhead() const;
     bool SeekFile(s64 offset, int origin);
 
+  private:
+    size_t ReadPreload(void *buffer, size_t read_size);
+
+  public:
+
     virtual bool IsOpen() = 0;
-    virtual size_t Decode(size_t sample_count, s16 *data) = 0;
-    virtual std::pair<u32, u32> Tell() = 0;
+    // decode thread only, other threads go through the player's seek target.
     virtual bool Seek(u64 target) = 0;
+    // position as of the last decoded block, safe from any thread.
+    std::pair<u32, u32> Tell() const;
 
     bool Done();
+    // the decoder goes back to the loop start instead of running on to the end.
+    bool WillWrap() const;
+    // repeat-one, wraps at the loop points in place instead of ending the track.
+    void SetRepeat(bool repeat);
+    // hands over the tagged loop and plays straight through it, false if there is none.
+    bool TakeLoopPoints(u64 *start, u64 *end, u32 *count);
+
+    // frees the read-ahead window while playback is suspended. the decoder, its
+    // position and the resampler history stay, so Resume() carries on where it was.
+    void Suspend();
+    void Resume();
+
+  protected:
+    void SetPosition(u64 current, u64 total);
+    // m_loops_left never runs out, the track plays until it is skipped.
+    static constexpr u32 LOOP_FOREVER = UINT32_MAX;
+
+    // from LOOPSTART/LOOPLENGTH/LOOPEND tags or the stream header, in frames.
+    void SetLoopPoints(u64 start, u64 end, u32 count);
+    // for sources that never go through ReadFile.
+    void DisableReadAhead();
+
+    // sources that can write output samples directly, without the resampler, return true.
+    virtual bool SetupPassthrough(int output_channels, int output_sample_rate) {
+        return false;
+    }
+
+#ifdef WANT_FLOAT
+    // sources with a float DecodeSamples return true when it can be used for this track.
+    virtual bool CanDecodeFloat() {
+        return false;
+    }
+    // the one float to s16 conversion, dithered when that is enabled.
+    void ConvertOut(const float *in, s16 *out, int samples);
+#endif
+
+  public:
 
     virtual int GetSampleRate() = 0;
     virtual int GetChannelCount() = 0;
 };
 
+// the decoders implement DecodeSamples, SeekFrames, GetPosition and GetTotal
+// without locking, the per sample path is resolved at compile time.
+template<typename Derived>
+class SourceBase : public Source {
+  public:
+    using Source::Source;
+
+    s64 Resample(u8* out, std::size_t size) final {
+        if (!out || !size) {
+            return -1;
+        }
+
+        const auto result = ResampleBlock(out, size);
+        Publish();
+        return result;
+    }
+
+    bool Seek(u64 target) final {
+        const auto result = Self().SeekFrames(target);
+        Publish();
+        return result;
+    }
+
+    void Publish() {
+        SetPosition(Self().GetPosition(), Self().GetTotal());
+    }
+
+  private:
+    Derived &Self() {
+        return static_cast<Derived &>(*this);
+    }
+
+    // decodes up to the loop end, then carries on from the loop start without
+    // touching the file handle, decoder or resampler history.
+    template<typename T>
+    size_t Decode(size_t sample_count, T *data) {
+        if (!WillWrap()) {
+            return Self().DecodeSamples(sample_count, data);
+        }
+
+        for (int attempt = 0; attempt < 2; attempt++) {
+            const auto position = Self().GetPosition();
+            if (m_loop_end && position >= m_loop_end) {
+                Wrap();
+                continue;
+            }
+
+            const auto count = m_loop_end ? std::min<u64>(sample_count, (m_loop_end - position) * m_frame_channels) : sample_count;
+            if (const auto got = Self().DecodeSamples(count, data)) {
+                return got;
+            }
+
+            // the file ended before the loop end, or there is nothing left to wrap to.
+            if (position == m_loop_start) {
+                return 0;
+            }
+            Wrap();
+        }
+
+        return 0;
+    }
+
+    void Wrap() {
+        if (!m_repeat && m_loops_left != LOOP_FOREVER) {
+            m_loops_left--;
+        }
+        Self().SeekFrames(m_loop_start);
+    }
+
+    s64 ResampleBlock(u8* out, std::size_t size) {
+        if (m_native_stream) {
+            return Decode(size / sizeof(s16), (s16*)out);
+        }
+
+        if (m_channel_map) {
+            return MapChannels(out, size);
+        }
+
+#ifdef WANT_FLOAT
+        if constexpr (requires(Derived &source, float *data) { source.DecodeSamples(std::size_t{}, data); }) {
+            if (m_float_stream) {
+                return ResampleStream(out, size, m_float_buffer.data(), m_float_buffer.size());
+            }
+        }
+#endif
+
+        return ResampleStream(out, size, m_resample_buffer.data(), m_resample_buffer.size());
+    }
+
+    // decodes a buffer at a time and mixes it straight into out.
+    s64 MapChannels(u8* out, std::size_t size) {
+        const auto in_frame = m_frame_channels * sizeof(s16);
+        const auto out_frame = m_output_channels * sizeof(s16);
+
+        s64 data_read = 0;
+        while (size >= out_frame) {
+            const auto frames = std::min(size / out_frame, m_resample_buffer.size() / m_frame_channels);
+            const auto got = Decode(frames * m_frame_channels, m_resample_buffer.data()) / in_frame;
+            if (!got) {
+                break;
+            }
+
+            m_channel_map(m_resample_buffer.data(), (s16*)out, got);
+            size -= got * out_frame;
+            out += got * out_frame;
+            data_read += got * out_frame;
+        }
+
+        return data_read;
+    }
+
+    // buffer takes the decoded samples, and the stream output first when that is float.
+    template<typename T>
+    s64 ResampleStream(u8* out, std::size_t size, T *buffer, std::size_t buffer_size) {
+        s64 data_read = 0;
+        while (size > 0) {
+            int sz;
+#ifdef WANT_FLOAT
+            if constexpr (std::is_same_v<T, float>) {
+                const auto samples = std::min(size / sizeof(s16), buffer_size) / m_output_channels * m_output_channels;
+                sz = SDL_AudioStreamGetEX(m_sdl_stream.get(), buffer, samples * sizeof(float));
+                if (sz > 0) {
+                    ConvertOut(buffer, (s16*)out, sz / sizeof(float));
+                    sz = sz / sizeof(float) * sizeof(s16);
+                }
+            } else
+#endif
+            {
+                sz = SDL_AudioStreamGetEX(m_sdl_stream.get(), out, size);
+            }
+
+            if (sz < 0) {
+                return -1;
+            } else if (sz > 0) {
+                size -= sz;
+                out += sz;
+                data_read += sz;
+            } else {
+                const auto dec_got = Decode(buffer_size, buffer);
+                if (dec_got == 0) {
+                    // push out the samples the resampler holds back for padding, so
+                    // the track ends on its last sample and the next one follows without a gap.
+                    if (!m_stream_flushed) {
+                        m_stream_flushed = true;
+                        if (0 != SDL_AudioStreamFlushEX(m_sdl_stream.get())) {
+                            return -1;
+                        }
+                        continue;
+                    }
+                    return data_read;
+                }
+                m_stream_flushed = false;
+                if (0 != SDL_AudioStreamPutEX(m_sdl_stream.get(), buffer, dec_got)) {
+                    return -1;
+                }
+            }
+        }
+
+        return data_read;
+    }
+};
+
+// what a track is, read from its headers only.
+struct ProbeInfo {
+    SourceType type;
+    u32 sample_rate;
+    u32 channels;
+    // 0 for lossy codecs.
+    u32 bits_per_sample;
+    u64 total_frames;
+    u32 bitrate_kbps;
+    // total_frames was worked out from the bitrate.
+    bool total_estimated;
+};
+
 std::unique_ptr<Source> OpenFile(const char *path);
+bool Probe(const char *path, ProbeInfo *out);
+// files up to this size are read into memory on open, 0 disables it.
+void SetPreloadSizeMax(s64 size);
+// hi-res flac opened after this is split with the decode worker, if it is running.
+void SetParallelDecode(bool enable);
+// triangular dither on the float to s16 conversion of WANT_FLOAT builds.
+void SetDither(bool enable);
+// extra plays of a bfstm/brstm loop, 0 loops until the track is skipped.
+void SetStreamLoops(u32 count);
 SourceType GetSourceType(const char* path);
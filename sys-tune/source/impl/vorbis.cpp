@@ -0,0 +1,1709 @@
+#ifdef WANT_OGG
+
+#include "vorbis.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+// follows the vorbis i specification, https://xiph.org/vorbis/doc/Vorbis_I_spec.html
+namespace tune::impl::vorbis {
+
+    struct Codebook {
+        u32 dimensions;
+        u32 entries;
+        // codeword length of every entry, 0 for entries that are never coded.
+        u8 *lengths;
+        // entry for the next FAST_BITS bits of the packet, -1 if the codeword is longer.
+        s16 *fast;
+        // the longer codewords, left aligned and sorted, with their entries.
+        u32 *codewords;
+        u32 *values;
+        u32 sorted_count;
+        // entries * dimensions for an explicit vq lookup.
+        float *vectors;
+        // a lattice lookup keeps only the values each dimension picks from.
+        float *multiplicands;
+        u32 lookup_values;
+        bool sequence;
+    };
+
+    struct Floor1 {
+        u8 partitions;
+        u8 partition_class[31];
+        u8 class_dimensions[16];
+        u8 class_subclasses[16];
+        u8 class_masterbook[16];
+        s16 subclass_books[16][8];
+        u8 multiplier;
+        u32 values;
+        u16 x[FLOOR1_VALUES_MAX];
+        // points in order of x, and the neighbours each point is predicted from.
+        u8 order[FLOOR1_VALUES_MAX];
+        u8 low[FLOOR1_VALUES_MAX];
+        u8 high[FLOOR1_VALUES_MAX];
+    };
+
+    struct Residue {
+        u16 type;
+        u32 begin;
+        u32 end;
+        u32 partition_size;
+        u8 classifications;
+        u8 classbook;
+        // book of every classification and pass, -1 when the pass is skipped.
+        s16 books[64][8];
+    };
+
+    struct Mapping {
+        u32 coupling_steps;
+        u8 magnitude[256];
+        u8 angle[256];
+        u8 mux[CHANNELS_MAX];
+        u8 submaps;
+        u8 submap_floor[16];
+        u8 submap_residue[16];
+    };
+
+    namespace {
+
+        constexpr u32 FAST_BITS = 8;
+        constexpr u32 FAST_SIZE = 1 << FAST_BITS;
+        // seeks bisect down to this many bytes and decode the rest.
+        constexpr s64 SEEK_LINEAR = 1024 * 16;
+        constexpr u64 NO_GRANULE = UINT64_MAX;
+
+        // floor1_inverse_dB_table from the spec.
+        constexpr float INVERSE_DB[256] = {
+            1.0649863e-07f, 1.1341951e-07f, 1.2079015e-07f, 1.2863978e-07f, 1.369995e-07f, 1.459025e-07f,
+            1.5538409e-07f, 1.6548181e-07f, 1.7623574e-07f, 1.8768856e-07f, 1.998856e-07f, 2.1287531e-07f,
+            2.2670913e-07f, 2.4144197e-07f, 2.5713223e-07f, 2.7384212e-07f, 2.9163792e-07f, 3.1059022e-07f,
+            3.307741e-07f, 3.5226967e-07f, 3.7516213e-07f, 3.995423e-07f, 4.2550681e-07f, 4.5315863e-07f,
+            4.8260745e-07f, 5.1397001e-07f, 5.4737063e-07f, 5.8294188e-07f, 6.2082472e-07f, 6.6116939e-07f,
+            7.0413591e-07f, 7.4989464e-07f, 7.9862701e-07f, 8.5052631e-07f, 9.0579829e-07f, 9.6466215e-07f,
+            1.0273513e-06f, 1.0941144e-06f, 1.1652161e-06f, 1.2409384e-06f, 1.3215816e-06f, 1.4074654e-06f,
+            1.4989305e-06f, 1.5963394e-06f, 1.7000785e-06f, 1.8105592e-06f, 1.9282195e-06f, 2.053526e-06f,
+            2.1869757e-06f, 2.3290977e-06f, 2.4804558e-06f, 2.6416496e-06f, 2.813319e-06f, 2.9961443e-06f,
+            3.1908505e-06f, 3.3982101e-06f, 3.6190449e-06f, 3.8542307e-06f, 4.1047006e-06f, 4.3714472e-06f,
+            4.6555283e-06f, 4.9580708e-06f, 5.2802739e-06f, 5.6234162e-06f, 5.9888571e-06f, 6.3780467e-06f,
+            6.7925284e-06f, 7.2339453e-06f, 7.7040477e-06f, 8.2047e-06f, 8.7378876e-06f, 9.3057251e-06f,
+            9.9104636e-06f, 1.0554501e-05f, 1.1240392e-05f, 1.1970856e-05f, 1.2748789e-05f, 1.3577278e-05f,
+            1.4459606e-05f, 1.5399271e-05f, 1.6400005e-05f, 1.7465769e-05f, 1.8600793e-05f, 1.9809577e-05f,
+            2.1096914e-05f, 2.2467912e-05f, 2.3928002e-05f, 2.5482977e-05f, 2.7139005e-05f, 2.890265e-05f,
+            3.078091e-05f, 3.2781227e-05f, 3.4911533e-05f, 3.7180282e-05f, 3.9596467e-05f, 4.2169668e-05f,
+            4.4910092e-05f, 4.7828602e-05f, 5.0936775e-05f, 5.4246932e-05f, 5.7772202e-05f, 6.1526567e-05f,
+            6.552491e-05f, 6.9783084e-05f, 7.4317984e-05f, 7.9147583e-05f, 8.4291038e-05f, 8.976875e-05f,
+            9.5602423e-05f, 0.00010181521f, 0.00010843174f, 0.00011547824f, 0.00012298267f, 0.00013097477f,
+            0.00013948625f, 0.00014855085f, 0.00015820454f, 0.00016848555f, 0.00017943469f, 0.00019109536f,
+            0.00020351382f, 0.0002167393f, 0.00023082423f, 0.00024582449f, 0.00026179955f, 0.00027881275f,
+            0.00029693157f, 0.00031622787f, 0.00033677815f, 0.00035866388f, 0.00038197188f, 0.00040679457f,
+            0.00043323037f, 0.0004613841f, 0.00049136748f, 0.00052329927f, 0.00055730622f, 0.00059352309f,
+            0.00063209358f, 0.00067317061f, 0.00071691698f, 0.00076350628f, 0.00081312325f, 0.00086596457f,
+            0.00092223985f, 0.00098217221f, 0.0010459992f, 0.0011139743f, 0.0011863665f, 0.0012634633f,
+            0.0013455702f, 0.0014330129f, 0.0015261382f, 0.0016253153f, 0.0017309374f, 0.0018434235f,
+            0.0019632196f, 0.0020908006f, 0.0022266726f, 0.0023713743f, 0.0025254795f, 0.0026895993f,
+            0.0028643848f, 0.0030505287f, 0.0032487691f, 0.0034598925f, 0.0036847359f, 0.0039241905f,
+            0.0041792067f, 0.0044507948f, 0.0047400328f, 0.0050480668f, 0.0053761187f, 0.005725489f,
+            0.0060975635f, 0.0064938175f, 0.0069158226f, 0.0073652514f, 0.0078438874f, 0.0083536273f,
+            0.0088964924f, 0.009474637f, 0.010090352f, 0.01074608f, 0.011444421f, 0.012188144f,
+            0.012980198f, 0.013823725f, 0.014722068f, 0.015678791f, 0.016697686f, 0.017782796f,
+            0.018938422f, 0.020169148f, 0.021479854f, 0.022875736f, 0.024362329f, 0.025945531f,
+            0.027631618f, 0.029427277f, 0.031339627f, 0.03337625f, 0.035545226f, 0.037855156f,
+            0.0403152f, 0.042935107f, 0.045725275f, 0.048696756f, 0.051861349f, 0.05523159f,
+            0.058820851f, 0.062643364f, 0.066714279f, 0.07104975f, 0.075666964f, 0.080584228f,
+            0.085821047f, 0.09139818f, 0.097337745f, 0.1036633f, 0.11039993f, 0.11757434f,
+            0.12521498f, 0.13335215f, 0.14201812f, 0.15124726f, 0.16107617f, 0.17154381f,
+            0.18269168f, 0.19456401f, 0.20720787f, 0.22067343f, 0.23501402f, 0.25028655f,
+            0.26655158f, 0.28387362f, 0.30232131f, 0.32196787f, 0.34289113f, 0.36517414f,
+            0.3889052f, 0.41417846f, 0.44109413f, 0.4697589f, 0.50028646f, 0.53279793f,
+            0.56742209f, 0.60429639f, 0.64356697f, 0.68538958f, 0.72993004f, 0.77736503f,
+            0.82788259f, 0.88168305f, 0.9389798f, 1.0f,
+        };
+
+        u32 ReadLE32(const u8 *p) {
+            return p[0] | p[1] << 8 | p[2] << 16 | u32(p[3]) << 24;
+        }
+
+        u64 ReadLE64(const u8 *p) {
+            return ReadLE32(p) | u64(ReadLE32(p + 4)) << 32;
+        }
+
+        // bits needed for x, 0 for 0.
+        u32 ILog(u32 x) {
+            return x ? 32 - __builtin_clz(x) : 0;
+        }
+
+        u32 BitReverse(u32 x) {
+            x = (x & 0xAAAAAAAA) >> 1 | (x & 0x55555555) << 1;
+            x = (x & 0xCCCCCCCC) >> 2 | (x & 0x33333333) << 2;
+            x = (x & 0xF0F0F0F0) >> 4 | (x & 0x0F0F0F0F) << 4;
+            x = (x & 0xFF00FF00) >> 8 | (x & 0x00FF00FF) << 8;
+            return x >> 16 | x << 16;
+        }
+
+        float Float32Unpack(u32 x) {
+            const s32 mantissa = x & 0x1FFFFF;
+            const s32 exponent = (x & 0x7FE00000) >> 21;
+            return std::ldexp(float((x & 0x80000000) ? -mantissa : mantissa), exponent - 788);
+        }
+
+        // the largest r with r^dimensions <= entries.
+        u32 Lookup1Values(u32 entries, u32 dimensions) {
+            u32 r = std::floor(std::exp(std::log(double(entries)) / dimensions));
+            const auto fits = [&](u64 base) {
+                u64 value = 1;
+                for (u32 i = 0; i < dimensions; i++) {
+                    if ((value *= base) > entries) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            while (fits(r + 1)) {
+                r++;
+            }
+            while (r && !fits(r)) {
+                r--;
+            }
+            return r;
+        }
+
+        s32 RenderPoint(s32 x0, s32 y0, s32 x1, s32 y1, s32 x) {
+            const s32 dy = y1 - y0;
+            const s32 offset = std::abs(dy) * (x - x0) / (x1 - x0);
+            return dy < 0 ? y0 - offset : y0 + offset;
+        }
+
+        // multiplies out by the floor between two points, the bresenham walk of the spec.
+        void RenderLine(s32 x0, s32 y0, s32 x1, s32 y1, float *out, s32 n) {
+            const s32 dy = y1 - y0;
+            const s32 adx = x1 - x0;
+            const s32 base = dy / adx;
+            const s32 sy = dy < 0 ? base - 1 : base + 1;
+            const s32 ady = std::abs(dy) - std::abs(base) * adx;
+            const s32 end = std::min(x1, n);
+
+            s32 y = y0;
+            s32 err = 0;
+            if (x0 < end) {
+                out[x0] *= INVERSE_DB[y & 0xFF];
+            }
+            for (s32 x = x0 + 1; x < end; x++) {
+                err += ady;
+                if (err >= adx) {
+                    err -= adx;
+                    y += sy;
+                } else {
+                    y += base;
+                }
+                out[x] *= INVERSE_DB[y & 0xFF];
+            }
+        }
+
+        // the last page of the stream that has a granule, scanning back from end.
+        s64 FindLastPage(ReadFunc read, void *user, s64 begin, s64 end, u32 serial, u8 *buffer, u32 buffer_size, u64 *granule) {
+            while (end - begin >= 27) {
+                const auto start = std::max(begin, end - s64(buffer_size));
+                if (!read(user, start, buffer, end - start)) {
+                    return -1;
+                }
+
+                for (s64 i = end - start - 27; i >= 0; i--) {
+                    const auto page = buffer + i;
+                    if (page[0] == 'O' && !std::memcmp(page, "OggS", 4) && page[4] == 0 && ReadLE32(page + 14) == serial &&
+                        ReadLE64(page + 6) != NO_GRANULE) {
+                        *granule = ReadLE64(page + 6);
+                        return start + i;
+                    }
+                }
+
+                if (start == begin) {
+                    break;
+                }
+                // overlap by a header, so one across the boundary is still found.
+                end = start + 26;
+            }
+            return -1;
+        }
+
+    }
+
+    bool Probe(const u8 *data, size_t size) {
+        if (size < 27 || std::memcmp(data, "OggS", 4)) {
+            return false;
+        }
+        const size_t packet = 27 + data[26];
+        return packet + 7 <= size && data[packet] == 1 && !std::memcmp(data + packet + 1, "vorbis", 6);
+    }
+
+    bool ParseInfo(ReadFunc read, void *user, s64 file_size, StreamInfo *out) {
+        u8 page[27 + 255];
+        if (file_size < 27 || !read(user, 0, page, 27) || std::memcmp(page, "OggS", 4) || !read(user, 27, page + 27, page[26])) {
+            return false;
+        }
+
+        // the identification header is alone on the first page.
+        u8 header[30];
+        const auto serial = ReadLE32(page + 14);
+        if (!read(user, 27 + page[26], header, sizeof(header)) || header[0] != 1 || std::memcmp(header + 1, "vorbis", 6) ||
+            ReadLE32(header + 7)) {
+            return false;
+        }
+
+        *out = {};
+        out->channels        = header[11];
+        out->sample_rate     = ReadLE32(header + 12);
+        out->bitrate_nominal = ReadLE32(header + 20);
+
+        // only looks at the tail, the count is left at 0 if the last page isn't near the end.
+        u8 buffer[1024];
+        u64 granule;
+        if (FindLastPage(read, user, std::max<s64>(0, file_size - 1024 * 64), file_size, serial, buffer, sizeof(buffer), &granule) >= 0) {
+            out->total_frames = granule;
+        }
+
+        return out->channels && out->sample_rate;
+    }
+
+    Decoder::~Decoder() {
+        // newest first, so an arena can hand each one back.
+        for (auto block = m_allocations; block;) {
+            const auto next = static_cast<void **>(*block);
+            m_alloc.onFree(block, m_alloc.pUserData);
+            block = next;
+        }
+    }
+
+    void *Decoder::Alloc(size_t size) {
+        constexpr size_t HEADER_SIZE = 0x10;
+        const auto block = static_cast<void **>(m_alloc.onMalloc(HEADER_SIZE + size, m_alloc.pUserData));
+        if (!block) {
+            return nullptr;
+        }
+
+        *block = m_allocations;
+        m_allocations = block;
+        m_memory_used += HEADER_SIZE + size;
+
+        const auto data = reinterpret_cast<u8 *>(block) + HEADER_SIZE;
+        std::memset(data, 0, size);
+        return data;
+    }
+
+    bool Decoder::Open(ReadFunc read, void *user, s64 file_size, const AllocationCallbacks &alloc, CommentFunc comment, void *comment_user) {
+        m_read      = read;
+        m_user      = user;
+        m_file_size = file_size;
+        m_alloc     = alloc;
+
+        if (!ReadPage(0)) {
+            return false;
+        }
+        m_serial = m_page_serial;
+
+        if (!ReadIdentification() || !ReadComments(comment, comment_user) || !ReadSetup()) {
+            return false;
+        }
+
+        // the first audio packet starts on a new page.
+        EndPacket();
+        m_audio_offset = m_page_end;
+        if (!FindStartGranule()) {
+            return false;
+        }
+
+        u64 granule;
+        if (FindLastPage(m_read, m_user, m_audio_offset, m_file_size, m_serial, m_chunk, sizeof(m_chunk), &granule) >= 0) {
+            m_info.total_frames = granule;
+        }
+
+        Reset(m_audio_offset);
+        m_granule_known = true;
+        m_pcm_granule   = m_start_granule;
+        m_open          = true;
+        return true;
+    }
+
+    u64 Decoder::GetPosition() const {
+        if (!m_granule_known) {
+            return m_skip_to;
+        }
+        return std::max<s64>(m_pcm_granule + m_pcm_read, m_skip_to);
+    }
+
+    u64 Decoder::Decode(s16 *out, u64 frames) {
+        return Read(out, frames);
+    }
+
+    u64 Decoder::Decode(float *out, u64 frames) {
+        return Read(out, frames);
+    }
+
+    bool Decoder::Seek(u64 target) {
+        if (m_info.total_frames) {
+            target = std::min(target, m_info.total_frames);
+        }
+
+        // landing past the target means the page picked had no packet to start from.
+        const auto page = FindPage(target);
+        if (page > m_audio_offset && SeekFromPage(page, target)) {
+            return true;
+        }
+        return SeekFromPage(m_audio_offset, target);
+    }
+
+    // ogg.
+
+    bool Decoder::ReadPage(s64 offset) {
+        u8 header[27];
+        if (offset + 27 > m_file_size || !m_read(m_user, offset, header, sizeof(header)) || std::memcmp(header, "OggS", 4) || header[4] != 0) {
+            return false;
+        }
+
+        const u8 count = header[26];
+        if (!m_read(m_user, offset + 27, m_segments, count)) {
+            return false;
+        }
+
+        u32 body = 0;
+        m_last_packet_segment = 0xFF;
+        for (u32 i = 0; i < count; i++) {
+            body += m_segments[i];
+            if (m_segments[i] < 255) {
+                m_last_packet_segment = i;
+            }
+        }
+
+        m_page_flags    = header[5];
+        m_page_granule  = ReadLE64(header + 6);
+        m_page_serial   = ReadLE32(header + 14);
+        m_segment_count = count;
+        m_segment_index = 0;
+        m_run_offset    = offset + 27 + count;
+        m_run_left      = 0;
+        m_page_end      = m_run_offset + body;
+        return m_page_end <= m_file_size;
+    }
+
+    bool Decoder::NextPage() {
+        // pages of other logical streams are skipped over.
+        do {
+            if (!ReadPage(m_page_end)) {
+                return false;
+            }
+        } while (m_page_serial != m_serial);
+        return true;
+    }
+
+    // the segments of the current packet up to its end or the end of the page.
+    void Decoder::SetupRun() {
+        m_run_left        = 0;
+        m_run_ends_packet = false;
+        while (m_segment_index < m_segment_count) {
+            const auto size = m_segments[m_segment_index++];
+            m_run_left += size;
+            if (size < 255) {
+                m_run_ends_packet = true;
+                break;
+            }
+        }
+    }
+
+    bool Decoder::StartPacket() {
+        m_bits      = 0;
+        m_bit_count = 0;
+        m_eop       = false;
+        m_chunk_pos = m_chunk_end = 0;
+        m_packet_truncated = false;
+
+        while (m_segment_index >= m_segment_count) {
+            if (!NextPage()) {
+                return false;
+            }
+
+            // the start of a packet that was cut off, after a seek or a lost page.
+            if (m_page_flags & 0x01) {
+                SetupRun();
+                m_run_offset += m_run_left;
+                m_run_left = 0;
+            }
+        }
+
+        SetupRun();
+        return true;
+    }
+
+    bool Decoder::NextRun() {
+        if (m_segment_index < m_segment_count) {
+            SetupRun();
+            return true;
+        }
+
+        // a packet that doesn't carry on to the next page ends here.
+        if (!NextPage() || !(m_page_flags & 0x01)) {
+            m_run_ends_packet = true;
+            m_packet_truncated = true;
+            return false;
+        }
+        SetupRun();
+        return true;
+    }
+
+    void Decoder::EndPacket() {
+        m_chunk_pos = m_chunk_end = 0;
+        for (;;) {
+            m_run_offset += m_run_left;
+            m_run_left = 0;
+            if (m_run_ends_packet || !NextRun()) {
+                break;
+            }
+        }
+
+        // the page granule is the end of the last packet that finishes on it.
+        const bool last_on_page = !m_packet_truncated && m_segment_index - 1 == m_last_packet_segment;
+        m_packet_granule = last_on_page && m_page_granule != NO_GRANULE ? s64(m_page_granule) : -1;
+    }
+
+    int Decoder::ReadByte() {
+        if (m_chunk_pos < m_chunk_end) {
+            return m_chunk[m_chunk_pos++];
+        }
+
+        while (!m_run_left) {
+            if (m_run_ends_packet || !NextRun()) {
+                return -1;
+            }
+        }
+
+        const auto size = std::min(m_run_left, CHUNK_SIZE);
+        if (!m_read(m_user, m_run_offset, m_chunk, size)) {
+            m_run_left = 0;
+            m_run_ends_packet = true;
+            return -1;
+        }
+
+        m_run_offset += size;
+        m_run_left -= size;
+        m_chunk_pos = 1;
+        m_chunk_end = size;
+        return m_chunk[0];
+    }
+
+    bool Decoder::SkipBytes(u32 count) {
+        for (; count && m_bit_count >= 8; count--) {
+            m_bits >>= 8;
+            m_bit_count -= 8;
+        }
+
+        while (count) {
+            if (m_chunk_pos < m_chunk_end) {
+                const auto n = std::min(count, m_chunk_end - m_chunk_pos);
+                m_chunk_pos += n;
+                count -= n;
+            } else if (m_run_left) {
+                const auto n = std::min(count, m_run_left);
+                m_run_offset += n;
+                m_run_left -= n;
+                count -= n;
+            } else if (m_run_ends_packet || !NextRun()) {
+                m_eop = true;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Decoder::Reset(s64 page_offset) {
+        m_page_end      = page_offset;
+        m_segment_count = m_segment_index = 0;
+        m_run_left      = 0;
+        m_run_ends_packet = true;
+        m_chunk_pos = m_chunk_end = 0;
+
+        m_current_size = 0;
+        m_pcm_count = m_pcm_read = 0;
+        m_granule_known = false;
+        m_skip_to = 0;
+    }
+
+    // bits.
+
+    u32 Decoder::ReadBits(u32 count) {
+        if (!count) {
+            return 0;
+        }
+
+        while (m_bit_count < count) {
+            const auto byte = ReadByte();
+            if (byte < 0) {
+                m_eop = true;
+                m_bits = m_bit_count = 0;
+                return 0;
+            }
+            m_bits |= u64(byte) << m_bit_count;
+            m_bit_count += 8;
+        }
+
+        const auto value = u32(m_bits & ((u64(1) << count) - 1));
+        m_bits >>= count;
+        m_bit_count -= count;
+        return value;
+    }
+
+    void Decoder::Fill() {
+        while (m_bit_count <= 56) {
+            const auto byte = ReadByte();
+            if (byte < 0) {
+                return;
+            }
+            m_bits |= u64(byte) << m_bit_count;
+            m_bit_count += 8;
+        }
+    }
+
+    s32 Decoder::DecodeScalar(const Codebook &book) {
+        if (m_bit_count < 32) {
+            Fill();
+        }
+
+        s32 entry = -1;
+        if (book.fast) {
+            entry = book.fast[m_bits & (FAST_SIZE - 1)];
+        }
+
+        if (entry < 0) {
+            if (!book.sorted_count) {
+                m_eop = true;
+                return -1;
+            }
+
+            // the codeword is the largest one not above the next 32 bits, read msb first.
+            const auto code = BitReverse(u32(m_bits));
+            u32 lo = 0, hi = book.sorted_count;
+            while (hi - lo > 1) {
+                const auto mid = (lo + hi) / 2;
+                if (book.codewords[mid] <= code) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+
+            entry = book.values[lo];
+            const auto length = book.lengths[entry];
+            if ((code ^ book.codewords[lo]) >> (32 - length)) {
+                m_eop = true;
+                return -1;
+            }
+        }
+
+        const u32 length = book.lengths[entry];
+        if (length > m_bit_count) {
+            m_eop = true;
+            m_bits = m_bit_count = 0;
+            return -1;
+        }
+
+        m_bits >>= length;
+        m_bit_count -= length;
+        return entry;
+    }
+
+    const float *Decoder::DecodeVector(const Codebook &book) {
+        const auto entry = DecodeScalar(book);
+        if (entry < 0) {
+            return nullptr;
+        }
+        if (book.vectors) {
+            return book.vectors + entry * book.dimensions;
+        }
+
+        float last = 0;
+        for (u32 i = 0, index = entry; i < book.dimensions; i++, index /= book.lookup_values) {
+            m_vector[i] = book.multiplicands[index % book.lookup_values] + last;
+            if (book.sequence) {
+                last = m_vector[i];
+            }
+        }
+        return m_vector;
+    }
+
+    // headers.
+
+    bool Decoder::ReadHeader(u8 type) {
+        if (!StartPacket() || ReadBits(8) != type) {
+            return false;
+        }
+
+        for (const char c : {'v', 'o', 'r', 'b', 'i', 's'}) {
+            if (ReadBits(8) != u8(c)) {
+                return false;
+            }
+        }
+        return !m_eop;
+    }
+
+    bool Decoder::ReadIdentification() {
+        if (!ReadHeader(1) || ReadBits(32) != 0) {
+            return false;
+        }
+
+        m_info.channels        = ReadBits(8);
+        m_info.sample_rate     = ReadBits(32);
+        ReadBits(32);
+        m_info.bitrate_nominal = ReadBits(32);
+        ReadBits(32);
+        m_block_size[0] = 1 << ReadBits(4);
+        m_block_size[1] = 1 << ReadBits(4);
+
+        if (m_eop || !ReadBits(1) || !m_info.channels || m_info.channels > CHANNELS_MAX || !m_info.sample_rate ||
+            m_block_size[0] < 64 || m_block_size[1] < m_block_size[0] || m_block_size[1] > BLOCK_SIZE_MAX) {
+            return false;
+        }
+        EndPacket();
+
+        // the scratch also holds lookup values while the setup header is read.
+        const auto channels = m_info.channels;
+        const auto half = m_block_size[1] / 2;
+        for (u32 c = 0; c < channels; c++) {
+            m_block[c]    = static_cast<float *>(Alloc(m_block_size[1] * sizeof(float)));
+            m_previous[c] = static_cast<float *>(Alloc(half * sizeof(float)));
+            if (!m_block[c] || !m_previous[c]) {
+                return false;
+            }
+        }
+
+        m_scratch = static_cast<float *>(Alloc(channels * half * sizeof(float)));
+        return m_scratch && SetupTransform(&m_transform[0], m_block_size[0]) && SetupTransform(&m_transform[1], m_block_size[1]);
+    }
+
+    bool Decoder::ReadComments(CommentFunc comment, void *comment_user) {
+        if (!ReadHeader(3) || !SkipBytes(ReadBits(32))) {
+            return false;
+        }
+
+        const auto count = ReadBits(32);
+        for (u32 i = 0; i < count && !m_eop; i++) {
+            const auto size = ReadBits(32);
+            if (!comment || size > COMMENT_SIZE_MAX) {
+                SkipBytes(size);
+                continue;
+            }
+
+            char text[COMMENT_SIZE_MAX];
+            for (u32 j = 0; j < size; j++) {
+                text[j] = ReadBits(8);
+            }
+            if (!m_eop) {
+                comment(comment_user, text, size);
+            }
+        }
+
+        if (m_eop) {
+            return false;
+        }
+        EndPacket();
+        return true;
+    }
+
+    bool Decoder::ReadSetup() {
+        if (!ReadHeader(5)) {
+            return false;
+        }
+
+        m_codebook_count = ReadBits(8) + 1;
+        m_codebooks = static_cast<Codebook *>(Alloc(m_codebook_count * sizeof(Codebook)));
+        if (!m_codebooks) {
+            return false;
+        }
+        for (u32 i = 0; i < m_codebook_count; i++) {
+            if (!ReadCodebook(&m_codebooks[i])) {
+                return false;
+            }
+        }
+
+        // time domain transforms, placeholders in vorbis i.
+        for (u32 i = ReadBits(6) + 1; i; i--) {
+            if (ReadBits(16)) {
+                return false;
+            }
+        }
+
+        m_floor_count = ReadBits(6) + 1;
+        m_floors = static_cast<Floor1 *>(Alloc(m_floor_count * sizeof(Floor1)));
+        if (!m_floors) {
+            return false;
+        }
+        for (u32 i = 0; i < m_floor_count; i++) {
+            // floor 0 hasn't been written by an encoder since the 1.0 betas.
+            if (ReadBits(16) != 1 || !ReadFloor(&m_floors[i])) {
+                return false;
+            }
+        }
+
+        m_residue_count = ReadBits(6) + 1;
+        m_residues = static_cast<Residue *>(Alloc(m_residue_count * sizeof(Residue)));
+        if (!m_residues) {
+            return false;
+        }
+        for (u32 i = 0; i < m_residue_count; i++) {
+            if (!ReadResidue(&m_residues[i])) {
+                return false;
+            }
+        }
+
+        m_mapping_count = ReadBits(6) + 1;
+        m_mappings = static_cast<Mapping *>(Alloc(m_mapping_count * sizeof(Mapping)));
+        if (!m_mappings) {
+            return false;
+        }
+        for (u32 i = 0; i < m_mapping_count; i++) {
+            if (!ReadMapping(&m_mappings[i])) {
+                return false;
+            }
+        }
+
+        m_mode_count = ReadBits(6) + 1;
+        for (u32 i = 0; i < m_mode_count; i++) {
+            auto &mode = m_modes[i];
+            mode.long_block = ReadBits(1);
+            if (ReadBits(16) || ReadBits(16)) {
+                return false;
+            }
+            mode.mapping = ReadBits(8);
+            if (mode.mapping >= m_mapping_count) {
+                return false;
+            }
+        }
+        m_mode_bits = ILog(m_mode_count - 1);
+
+        if (m_eop || !ReadBits(1)) {
+            return false;
+        }
+
+        m_classifications = static_cast<u8 *>(Alloc(m_info.channels * m_partitions_max));
+        return m_classifications != nullptr;
+    }
+
+    bool Decoder::ReadCodebook(Codebook *book) {
+        if (ReadBits(24) != 0x564342) {
+            return false;
+        }
+
+        book->dimensions = ReadBits(16);
+        book->entries    = ReadBits(24);
+        if (!book->dimensions || !book->entries || m_eop) {
+            return false;
+        }
+
+        const auto entries = book->entries;
+        book->lengths = static_cast<u8 *>(Alloc(entries));
+        if (!book->lengths) {
+            return false;
+        }
+
+        if (!ReadBits(1)) {
+            const bool sparse = ReadBits(1);
+            for (u32 i = 0; i < entries && !m_eop; i++) {
+                if (!sparse || ReadBits(1)) {
+                    book->lengths[i] = ReadBits(5) + 1;
+                }
+            }
+        } else {
+            u32 length = ReadBits(5) + 1;
+            for (u32 entry = 0; entry < entries && !m_eop; length++) {
+                const auto count = ReadBits(ILog(entries - entry));
+                if (entry + count > entries || length > 32) {
+                    return false;
+                }
+                std::memset(book->lengths + entry, length, count);
+                entry += count;
+            }
+        }
+
+        const auto lookup = ReadBits(4);
+        if (lookup == 1 || lookup == 2) {
+            const auto minimum  = Float32Unpack(ReadBits(32));
+            const auto delta    = Float32Unpack(ReadBits(32));
+            const auto bits     = ReadBits(4) + 1;
+            const bool sequence = ReadBits(1);
+            const auto dimensions = book->dimensions;
+
+            if (lookup == 1) {
+                // a lattice, every entry picks one of a few values per dimension. expanded
+                // it would be entries * dimensions floats, 200k for a common 3^8 book.
+                const auto values = Lookup1Values(entries, dimensions);
+                book->multiplicands = static_cast<float *>(Alloc(values * sizeof(float)));
+                if (!values || !book->multiplicands || dimensions > VECTOR_SIZE_MAX) {
+                    return false;
+                }
+                for (u32 i = 0; i < values; i++) {
+                    book->multiplicands[i] = ReadBits(bits) * delta + minimum;
+                }
+                book->lookup_values = values;
+                book->sequence = sequence;
+            } else {
+                const u64 size = u64(entries) * dimensions;
+                if (size > UINT32_MAX / sizeof(float)) {
+                    return false;
+                }
+                book->vectors = static_cast<float *>(Alloc(size * sizeof(float)));
+                if (!book->vectors) {
+                    return false;
+                }
+
+                for (u32 entry = 0; entry < entries; entry++) {
+                    auto vector = book->vectors + entry * dimensions;
+                    float last = 0;
+                    for (u32 i = 0; i < dimensions; i++) {
+                        vector[i] = ReadBits(bits) * delta + minimum + last;
+                        if (sequence) {
+                            last = vector[i];
+                        }
+                    }
+                }
+            }
+        } else if (lookup != 0) {
+            return false;
+        }
+
+        return !m_eop && BuildCodewords(book);
+    }
+
+    // hands out codewords in entry order, each the lowest free one of its length.
+    bool Decoder::BuildCodewords(Codebook *book) {
+        const auto entries = book->entries;
+        const bool fast = entries <= 0x7FFF;
+
+        u32 used = 0, sorted = 0;
+        for (u32 i = 0; i < entries; i++) {
+            used += book->lengths[i] != 0;
+            sorted += book->lengths[i] > (fast ? FAST_BITS : 0);
+        }
+        if (!used) {
+            return true;
+        }
+
+        if (fast) {
+            book->fast = static_cast<s16 *>(Alloc(FAST_SIZE * sizeof(s16)));
+            if (!book->fast) {
+                return false;
+            }
+            std::fill_n(book->fast, FAST_SIZE, -1);
+        }
+        if (sorted) {
+            book->codewords = static_cast<u32 *>(Alloc(sorted * sizeof(u32)));
+            book->values    = static_cast<u32 *>(Alloc(sorted * sizeof(u32)));
+            if (!book->codewords || !book->values) {
+                return false;
+            }
+        }
+
+        u32 available[33]{};
+        bool first = true;
+        for (u32 entry = 0; entry < entries; entry++) {
+            const u32 length = book->lengths[entry];
+            if (!length) {
+                continue;
+            }
+
+            u32 codeword;
+            if (first) {
+                first = false;
+                codeword = 0;
+                for (u32 i = 1; i <= length; i++) {
+                    available[i] = 1u << (32 - i);
+                }
+            } else {
+                u32 z = length;
+                while (z && !available[z]) {
+                    z--;
+                }
+                // the lengths describe an overfull tree.
+                if (!z) {
+                    return false;
+                }
+
+                codeword = available[z];
+                available[z] = 0;
+                for (u32 i = z + 1; i <= length; i++) {
+                    available[i] = codeword + (1u << (32 - i));
+                }
+            }
+
+            if (fast && length <= FAST_BITS) {
+                for (u32 i = BitReverse(codeword); i < FAST_SIZE; i += 1 << length) {
+                    book->fast[i] = entry;
+                }
+            } else {
+                book->codewords[book->sorted_count] = codeword;
+                book->values[book->sorted_count++] = entry;
+            }
+        }
+
+        // insertion sort, entries are mostly handed out in codeword order already.
+        for (u32 i = 1; i < book->sorted_count; i++) {
+            const auto codeword = book->codewords[i];
+            const auto value = book->values[i];
+            u32 j = i;
+            for (; j && book->codewords[j - 1] > codeword; j--) {
+                book->codewords[j] = book->codewords[j - 1];
+                book->values[j] = book->values[j - 1];
+            }
+            book->codewords[j] = codeword;
+            book->values[j] = value;
+        }
+        return true;
+    }
+
+    bool Decoder::ReadFloor(Floor1 *floor) {
+        floor->partitions = ReadBits(5);
+        s32 max_class = -1;
+        for (u32 i = 0; i < floor->partitions; i++) {
+            floor->partition_class[i] = ReadBits(4);
+            max_class = std::max<s32>(max_class, floor->partition_class[i]);
+        }
+
+        for (s32 i = 0; i <= max_class; i++) {
+            floor->class_dimensions[i] = ReadBits(3) + 1;
+            floor->class_subclasses[i] = ReadBits(2);
+            if (floor->class_subclasses[i]) {
+                floor->class_masterbook[i] = ReadBits(8);
+                if (floor->class_masterbook[i] >= m_codebook_count) {
+                    return false;
+                }
+            }
+            for (u32 j = 0; j < 1u << floor->class_subclasses[i]; j++) {
+                floor->subclass_books[i][j] = s16(ReadBits(8)) - 1;
+                if (floor->subclass_books[i][j] >= s32(m_codebook_count)) {
+                    return false;
+                }
+            }
+        }
+
+        floor->multiplier = ReadBits(2) + 1;
+        const auto range_bits = ReadBits(4);
+        floor->x[0] = 0;
+        floor->x[1] = 1 << range_bits;
+        floor->values = 2;
+        for (u32 i = 0; i < floor->partitions; i++) {
+            for (u32 j = 0; j < floor->class_dimensions[floor->partition_class[i]]; j++) {
+                if (floor->values == FLOOR1_VALUES_MAX) {
+                    return false;
+                }
+                floor->x[floor->values++] = ReadBits(range_bits);
+            }
+        }
+
+        for (u32 i = 0; i < floor->values; i++) {
+            floor->order[i] = i;
+        }
+        std::sort(floor->order, floor->order + floor->values, [floor](u8 a, u8 b) { return floor->x[a] < floor->x[b]; });
+        for (u32 i = 1; i < floor->values; i++) {
+            if (floor->x[floor->order[i]] == floor->x[floor->order[i - 1]]) {
+                return false;
+            }
+        }
+
+        // the closest points on either side among the ones before each point.
+        for (u32 i = 2; i < floor->values; i++) {
+            u32 low = 0, high = 1;
+            for (u32 j = 0; j < i; j++) {
+                if (floor->x[j] < floor->x[i] && floor->x[j] > floor->x[low]) {
+                    low = j;
+                }
+                if (floor->x[j] > floor->x[i] && floor->x[j] < floor->x[high]) {
+                    high = j;
+                }
+            }
+            floor->low[i]  = low;
+            floor->high[i] = high;
+        }
+
+        return !m_eop;
+    }
+
+    bool Decoder::ReadResidue(Residue *residue) {
+        residue->type = ReadBits(16);
+        if (residue->type > 2) {
+            return false;
+        }
+
+        residue->begin           = ReadBits(24);
+        residue->end             = ReadBits(24);
+        residue->partition_size  = ReadBits(24) + 1;
+        residue->classifications = ReadBits(6) + 1;
+        residue->classbook       = ReadBits(8);
+        if (residue->classbook >= m_codebook_count || !m_codebooks[residue->classbook].entries) {
+            return false;
+        }
+
+        u8 cascade[64];
+        for (u32 i = 0; i < residue->classifications; i++) {
+            cascade[i] = ReadBits(3);
+            if (ReadBits(1)) {
+                cascade[i] |= ReadBits(5) << 3;
+            }
+        }
+
+        for (u32 i = 0; i < residue->classifications; i++) {
+            for (u32 pass = 0; pass < 8; pass++) {
+                residue->books[i][pass] = -1;
+                if (cascade[i] & (1 << pass)) {
+                    const auto book = ReadBits(8);
+                    if (book >= m_codebook_count || (!m_codebooks[book].vectors && !m_codebooks[book].multiplicands)) {
+                        return false;
+                    }
+                    residue->books[i][pass] = book;
+                }
+            }
+        }
+
+        // type 2 codes every channel of a submap as one interleaved vector.
+        const u32 size = m_block_size[1] / 2 * (residue->type == 2 ? m_info.channels : 1);
+        const auto begin = std::min(residue->begin, size);
+        const auto end = std::min(residue->end, size);
+        const u32 partitions = end > begin ? (end - begin) / residue->partition_size : 0;
+        m_partitions_max = std::max(m_partitions_max, partitions + m_codebooks[residue->classbook].dimensions);
+
+        return !m_eop;
+    }
+
+    bool Decoder::ReadMapping(Mapping *mapping) {
+        if (ReadBits(16) != 0) {
+            return false;
+        }
+
+        const auto channels = m_info.channels;
+        mapping->submaps = ReadBits(1) ? ReadBits(4) + 1 : 1;
+
+        if (ReadBits(1)) {
+            mapping->coupling_steps = ReadBits(8) + 1;
+            const auto bits = ILog(channels - 1);
+            for (u32 i = 0; i < mapping->coupling_steps; i++) {
+                mapping->magnitude[i] = ReadBits(bits);
+                mapping->angle[i] = ReadBits(bits);
+                if (mapping->magnitude[i] == mapping->angle[i] || mapping->magnitude[i] >= channels || mapping->angle[i] >= channels) {
+                    return false;
+                }
+            }
+        }
+
+        if (ReadBits(2)) {
+            return false;
+        }
+
+        for (u32 c = 0; c < channels; c++) {
+            mapping->mux[c] = mapping->submaps > 1 ? ReadBits(4) : 0;
+            if (mapping->mux[c] >= mapping->submaps) {
+                return false;
+            }
+        }
+
+        for (u32 i = 0; i < mapping->submaps; i++) {
+            ReadBits(8);
+            mapping->submap_floor[i] = ReadBits(8);
+            mapping->submap_residue[i] = ReadBits(8);
+            if (mapping->submap_floor[i] >= m_floor_count || mapping->submap_residue[i] >= m_residue_count) {
+                return false;
+            }
+        }
+
+        return !m_eop;
+    }
+
+    bool Decoder::SetupTransform(Transform *transform, u32 size) {
+        const auto quarter = size / 4;
+        transform->size        = size;
+        transform->bit_reverse = static_cast<u16 *>(Alloc(quarter * sizeof(u16)));
+        transform->twiddle     = static_cast<float *>(Alloc(quarter * 2 * sizeof(float)));
+        transform->fft_twiddle = static_cast<float *>(Alloc(quarter * sizeof(float)));
+        transform->slope       = static_cast<float *>(Alloc(size / 2 * sizeof(float)));
+        if (!transform->bit_reverse || !transform->twiddle || !transform->fft_twiddle || !transform->slope) {
+            return false;
+        }
+
+        const auto bits = ILog(quarter) - 1;
+        for (u32 k = 0; k < quarter; k++) {
+            transform->bit_reverse[k] = BitReverse(k) >> (32 - bits);
+
+            const double angle = 2 * M_PI * (k + 0.125) / size;
+            transform->twiddle[k * 2 + 0] = std::cos(angle);
+            transform->twiddle[k * 2 + 1] = -std::sin(angle);
+        }
+
+        for (u32 k = 0; k < quarter / 2; k++) {
+            const double angle = 2 * M_PI * k / quarter;
+            transform->fft_twiddle[k * 2 + 0] = std::cos(angle);
+            transform->fft_twiddle[k * 2 + 1] = -std::sin(angle);
+        }
+
+        const auto half = size / 2;
+        for (u32 i = 0; i < half; i++) {
+            const double s = std::sin((i + 0.5) / half * M_PI / 2);
+            transform->slope[i] = std::sin(M_PI / 2 * s * s);
+        }
+        return true;
+    }
+
+    // sums the block sizes on the first audio page, its granule tells where the stream starts.
+    bool Decoder::FindStartGranule() {
+        Reset(m_audio_offset);
+
+        s64 frames = 0;
+        u32 previous = 0;
+        while (StartPacket()) {
+            const bool audio = !ReadBits(1);
+            const auto mode = ReadBits(m_mode_bits);
+            const bool valid = audio && !m_eop && mode < m_mode_count;
+            EndPacket();
+            if (!valid) {
+                continue;
+            }
+
+            const auto size = m_block_size[m_modes[mode].long_block];
+            if (previous) {
+                frames += previous / 4 + size / 4;
+            }
+            previous = size;
+
+            if (m_packet_granule >= 0) {
+                m_start_granule = m_packet_granule - frames;
+                return true;
+            }
+        }
+
+        // no audio at all is still a valid, empty, stream.
+        m_start_granule = 0;
+        return true;
+    }
+
+    // audio.
+
+    bool Decoder::DecodePacket() {
+        const auto channels = m_info.channels;
+
+        // the right half of the block just played out is the left side of the next overlap.
+        if (m_current_size) {
+            const auto half = m_current_size / 2;
+            for (u32 c = 0; c < channels; c++) {
+                std::memcpy(m_previous[c], m_block[c] + half, half * sizeof(float));
+            }
+        }
+        m_previous_size = m_current_size;
+        if (m_granule_known) {
+            m_pcm_granule += m_pcm_count;
+        }
+        m_pcm_count = m_pcm_read = 0;
+
+        u32 mode_number;
+        for (;;) {
+            if (!StartPacket()) {
+                return false;
+            }
+
+            // header packets repeated in the middle of the stream are skipped.
+            const bool audio = !ReadBits(1);
+            mode_number = ReadBits(m_mode_bits);
+            if (audio && !m_eop && mode_number < m_mode_count) {
+                break;
+            }
+            EndPacket();
+        }
+
+        const auto &mode = m_modes[mode_number];
+        const auto &mapping = m_mappings[mode.mapping];
+        const auto n = m_block_size[mode.long_block];
+        const auto half = n / 2;
+
+        bool previous_long = mode.long_block, next_long = mode.long_block;
+        if (mode.long_block) {
+            previous_long = ReadBits(1);
+            next_long = ReadBits(1);
+        }
+
+        bool floor_used[CHANNELS_MAX];
+        bool no_residue[CHANNELS_MAX];
+        for (u32 c = 0; c < channels; c++) {
+            const auto &floor = m_floors[mapping.submap_floor[mapping.mux[c]]];
+            floor_used[c] = DecodeFloor(floor, c);
+            no_residue[c] = !floor_used[c];
+        }
+
+        // running out of packet in the floors silences the whole block.
+        if (m_eop) {
+            for (u32 c = 0; c < channels; c++) {
+                floor_used[c] = false;
+                std::memset(m_block[c], 0, half * sizeof(float));
+            }
+        } else {
+            // a coupled pair is decoded if either side has a floor.
+            for (u32 i = 0; i < mapping.coupling_steps; i++) {
+                const auto magnitude = mapping.magnitude[i], angle = mapping.angle[i];
+                if (!no_residue[magnitude] || !no_residue[angle]) {
+                    no_residue[magnitude] = no_residue[angle] = false;
+                }
+            }
+
+            for (u32 submap = 0; submap < mapping.submaps; submap++) {
+                float *vectors[CHANNELS_MAX];
+                bool skip[CHANNELS_MAX];
+                u32 count = 0;
+                for (u32 c = 0; c < channels; c++) {
+                    if (mapping.mux[c] == submap) {
+                        vectors[count] = m_block[c];
+                        skip[count++] = no_residue[c];
+                    }
+                }
+                DecodeResidue(m_residues[mapping.submap_residue[submap]], vectors, skip, count, half);
+            }
+
+            for (u32 i = mapping.coupling_steps; i--;) {
+                auto magnitude = m_block[mapping.magnitude[i]];
+                auto angle = m_block[mapping.angle[i]];
+                for (u32 j = 0; j < half; j++) {
+                    const auto m = magnitude[j], a = angle[j];
+                    if (m > 0) {
+                        if (a > 0) {
+                            angle[j] = m - a;
+                        } else {
+                            angle[j] = m;
+                            magnitude[j] = m + a;
+                        }
+                    } else {
+                        if (a > 0) {
+                            angle[j] = m + a;
+                        } else {
+                            angle[j] = m;
+                            magnitude[j] = m - a;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (u32 c = 0; c < channels; c++) {
+            if (floor_used[c]) {
+                RenderFloor(m_floors[mapping.submap_floor[mapping.mux[c]]], c, m_block[c], half);
+            } else {
+                std::memset(m_block[c], 0, half * sizeof(float));
+            }
+            Imdct(m_block[c], m_transform[mode.long_block]);
+            Window(m_block[c], n, previous_long, next_long);
+        }
+
+        EndPacket();
+
+        m_current_size = n;
+        m_pcm_count = m_previous_size ? m_previous_size / 4 + n / 4 : 0;
+        if (!m_granule_known && m_packet_granule >= 0) {
+            m_pcm_granule = m_packet_granule - m_pcm_count;
+            m_granule_known = true;
+        }
+        return true;
+    }
+
+    bool Decoder::DecodeFloor(const Floor1 &floor, u32 channel) {
+        if (!ReadBits(1)) {
+            return false;
+        }
+
+        static constexpr u16 RANGES[] = {256, 128, 86, 64};
+        const s32 range = RANGES[floor.multiplier - 1];
+        const auto range_bits = ILog(range - 1);
+
+        s32 y[FLOOR1_VALUES_MAX];
+        y[0] = ReadBits(range_bits);
+        y[1] = ReadBits(range_bits);
+
+        u32 offset = 2;
+        for (u32 i = 0; i < floor.partitions; i++) {
+            const auto cls = floor.partition_class[i];
+            const auto dimensions = floor.class_dimensions[cls];
+            const auto bits = floor.class_subclasses[cls];
+            const u32 mask = (1 << bits) - 1;
+
+            s32 value = 0;
+            if (bits) {
+                value = DecodeScalar(m_codebooks[floor.class_masterbook[cls]]);
+            }
+            for (u32 j = 0; j < dimensions; j++) {
+                const auto book = floor.subclass_books[cls][value & mask];
+                value >>= bits;
+                y[offset + j] = book >= 0 ? DecodeScalar(m_codebooks[book]) : 0;
+            }
+            offset += dimensions;
+        }
+
+        if (m_eop) {
+            return false;
+        }
+
+        // each point is coded as a difference from the line between its neighbours.
+        auto final_y = m_floor_y[channel];
+        auto step2 = m_floor_step2[channel];
+        final_y[0] = y[0];
+        final_y[1] = y[1];
+        step2[0] = step2[1] = true;
+        for (u32 i = 2; i < floor.values; i++) {
+            const auto low = floor.low[i], high = floor.high[i];
+            const auto predicted = RenderPoint(floor.x[low], final_y[low], floor.x[high], final_y[high], floor.x[i]);
+            const auto value = y[i];
+            const auto high_room = range - predicted;
+            const auto low_room = predicted;
+            const auto room = std::min(high_room, low_room) * 2;
+
+            if (value) {
+                step2[low] = step2[high] = step2[i] = true;
+                if (value >= room) {
+                    final_y[i] = high_room > low_room ? value - low_room + predicted : predicted - value + high_room - 1;
+                } else {
+                    final_y[i] = (value & 1) ? predicted - (value + 1) / 2 : predicted + value / 2;
+                }
+            } else {
+                step2[i] = false;
+                final_y[i] = predicted;
+            }
+        }
+        return true;
+    }
+
+    void Decoder::RenderFloor(const Floor1 &floor, u32 channel, float *out, u32 n) {
+        const auto final_y = m_floor_y[channel];
+        const auto step2 = m_floor_step2[channel];
+
+        s32 lx = 0;
+        s32 ly = final_y[floor.order[0]] * floor.multiplier;
+        for (u32 k = 1; k < floor.values; k++) {
+            const auto i = floor.order[k];
+            if (step2[i]) {
+                const s32 hx = floor.x[i];
+                const s32 hy = final_y[i] * floor.multiplier;
+                RenderLine(lx, ly, hx, hy, out, n);
+                lx = hx;
+                ly = hy;
+            }
+        }
+
+        for (s32 x = lx; x < s32(n); x++) {
+            out[x] *= INVERSE_DB[ly & 0xFF];
+        }
+    }
+
+    void Decoder::DecodeResidue(const Residue &residue, float **vectors, const bool *skip, u32 count, u32 n) {
+        for (u32 i = 0; i < count; i++) {
+            std::memset(vectors[i], 0, n * sizeof(float));
+        }
+
+        if (residue.type == 2) {
+            if (std::all_of(skip, skip + count, [](bool s) { return s; })) {
+                return;
+            }
+
+            // decoded as one vector with the channels interleaved, then split up.
+            float *interleaved = m_scratch;
+            const bool decode = false;
+            std::memset(interleaved, 0, count * n * sizeof(float));
+            DecodePartitions(residue, &interleaved, &decode, 1, count * n);
+            for (u32 i = 0; i < n; i++) {
+                for (u32 c = 0; c < count; c++) {
+                    vectors[c][i] = interleaved[i * count + c];
+                }
+            }
+            return;
+        }
+
+        DecodePartitions(residue, vectors, skip, count, n);
+    }
+
+    void Decoder::DecodePartitions(const Residue &residue, float **vectors, const bool *skip, u32 count, u32 n) {
+        const auto begin = std::min(residue.begin, n);
+        const auto end = std::min(residue.end, n);
+        const u32 partitions = end > begin ? (end - begin) / residue.partition_size : 0;
+        if (!partitions) {
+            return;
+        }
+
+        const auto &classbook = m_codebooks[residue.classbook];
+        const auto per_codeword = classbook.dimensions;
+        const auto size = residue.partition_size;
+
+        for (u32 pass = 0; pass < 8; pass++) {
+            for (u32 partition = 0; partition < partitions;) {
+                if (pass == 0) {
+                    for (u32 c = 0; c < count; c++) {
+                        if (skip[c]) {
+                            continue;
+                        }
+
+                        auto value = DecodeScalar(classbook);
+                        if (value < 0) {
+                            return;
+                        }
+                        auto classes = m_classifications + c * m_partitions_max + partition;
+                        for (u32 i = per_codeword; i--;) {
+                            classes[i] = value % residue.classifications;
+                            value /= residue.classifications;
+                        }
+                    }
+                }
+
+                for (u32 i = 0; i < per_codeword && partition < partitions; i++, partition++) {
+                    for (u32 c = 0; c < count; c++) {
+                        if (skip[c]) {
+                            continue;
+                        }
+
+                        const auto book = residue.books[m_classifications[c * m_partitions_max + partition]][pass];
+                        if (book < 0) {
+                            continue;
+                        }
+
+                        const auto &codebook = m_codebooks[book];
+                        const auto dimensions = codebook.dimensions;
+                        auto out = vectors[c] + begin + partition * size;
+                        if (residue.type == 0) {
+                            // each vector is spread across the partition.
+                            const auto step = size / dimensions;
+                            for (u32 j = 0; j < step; j++) {
+                                const auto vector = DecodeVector(codebook);
+                                if (!vector) {
+                                    return;
+                                }
+                                for (u32 k = 0; k < dimensions; k++) {
+                                    out[j + k * step] += vector[k];
+                                }
+                            }
+                        } else {
+                            for (u32 j = 0; j < size;) {
+                                const auto vector = DecodeVector(codebook);
+                                if (!vector) {
+                                    return;
+                                }
+                                for (u32 k = 0; k < dimensions && j < size; k++) {
+                                    out[j++] += vector[k];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // y[n] = sum X[k] cos(pi / N * (n + 1/2 + N/4) * (2k + 1)), through a complex fft of N/4 points.
+    void Decoder::Imdct(float *buffer, const Transform &transform) {
+        const auto n = transform.size;
+        const auto quarter = n / 4;
+        const auto eighth = n / 8;
+        const auto w = transform.twiddle;
+        auto z = m_scratch;
+
+        for (u32 k = 0; k < quarter; k++) {
+            const auto re = buffer[2 * k];
+            const auto im = buffer[n / 2 - 1 - 2 * k];
+            const auto j = transform.bit_reverse[k] * 2;
+            z[j + 0] = re * w[2 * k] - im * w[2 * k + 1];
+            z[j + 1] = re * w[2 * k + 1] + im * w[2 * k];
+        }
+
+        for (u32 length = 2; length <= quarter; length *= 2) {
+            const auto step = quarter / length;
+            const auto half = length / 2;
+            for (u32 i = 0; i < quarter; i += length) {
+                for (u32 j = 0; j < half; j++) {
+                    const auto t = transform.fft_twiddle + j * step * 2;
+                    auto a = z + (i + j) * 2;
+                    auto b = z + (i + j + half) * 2;
+                    const auto re = b[0] * t[0] - b[1] * t[1];
+                    const auto im = b[0] * t[1] + b[1] * t[0];
+                    b[0] = a[0] - re;
+                    b[1] = a[1] - im;
+                    a[0] += re;
+                    a[1] += im;
+                }
+            }
+        }
+
+        for (u32 k = 0; k < quarter; k++) {
+            const auto re = z[2 * k], im = z[2 * k + 1];
+            z[2 * k + 0] = re * w[2 * k] - im * w[2 * k + 1];
+            z[2 * k + 1] = re * w[2 * k + 1] + im * w[2 * k];
+        }
+
+        // the output is made of the real and imaginary parts, mirrored and negated by quarter.
+        const auto u = [z](u32 k) { return z + 2 * k; };
+        for (u32 i = 0; i < eighth; i++) {
+            buffer[2 * i]                   = u(eighth + i)[0];
+            buffer[2 * i + 1]               = -u(eighth - 1 - i)[1];
+            buffer[quarter + 2 * i]         = u(i)[1];
+            buffer[quarter + 2 * i + 1]     = -u(quarter - 1 - i)[0];
+            buffer[quarter * 2 + 2 * i]     = u(eighth + i)[1];
+            buffer[quarter * 2 + 2 * i + 1] = -u(eighth - 1 - i)[0];
+            buffer[quarter * 3 + 2 * i]     = -u(i)[0];
+            buffer[quarter * 3 + 2 * i + 1] = u(quarter - 1 - i)[1];
+        }
+    }
+
+    void Decoder::Window(float *buffer, u32 n, bool previous_long, bool next_long) {
+        const bool long_block = n != m_block_size[0];
+        const auto short_half = m_block_size[0] / 2;
+
+        const auto left_n = long_block && !previous_long ? short_half : n / 2;
+        const auto left_start = n / 4 - left_n / 2;
+        const auto left_slope = m_transform[left_n != short_half].slope;
+        const auto right_n = long_block && !next_long ? short_half : n / 2;
+        const auto right_start = n * 3 / 4 - right_n / 2;
+        const auto right_slope = m_transform[right_n != short_half].slope;
+
+        std::memset(buffer, 0, left_start * sizeof(float));
+        for (u32 i = 0; i < left_n; i++) {
+            buffer[left_start + i] *= left_slope[i];
+        }
+        for (u32 i = 0; i < right_n; i++) {
+            buffer[right_start + i] *= right_slope[right_n - 1 - i];
+        }
+        std::memset(buffer + right_start + right_n, 0, (n - right_start - right_n) * sizeof(float));
+    }
+
+    // frames [first, first + count) of the overlap between the previous block and this one.
+    template<typename T>
+    void Decoder::Overlap(T *out, u32 first, u32 count) const {
+        const auto channels = m_info.channels;
+        const s32 previous_half = m_previous_size / 2;
+        // where the current block starts relative to the centre of the previous one.
+        const s32 offset = s32(m_current_size / 4) - s32(m_previous_size / 4);
+
+        for (u32 c = 0; c < channels; c++) {
+            const auto previous = m_previous[c];
+            const auto current = m_block[c];
+            auto dst = out + c;
+            for (u32 i = 0; i < count; i++, dst += channels) {
+                const s32 t = first + i;
+                float value = 0;
+                if (t < previous_half) {
+                    value += previous[t];
+                }
+                if (t + offset >= 0) {
+                    value += current[t + offset];
+                }
+
+                if constexpr (std::is_same_v<T, float>) {
+                    *dst = value;
+                } else {
+                    *dst = std::clamp<long>(std::lrint(value * 32768.0f), -32768, 32767);
+                }
+            }
+        }
+    }
+
+    template<typename T>
+    u64 Decoder::Read(T *out, u64 frames) {
+        if (!m_open) {
+            return 0;
+        }
+
+        const auto total = s64(m_info.total_frames);
+        u64 done = 0;
+        while (done < frames) {
+            if (m_pcm_read >= m_pcm_count) {
+                if (!DecodePacket()) {
+                    break;
+                }
+                continue;
+            }
+
+            // nothing is played until a page tells where in the stream this is.
+            if (!m_granule_known) {
+                m_pcm_read = m_pcm_count;
+                continue;
+            }
+
+            const s64 granule = m_pcm_granule + m_pcm_read;
+            const auto skip_to = std::max<s64>(m_skip_to, 0);
+            if (granule < skip_to) {
+                m_pcm_read += std::min<s64>(skip_to - granule, m_pcm_count - m_pcm_read);
+                continue;
+            }
+
+            // the last page cuts the final block short.
+            if (total && granule >= total) {
+                break;
+            }
+
+            auto count = std::min<u64>(frames - done, m_pcm_count - m_pcm_read);
+            if (total) {
+                count = std::min<u64>(count, total - granule);
+            }
+            Overlap(out + done * m_info.channels, m_pcm_read, count);
+            m_pcm_read += count;
+            done += count;
+        }
+        return done;
+    }
+
+    s64 Decoder::FindPage(u64 target) {
+        s64 lo = m_audio_offset, hi = m_file_size;
+        s64 best = m_audio_offset;
+
+        while (hi - lo > SEEK_LINEAR) {
+            const auto mid = lo + (hi - lo) / 2;
+
+            s64 page = -1;
+            u64 granule = NO_GRANULE;
+            for (s64 offset = mid; page < 0 && offset < hi;) {
+                const auto size = std::min<s64>(sizeof(m_chunk), m_file_size - offset);
+                if (size < 27 || !m_read(m_user, offset, m_chunk, size)) {
+                    break;
+                }
+                for (s64 i = 0; i + 27 <= size && offset + i < hi; i++) {
+                    const auto header = m_chunk + i;
+                    if (header[0] == 'O' && !std::memcmp(header, "OggS", 4) && header[4] == 0 && ReadLE32(header + 14) == m_serial &&
+                        ReadLE64(header + 6) != NO_GRANULE) {
+                        page = offset + i;
+                        granule = ReadLE64(header + 6);
+                        break;
+                    }
+                }
+                offset += size - 26;
+            }
+
+            if (page < 0 || s64(granule) >= s64(target)) {
+                hi = mid;
+            } else {
+                lo = page;
+                best = page;
+            }
+        }
+
+        return best;
+    }
+
+    bool Decoder::SeekFromPage(s64 page_offset, u64 target) {
+        Reset(page_offset);
+        if (page_offset == m_audio_offset) {
+            m_granule_known = true;
+            m_pcm_granule = m_start_granule;
+        }
+        m_skip_to = target;
+
+        // decode until the block holding the target, the rest is dropped by Read().
+        for (;;) {
+            if (m_granule_known) {
+                if (m_pcm_granule > s64(target)) {
+                    return false;
+                }
+                if (m_pcm_granule + m_pcm_count > s64(target)) {
+                    return true;
+                }
+            }
+            if (!DecodePacket()) {
+                return m_granule_known;
+            }
+        }
+    }
+
+}
+
+#endif
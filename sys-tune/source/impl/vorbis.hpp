@@ -0,0 +1,229 @@
+#pragma once
+
+#include <switch.h>
+#include <cstddef>
+
+// ogg vorbis, pulled a few kilobytes at a time straight out of the ogg pages. there is no
+// page or packet buffer, everything the stream needs is allocated once in Open() and
+// decoding itself never allocates.
+namespace tune::impl::vorbis {
+
+    // audout is stereo, wider streams would need a downmix first.
+    constexpr u32 CHANNELS_MAX = 2;
+    constexpr u32 BLOCK_SIZE_MAX = 8192;
+    // bytes pulled from the file at a time.
+    constexpr u32 CHUNK_SIZE = 1024 * 4;
+    // longer comments, cover art mostly, are skipped without being read.
+    constexpr u32 COMMENT_SIZE_MAX = 128;
+
+    constexpr u32 FLOOR1_VALUES_MAX = 65;
+    // dimensions of a lattice codebook, libvorbis uses up to 8.
+    constexpr u32 VECTOR_SIZE_MAX = 32;
+
+    struct StreamInfo {
+        u32 channels;
+        u32 sample_rate;
+        u32 bitrate_nominal;
+        // granule of the last page, 0 if there is none.
+        u64 total_frames;
+    };
+
+    using ReadFunc = bool (*)(void *user, s64 offset, void *buffer, u64 size);
+    // a user comment, KEY=value without a terminator.
+    using CommentFunc = void (*)(void *user, const char *comment, size_t size);
+
+    // same layout as the dr_libs callbacks, so Arena::GetCallbacks() fills it.
+    struct AllocationCallbacks {
+        void *pUserData;
+        void *(*onMalloc)(size_t size, void *user);
+        void *(*onRealloc)(void *p, size_t size, void *user);
+        void (*onFree)(void *p, void *user);
+    };
+
+    bool Probe(const u8 *data, size_t size);
+    // identification header and the last page only, the setup header isn't touched.
+    bool ParseInfo(ReadFunc read, void *user, s64 file_size, StreamInfo *out);
+
+    struct Codebook;
+    struct Floor1;
+    struct Residue;
+    struct Mapping;
+
+    struct Mode {
+        bool long_block;
+        u8 mapping;
+    };
+
+    // imdct and window tables for one block size.
+    struct Transform {
+        u32 size;
+        u16 *bit_reverse;
+        // e^(-2pi i (k + 1/8) / size), before and after the fft.
+        float *twiddle;
+        // e^(-2pi i k / (size / 4)) for the fft.
+        float *fft_twiddle;
+        // rising half of the window, size / 2 long.
+        float *slope;
+    };
+
+    class Decoder {
+      private:
+        ReadFunc m_read{};
+        void *m_user{};
+        s64 m_file_size{};
+        AllocationCallbacks m_alloc{};
+        // every allocation starts with a pointer to the one before.
+        void **m_allocations{};
+        StreamInfo m_info{};
+
+        // ogg layer, the page being read and the part of the current packet on it.
+        u32 m_serial{};
+        s64 m_page_end{};
+        u64 m_page_granule{};
+        u32 m_page_serial{};
+        u8 m_page_flags{};
+        u8 m_segment_count{};
+        u8 m_segment_index{};
+        // the last segment on the page that ends a packet, 0xFF if none does.
+        u8 m_last_packet_segment{};
+        u8 m_segments[255]{};
+        // bytes of the current packet left in the file before the next page or its end.
+        s64 m_run_offset{};
+        u32 m_run_left{};
+        bool m_run_ends_packet{};
+        // the packet ran into a page that doesn't continue it.
+        bool m_packet_truncated{};
+        // granule of the packet just finished, -1 when its page gives none.
+        s64 m_packet_granule{};
+
+        u8 m_chunk[CHUNK_SIZE];
+        u32 m_chunk_pos{};
+        u32 m_chunk_end{};
+
+        // bit reader over the current packet, lsb first.
+        u64 m_bits{};
+        u32 m_bit_count{};
+        // set once the packet ran out, reads past the end return zeros.
+        bool m_eop{};
+
+        // setup, pointers into allocations made in Open().
+        u32 m_block_size[2]{};
+        Codebook *m_codebooks{};
+        u32 m_codebook_count{};
+        Floor1 *m_floors{};
+        u32 m_floor_count{};
+        Residue *m_residues{};
+        u32 m_residue_count{};
+        Mapping *m_mappings{};
+        u32 m_mapping_count{};
+        Mode m_modes[64]{};
+        u32 m_mode_count{};
+        u32 m_mode_bits{};
+        Transform m_transform[2]{};
+
+        // decode state.
+        float *m_block[CHANNELS_MAX]{};
+        // right half of the previous block, windowed, waiting for the overlap.
+        float *m_previous[CHANNELS_MAX]{};
+        float *m_scratch{};
+        u8 *m_classifications{};
+        u32 m_partitions_max{};
+        float m_vector[VECTOR_SIZE_MAX]{};
+        s16 m_floor_y[CHANNELS_MAX][FLOOR1_VALUES_MAX]{};
+        bool m_floor_step2[CHANNELS_MAX][FLOOR1_VALUES_MAX]{};
+
+        // size of the block in m_block, 0 before the first packet after a reset.
+        u32 m_current_size{};
+        u32 m_previous_size{};
+        // the frames the current packet finishes, the overlap of m_previous and m_block.
+        s64 m_pcm_granule{};
+        u32 m_pcm_count{};
+        u32 m_pcm_read{};
+        // m_pcm_granule is only known at the end of a page, after a seek lands in the middle.
+        bool m_granule_known{};
+        // frames before this are dropped, the start of the stream or a seek target.
+        s64 m_skip_to{};
+
+        // first audio page and the granule the first packet starts at, negative to trim.
+        s64 m_audio_offset{};
+        s64 m_start_granule{};
+        u32 m_memory_used{};
+        bool m_open{};
+
+      public:
+        Decoder() = default;
+        ~Decoder();
+
+        Decoder(const Decoder &) = delete;
+        Decoder &operator=(const Decoder &) = delete;
+
+        // comment is called for every user comment up to COMMENT_SIZE_MAX bytes.
+        bool Open(ReadFunc read, void *user, s64 file_size, const AllocationCallbacks &alloc, CommentFunc comment = nullptr, void *comment_user = nullptr);
+
+        const StreamInfo &GetInfo() const {
+            return m_info;
+        }
+
+        u64 GetPosition() const;
+
+        // bytes allocated in Open(), the whole footprint apart from the object itself.
+        u32 GetMemoryUsed() const {
+            return m_memory_used;
+        }
+
+        // interleaved frames, short only at the end of the stream.
+        u64 Decode(s16 *out, u64 frames);
+        u64 Decode(float *out, u64 frames);
+        bool Seek(u64 target);
+
+      private:
+        void *Alloc(size_t size);
+
+        // ogg pages and packets.
+        bool ReadPage(s64 offset);
+        bool NextPage();
+        void SetupRun();
+        bool StartPacket();
+        bool NextRun();
+        void EndPacket();
+        int ReadByte();
+        bool SkipBytes(u32 count);
+        void Reset(s64 page_offset);
+
+        // bits of the current packet.
+        u32 ReadBits(u32 count);
+        void Fill();
+        s32 DecodeScalar(const Codebook &book);
+        const float *DecodeVector(const Codebook &book);
+
+        // headers.
+        bool ReadHeader(u8 type);
+        bool ReadIdentification();
+        bool ReadComments(CommentFunc comment, void *comment_user);
+        bool ReadSetup();
+        bool ReadCodebook(Codebook *book);
+        bool BuildCodewords(Codebook *book);
+        bool ReadFloor(Floor1 *floor);
+        bool ReadResidue(Residue *residue);
+        bool ReadMapping(Mapping *mapping);
+        bool SetupTransform(Transform *transform, u32 size);
+        bool FindStartGranule();
+
+        // audio packets.
+        bool DecodePacket();
+        bool DecodeFloor(const Floor1 &floor, u32 channel);
+        void RenderFloor(const Floor1 &floor, u32 channel, float *out, u32 n);
+        void DecodeResidue(const Residue &residue, float **vectors, const bool *skip, u32 count, u32 n);
+        void DecodePartitions(const Residue &residue, float **vectors, const bool *skip, u32 count, u32 n);
+        void Imdct(float *buffer, const Transform &transform);
+        void Window(float *buffer, u32 n, bool previous_long, bool next_long);
+        template<typename T>
+        void Overlap(T *out, u32 first, u32 count) const;
+        template<typename T>
+        u64 Read(T *out, u64 frames);
+        // the last page before target with a granule, from a bisection of the file.
+        s64 FindPage(u64 target);
+        bool SeekFromPage(s64 page_offset, u64 target);
+    };
+
+}
@@ -3,17 +3,39 @@
 #include "pm/pm.hpp"
 #include "impl/aud_wrapper.h"
 #include "impl/source.hpp"
+#include "impl/arena.hpp"
+#include "impl/background.hpp"
+#include "impl/read_ahead.hpp"
+#include "impl/decode_worker.hpp"
 #include "tune_service.hpp"
 #include "tune_result.hpp"
 
 extern "C" {
 u32 __nx_applet_type     = AppletType_None;
-u32 __nx_fs_num_sessions = 1;
+// NOTE: second session so background scans don't queue behind playback reads.
+u32 __nx_fs_num_sessions = 2;
 
-// TODO(TJ): calculate minimum heap
 // TODO(TJ): calculate reasonable amount of heap for playlist entries.
+// NOTE: two open tracks, the next one is opened before the current one ends. in KiB:
+//       192  ReadAhead::MEMORY_MAX, shared between them
+//        64  sdmc page cache
+//        96  the next track's first blocks decoded ahead, a full ring of 12
+//        64  two preloaded tracks (preload_kib, 128 by default) over the read-ahead they don't use
+//        16  two resample buffers, WANT_FLOAT doubles them
+//       144  two SDL streams, tests/memory_bench measures 68KiB (s16, the full sinc converts to
+//            float) and 53KiB (f32) from 44.1kHz stereo. lower rates take more, 160KiB from
+//            22.05kHz mono, not budgeted here.
+//        24  the mp3 seek index in use and one just built
+//        16  pcm cache render buffer, it opens a third source but only while the home menu is up
+//         8  playlist order, paths are static
+//       dual core builds add the buffers of up to two parallel flac sources, PARALLEL_MEMORY_MAX each.
+//       dr_libs allocations come from the Arena slots on top, which are taken from here as well.
 void __libnx_initheap(void) {
-    static char inner_heap[1024 * 250];
+#ifdef WANT_DUALCORE
+    static char inner_heap[1024 * (624 + 128) + Arena::COUNT * Arena::SIZE];
+#else
+    static char inner_heap[1024 * 624 + Arena::COUNT * Arena::SIZE];
+#endif
     extern char *fake_heap_start;
     extern char *fake_heap_end;
 
@@ -55,6 +77,12 @@ namespace {
     alignas(0x1000) u8 gpioThreadBuffer[0x1000];
     alignas(0x1000) u8 pmdmntThreadBuffer[0x1000];
     alignas(0x1000) u8 tuneThreadBuffer[0x6000];
+    alignas(0x1000) u8 audioThreadBuffer[0x1000];
+    alignas(0x1000) u8 backgroundThreadBuffer[0x6000];
+    alignas(0x1000) u8 ioThreadBuffer[0x1000];
+#ifdef WANT_DUALCORE
+    alignas(0x1000) u8 decodeThreadBuffer[0x4000];
+#endif
 
 }
 
@@ -68,13 +96,35 @@ int main(int, char *[]) {
     ::Thread gpioThread;
     ::Thread pmdmtThread;
     ::Thread tuneThread;
+    ::Thread audioThread;
+    ::Thread backgroundThread;
+    ::Thread ioThread;
+#ifdef WANT_DUALCORE
+    ::Thread decodeThread;
+#endif
     R_ABORT_UNLESS(threadCreate(&gpioThread, tune::impl::GpioThreadFunc, &headphone_detect_session, gpioThreadBuffer, sizeof(gpioThreadBuffer), 0x20, -2));
     R_ABORT_UNLESS(threadCreate(&pmdmtThread, tune::impl::PmdmntThreadFunc, nullptr, pmdmntThreadBuffer, sizeof(pmdmntThreadBuffer), 0x20, -2));
     R_ABORT_UNLESS(threadCreate(&tuneThread, tune::impl::TuneThreadFunc, nullptr, tuneThreadBuffer, sizeof(tuneThreadBuffer), 0x20, -2));
+    /* Submits decoded blocks to audout, runs above the decoder so it never starves. */
+    R_ABORT_UNLESS(threadCreate(&audioThread, tune::impl::AudioThreadFunc, nullptr, audioThreadBuffer, sizeof(audioThreadBuffer), 0x1F, -2));
+    /* Builds caches while idle, lowest priority so it only gets leftover time. */
+    R_ABORT_UNLESS(threadCreate(&backgroundThread, tune::impl::background::ThreadFunc, nullptr, backgroundThreadBuffer, sizeof(backgroundThreadBuffer), 0x3F, -2));
+    /* Fills read-ahead blocks, mostly blocked in fs so it can run above the decoder. */
+    R_ABORT_UNLESS(threadCreate(&ioThread, tune::impl::read_ahead::ThreadFunc, nullptr, ioThreadBuffer, sizeof(ioThreadBuffer), 0x1F, -2));
+#ifdef WANT_DUALCORE
+    /* Decodes part of hi-res tracks on core 2, the dual core npdm allows it. */
+    R_ABORT_UNLESS(threadCreate(&decodeThread, tune::impl::decode_worker::ThreadFunc, nullptr, decodeThreadBuffer, sizeof(decodeThreadBuffer), 0x20, 2));
+#endif
 
     R_ABORT_UNLESS(threadStart(&gpioThread));
     R_ABORT_UNLESS(threadStart(&pmdmtThread));
     R_ABORT_UNLESS(threadStart(&tuneThread));
+    R_ABORT_UNLESS(threadStart(&audioThread));
+    R_ABORT_UNLESS(threadStart(&backgroundThread));
+    R_ABORT_UNLESS(threadStart(&ioThread));
+#ifdef WANT_DUALCORE
+    R_ABORT_UNLESS(threadStart(&decodeThread));
+#endif
 
     /* Create services */
     R_ABORT_UNLESS(tune::InitializeServer());
@@ -82,15 +132,32 @@ int main(int, char *[]) {
     R_ABORT_UNLESS(tune::ExitServer());
 
     tune::impl::Exit();
+    tune::impl::background::Exit();
     svcCancelSynchronization(gpioThread.handle);
 
     R_ABORT_UNLESS(threadWaitForExit(&gpioThread));
     R_ABORT_UNLESS(threadWaitForExit(&pmdmtThread));
     R_ABORT_UNLESS(threadWaitForExit(&tuneThread));
+    R_ABORT_UNLESS(threadWaitForExit(&audioThread));
+    R_ABORT_UNLESS(threadWaitForExit(&backgroundThread));
+    /* Stopped last, the tune thread may wait on read-ahead until it exits. */
+    tune::impl::read_ahead::Exit();
+    R_ABORT_UNLESS(threadWaitForExit(&ioThread));
+#ifdef WANT_DUALCORE
+    /* Sources wait on their job when closed, same as read-ahead. */
+    tune::impl::decode_worker::Exit();
+    R_ABORT_UNLESS(threadWaitForExit(&decodeThread));
+#endif
 
     R_ABORT_UNLESS(threadClose(&gpioThread));
     R_ABORT_UNLESS(threadClose(&pmdmtThread));
     R_ABORT_UNLESS(threadClose(&tuneThread));
+    R_ABORT_UNLESS(threadClose(&audioThread));
+    R_ABORT_UNLESS(threadClose(&backgroundThread));
+    R_ABORT_UNLESS(threadClose(&ioThread));
+#ifdef WANT_DUALCORE
+    R_ABORT_UNLESS(threadClose(&decodeThread));
+#endif
 
     /* Close gpio session. */
     gpioPadClose(&headphone_detect_session);
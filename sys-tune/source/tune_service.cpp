@@ -81,6 +81,12 @@ namespace tune {
                 case TuneIpcCmd_SetShuffleMode:
                     SET_SINGLE(ShuffleMode, impl::SetShuffleMode);
 
+                case TuneIpcCmd_GetResamplerQuality:
+                    GET_SINGLE(ResamplerQuality, impl::GetResamplerQuality);
+
+                case TuneIpcCmd_SetResamplerQuality:
+                    SET_SINGLE(ResamplerQuality, impl::SetResamplerQuality);
+
                 case TuneIpcCmd_GetPlaylistSize:
                     GET_SINGLE(u32, impl::GetPlaylistSize);
 
@@ -133,10 +139,30 @@ namespace tune {
                 case TuneIpcCmd_Remove:
                     SET_SINGLE(u32, impl::Remove);
 
+                case TuneIpcCmd_Probe:
+                    if (r->hipc.meta.num_send_buffers >= 1) {
+                        *out_dataSize = sizeof(ProbeInfo);
+                        return impl::Probe(
+                            (const char *)hipcGetBufferAddress(r->hipc.data.send_buffers),
+                            hipcGetBufferSize(r->hipc.data.send_buffers),
+                            (ProbeInfo *)out_data);
+                    }
+                    break;
+
                 case TuneIpcCmd_QuitServer:
                     running = false;
                     return 0;
 
+                case TuneIpcCmd_GetIoStats:
+                    *out_dataSize = sizeof(IoStats);
+                    impl::GetIoStats((IoStats *)out_data);
+                    return 0;
+
+                case TuneIpcCmd_GetMemoryStats:
+                    *out_dataSize = sizeof(MemoryStats);
+                    impl::GetMemoryStats((MemoryStats *)out_data);
+                    return 0;
+
                 case TuneIpcCmd_GetApiVersion:
                     *out_dataSize    = sizeof(u32);
                     *(u32 *)out_data = TUNE_API_VERSION;
@@ -22,11 +22,21 @@ namespace tune {
         All,
     };
 
+    enum class ResamplerQuality : u8 {
+        Linear,
+        Cubic,
+        SincShort,
+        Sinc,
+    };
+
     enum class EnqueueType : u8 {
         Front,
         Back,
     };
 
     struct CurrentStats : TuneCurrentStats {};
+    struct IoStats : TuneIoStats {};
+    struct MemoryStats : TuneMemoryStats {};
+    struct ProbeInfo : TuneProbeInfo {};
 
 }
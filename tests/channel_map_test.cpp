@@ -0,0 +1,112 @@
+// runs the same s16 signal through each SDL_GetChannelMapEX() kernel and through an audio stream
+// doing the same channel conversion at the same rate. the stream mixes in float, the kernels in
+// Q15, so they may differ by TOLERANCE. the frame counts are odd and the kernel is also called in
+// uneven pieces, so the simd loops always leave a scalar tail.
+#include "SDL_audioEX.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+    constexpr int TOLERANCE = 1;
+    constexpr int RATE = 48000;
+    constexpr int FRAMES = RATE + 7;
+
+    // a tone per channel, noise and a stretch at full scale to hit the saturation.
+    std::vector<int16_t> MakeSignal(int channels) {
+        std::vector<int16_t> out(size_t(FRAMES) * channels);
+        uint32_t seed = 1;
+        for (size_t i = 0; i < FRAMES; i++) {
+            const double t = double(i) / RATE;
+            const bool loud = i % (RATE / 4) > RATE / 5;
+            for (int c = 0; c < channels; c++) {
+                seed = seed * 1103515245 + 12345;
+                const double noise = int(seed >> 16 & 0x7FF) - 1024;
+                const double tone = std::sin(2 * M_PI * (220 + 110 * c) * t) * 12000;
+                out[i * channels + c] = int16_t(std::clamp(loud ? (c & 1 ? -32768.0 : 32767.0) : tone + noise, -32768.0, 32767.0));
+            }
+        }
+        return out;
+    }
+
+    std::vector<int16_t> Stream(int channels, const std::vector<int16_t> &in) {
+        const auto stream = SDL_NewAudioStreamEX(AUDIO_S16SYS, channels, RATE, AUDIO_S16SYS, 2, RATE, SDL_RESAMPLER_SINC);
+        std::vector<int16_t> out;
+        if (!stream) {
+            return out;
+        }
+
+        SDL_AudioStreamPutEX(stream, in.data(), in.size() * sizeof(int16_t));
+        SDL_AudioStreamFlushEX(stream);
+        std::vector<int16_t> block(4096 * 2);
+        for (int got; (got = SDL_AudioStreamGetEX(stream, block.data(), block.size() * sizeof(int16_t))) > 0;) {
+            out.insert(out.end(), block.begin(), block.begin() + got / sizeof(int16_t));
+        }
+
+        SDL_FreeAudioStreamEX(stream);
+        return out;
+    }
+
+    bool Compare(const char *name, const std::vector<int16_t> &mapped, const std::vector<int16_t> &reference) {
+        if (mapped.size() != reference.size()) {
+            std::fprintf(stderr, "%s: %zu samples, expected %zu\n", name, mapped.size(), reference.size());
+            return false;
+        }
+
+        int max_diff = 0;
+        for (size_t i = 0; i < mapped.size(); i++) {
+            const int diff = std::abs(mapped[i] - reference[i]);
+            if (diff > TOLERANCE) {
+                std::fprintf(stderr, "%s: differs at sample %zu: %d, expected %d\n", name, i, mapped[i], reference[i]);
+                return false;
+            }
+            max_diff = std::max(max_diff, diff);
+        }
+
+        std::printf("%-24s %7zu frames match, within %d lsb\n", name, mapped.size() / 2, max_diff);
+        return true;
+    }
+
+    bool Check(int channels, const char *layout) {
+        const auto map = SDL_GetChannelMapEX(channels, 2);
+        if (!map) {
+            std::fprintf(stderr, "%s: no kernel\n", layout);
+            return false;
+        }
+
+        const auto signal = MakeSignal(channels);
+        const auto reference = Stream(channels, signal);
+
+        std::vector<int16_t> whole(size_t(FRAMES) * 2);
+        map(signal.data(), whole.data(), FRAMES);
+
+        // pieces of 1 to 11 frames, the way a block that doesn't end on a vector would be split.
+        std::vector<int16_t> pieces(size_t(FRAMES) * 2);
+        for (int done = 0, step = 1; done < FRAMES; done += step, step = step % 11 + 1) {
+            step = std::min(step, FRAMES - done);
+            map(signal.data() + size_t(done) * channels, pieces.data() + size_t(done) * 2, step);
+        }
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "%s to stereo", layout);
+        bool ok = Compare(name, whole, reference);
+        std::snprintf(name, sizeof(name), "%s to stereo, pieces", layout);
+        ok &= Compare(name, pieces, reference);
+        return ok;
+    }
+
+}
+
+int main() {
+    bool ok = true;
+    ok &= Check(1, "mono");
+    ok &= Check(4, "quad");
+    ok &= Check(6, "5.1");
+    ok &= Check(8, "7.1");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+// decode cost of each format the sysmodule plays, on the same signal. every file is decoded
+// to s16 in the sysmodule's block size with the same options as source.cpp (simd on), so
+// the numbers compare the codecs and not the harness.
+#define DR_WAV_IMPLEMENTATION
+#define DR_WAV_NO_STDIO
+#include "dr_wav.h"
+
+#include "decode_bench.hpp"
+#include "vorbis.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace vorbis = tune::impl::vorbis;
+
+namespace {
+
+    constexpr int RUNS = 3;
+    constexpr size_t BLOCK_FRAMES = 1024;
+
+    bool DecodeWav(const void *data, size_t size, Pcm *out) {
+        drwav wav;
+        if (!drwav_init_memory(&wav, data, size, nullptr)) {
+            return false;
+        }
+
+        out->channels    = wav.channels;
+        out->sample_rate = wav.sampleRate;
+        std::vector<s16> block(BLOCK_FRAMES * wav.channels);
+        for (drwav_uint64 read; (read = drwav_read_pcm_frames_s16(&wav, BLOCK_FRAMES, block.data())) != 0;) {
+            out->samples.insert(out->samples.end(), block.begin(), block.begin() + read * wav.channels);
+        }
+
+        drwav_uninit(&wav);
+        return true;
+    }
+
+    bool DecodeVorbis(const void *data, size_t size, Pcm *out) {
+        struct File {
+            const void *data;
+            size_t size;
+        } file{data, size};
+        const auto read = [](void *user, s64 offset, void *buffer, u64 count) {
+            const auto file = static_cast<const File *>(user);
+            if (offset < 0 || u64(offset) + count > file->size) {
+                return false;
+            }
+            std::memcpy(buffer, static_cast<const u8 *>(file->data) + offset, count);
+            return true;
+        };
+        const vorbis::AllocationCallbacks alloc = {
+            .pUserData = nullptr,
+            .onMalloc  = [](size_t sz, void *) { return std::malloc(sz); },
+            .onRealloc = [](void *p, size_t sz, void *) { return std::realloc(p, sz); },
+            .onFree    = [](void *p, void *) { std::free(p); },
+        };
+
+        vorbis::Decoder decoder;
+        if (!decoder.Open(read, &file, size, alloc)) {
+            return false;
+        }
+
+        const auto &info = decoder.GetInfo();
+        out->channels    = info.channels;
+        out->sample_rate = info.sample_rate;
+        std::vector<s16> block(BLOCK_FRAMES * info.channels);
+        for (u64 read; (read = decoder.Decode(block.data(), BLOCK_FRAMES)) != 0;) {
+            out->samples.insert(out->samples.end(), block.begin(), block.begin() + read * info.channels);
+        }
+        return true;
+    }
+
+    struct Codec {
+        const char *extension;
+        const char *name;
+        bool (*decode)(const void *data, size_t size, Pcm *out);
+    };
+
+    const Codec CODECS[] = {
+        {".flac", "flac", SIMD_DECODERS.flac},
+        {".mp3", "mp3", SIMD_DECODERS.mp3},
+        {".wav", "wav", DecodeWav},
+        {".ogg", "vorbis", DecodeVorbis},
+    };
+
+    bool Bench(const char *path) {
+        std::ifstream in(path, std::ios::binary);
+        const std::vector<u8> file{std::istreambuf_iterator<char>(in), {}};
+        const auto ext = std::strrchr(path, '.');
+        const Codec *codec = nullptr;
+        for (const auto &it : CODECS) {
+            if (ext && !std::strcmp(ext, it.extension)) {
+                codec = &it;
+            }
+        }
+        if (file.empty() || !codec) {
+            std::fprintf(stderr, "%s: can't read\n", path);
+            return false;
+        }
+
+        // best of a few runs.
+        double best = 0;
+        Pcm pcm{};
+        for (int i = 0; i < RUNS; i++) {
+            pcm = {};
+            const auto start = std::chrono::steady_clock::now();
+            if (!codec->decode(file.data(), file.size(), &pcm) || pcm.samples.empty()) {
+                std::fprintf(stderr, "%s: decode failed\n", path);
+                return false;
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::max(best, (pcm.samples.size() / pcm.channels) / elapsed.count());
+        }
+
+        // realtime is the share of one core the track needs while it plays.
+        const double seconds = double(pcm.samples.size() / pcm.channels) / pcm.sample_rate;
+        std::printf("%-24s %-6s %5.0f kbps  %6.2f Mfps  %5.2f%% of realtime  %5.1f us per block\n",
+                    std::strrchr(path, '/') ? std::strrchr(path, '/') + 1 : path, codec->name, file.size() * 8 / seconds / 1000,
+                    best / 1e6, pcm.sample_rate / best * 100, BLOCK_FRAMES / best * 1e6);
+        return true;
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s file.flac|file.mp3|file.wav|file.ogg...\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    for (int i = 1; i < argc; i++) {
+        ok &= Bench(argv[i]);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+// checks SDL_ConvertF32ToS16EX, the float to s16 conversion of WANT_FLOAT builds. calls of fewer
+// than 4 samples only run the scalar loop, so a sample at a time is the reference for the simd
+// path. without dither both have to agree exactly, with dither each sample may move by 1 lsb and
+// a constant input has to come out right on average.
+#include "SDL_audioEX.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+    // odd, so every call ends on a scalar tail.
+    constexpr int SAMPLES = 48000 * 4 + 3;
+    // draws per offset for the dither mean.
+    constexpr int DITHER_RUN = 1 << 22;
+    // the mean of a triangular draw over DITHER_RUN samples is off by about 0.0003 lsb.
+    constexpr double MEAN_TOLERANCE = 0.005;
+
+    struct DitherState {
+        uint32_t words[4]{0x9E3779B9, 0x7F4A7C15, 0x94D049BB, 0xBF58476D};
+    };
+
+    // full range and past it, with every fraction of an lsb.
+    std::vector<float> MakeSignal() {
+        std::vector<float> out(SAMPLES);
+        uint32_t seed = 1;
+        for (auto &sample : out) {
+            seed = seed * 1103515245 + 12345;
+            sample = (int(seed >> 8 & 0xFFFF) - 32768) / 30000.0f;
+        }
+        return out;
+    }
+
+    std::vector<int16_t> Convert(const std::vector<float> &in, uint32_t *dither) {
+        std::vector<int16_t> out(in.size());
+        SDL_ConvertF32ToS16EX(in.data(), out.data(), int(in.size()), dither);
+        return out;
+    }
+
+    std::vector<int16_t> ConvertScalar(const std::vector<float> &in) {
+        std::vector<int16_t> out(in.size());
+        for (size_t i = 0; i < in.size(); i++) {
+            SDL_ConvertF32ToS16EX(&in[i], &out[i], 1, nullptr);
+        }
+        return out;
+    }
+
+    bool CheckExact() {
+        const auto signal = MakeSignal();
+        const auto simd = Convert(signal, nullptr);
+        const auto scalar = ConvertScalar(signal);
+        for (size_t i = 0; i < signal.size(); i++) {
+            if (simd[i] != scalar[i]) {
+                std::fprintf(stderr, "no dither: differs at sample %zu: %d, scalar %d\n", i, simd[i], scalar[i]);
+                return false;
+            }
+        }
+
+        std::printf("%-24s %7zu samples match\n", "no dither", signal.size());
+        return true;
+    }
+
+    bool CheckClipping() {
+        const std::vector<float> signal{1.0f, -1.0f, 1.0001f, -1.0001f, 2.0f, -2.0f, 1e30f, -1e30f, 0.99999f, -0.99999f, 0.0f};
+        const std::vector<int16_t> expected{32767, -32767, 32767, -32767, 32767, -32767, 32767, -32767, 32767, -32767, 0};
+
+        // repeated so the same values go through the simd path and the scalar tail.
+        std::vector<float> in;
+        for (int i = 0; i < 5; i++) {
+            in.insert(in.end(), signal.begin(), signal.end());
+        }
+
+        DitherState state;
+        const auto plain = Convert(in, nullptr);
+        const auto dithered = Convert(in, state.words);
+        for (size_t i = 0; i < in.size(); i++) {
+            const int want = expected[i % expected.size()];
+            if (plain[i] != want || std::abs(dithered[i] - want) > 1) {
+                std::fprintf(stderr, "clipping: %g gave %d and %d dithered, expected %d\n", in[i], plain[i], dithered[i], want);
+                return false;
+            }
+        }
+
+        std::printf("%-24s %7zu samples match\n", "clipping", in.size());
+        return true;
+    }
+
+    bool CheckDither() {
+        const auto signal = MakeSignal();
+        DitherState state;
+        const auto plain = Convert(signal, nullptr);
+        const auto dithered = Convert(signal, state.words);
+        for (size_t i = 0; i < signal.size(); i++) {
+            if (std::abs(dithered[i] - plain[i]) > 1) {
+                std::fprintf(stderr, "dither: sample %zu moved from %d to %d\n", i, plain[i], dithered[i]);
+                return false;
+            }
+        }
+
+        // a constant between two steps rounds to the same one every time without dither, with
+        // it the output has to average to the input. fed in blocks like ConvertOut does.
+        double worst = 0;
+        for (const double offset : {0.1, 0.25, 0.5, 0.75, -0.3}) {
+            const std::vector<float> in(4099, float((1000 + offset) / 32767));
+            const double exact = double(in[0]) * 32767;
+            double sum = 0;
+            size_t count = 0;
+            while (count < DITHER_RUN) {
+                for (const auto sample : Convert(in, state.words)) {
+                    sum += sample - exact;
+                    count++;
+                }
+            }
+
+            const double mean = sum / count;
+            if (std::abs(mean) > MEAN_TOLERANCE) {
+                std::fprintf(stderr, "dither: 1000%+.2f lsb averages %+.4f lsb off\n", offset, mean);
+                return false;
+            }
+            worst = std::max(worst, std::abs(mean));
+        }
+
+        std::printf("%-24s %7zu samples within 1 lsb, mean error %.4f lsb\n", "dither", signal.size(), worst);
+        return true;
+    }
+
+}
+
+int main() {
+    bool ok = true;
+    ok &= CheckExact();
+    ok &= CheckClipping();
+    ok &= CheckDither();
+    return ok ? 0 : 1;
+}
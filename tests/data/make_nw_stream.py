@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+# writes the dsp-adpcm bfstm/brstm fixtures for nw_stream_test, along with the pcm a
+# decoder following the dsp spec has to produce from them:
+#   make_nw_stream.py stereo.bfstm stereo.brstm stereo.s16
+# the encoder below runs that decoder in its loop, so the reference is what it decoded.
+# ffmpeg isn't used for it, its adpcm_thp rounds the prediction down instead of to
+# nearest and drifts away from hardware output.
+import math
+import random
+import struct
+import sys
+
+SAMPLE_RATE = 32000
+TOTAL = 8000
+LOOP_START = 14 * 200
+# small blocks, so the fixtures hold a few of them and a short last one.
+BLOCK_SIZE = 0x800
+BLOCK_SAMPLES = BLOCK_SIZE // 8 * 14
+COEFS = [(0, 0), (2048, 0), (0, 2048), (1024, 1024), (4096, -2048), (3584, -1536), (3072, -1024), (4608, -2560)]
+
+
+def clamp16(v):
+    return max(-0x8000, min(0x7FFF, v))
+
+
+def signal(channel):
+    rng = random.Random(channel + 1)
+    out = []
+    for i in range(TOTAL):
+        t = i / SAMPLE_RATE
+        v = 0.4 * math.sin(2 * math.pi * (220 + 180 * channel) * t * (1 + t))
+        v += 0.2 * math.sin(2 * math.pi * 3000 * t) * (i % 4000) / 4000
+        v += rng.uniform(-0.05, 0.05)
+        out.append(clamp16(int(v * 32767)))
+    return out
+
+
+def encode_frame(samples, h1, h2):
+    # brute force over every predictor and scale, keeping what decodes closest.
+    best = None
+    for predictor, (c1, c2) in enumerate(COEFS):
+        for shift in range(12):
+            scale = 1 << shift
+            p1, p2, error, nibbles, decoded = h1, h2, 0, [], []
+            for x in samples:
+                predicted = (c1 * p1 + c2 * p2 + 1024) >> 11
+                nibble = max(-8, min(7, round((x - predicted) / scale)))
+                y = clamp16((((nibble * scale) << 11) + 1024 + c1 * p1 + c2 * p2) >> 11)
+                error += (x - y) ** 2
+                nibbles.append(nibble & 0xF)
+                decoded.append(y)
+                p1, p2 = y, p1
+            if best is None or error < best[0]:
+                best = (error, predictor << 4 | shift, nibbles, decoded, p1, p2)
+    _, header, nibbles, decoded, h1, h2 = best
+    nibbles += [0] * (14 - len(nibbles))
+    return bytes([header] + [nibbles[i] << 4 | nibbles[i + 1] for i in range(0, 14, 2)]), decoded, h1, h2
+
+
+def encode(samples):
+    data, decoded, history, loop_context = bytearray(), [], [], None
+    h1 = h2 = 0
+    for start in range(0, len(samples), 14):
+        if start % BLOCK_SAMPLES == 0:
+            history.append((h1, h2))
+        if start == LOOP_START:
+            loop_context = (h1, h2)
+        frame, frame_decoded, h1, h2 = encode_frame(samples[start:start + 14], h1, h2)
+        if start == LOOP_START:
+            loop_context = (frame[0],) + loop_context
+        data += frame
+        decoded += frame_decoded
+    return bytes(data), history, loop_context, decoded
+
+
+def layout():
+    blocks = (TOTAL + BLOCK_SAMPLES - 1) // BLOCK_SAMPLES
+    last_samples = TOTAL - (blocks - 1) * BLOCK_SAMPLES
+    last_size = (last_samples + 13) // 14 * 8
+    last_padded = (last_size + 0x1F) & ~0x1F
+    return blocks, last_samples, last_size, last_padded
+
+
+def interleave(channels):
+    blocks, _, last_size, last_padded = layout()
+    out = bytearray()
+    for b in range(blocks):
+        for data, *_ in channels:
+            chunk = data[b * BLOCK_SIZE:(b + 1) * BLOCK_SIZE]
+            out += chunk + bytes((last_padded if b == blocks - 1 else BLOCK_SIZE) - len(chunk))
+    return bytes(out)
+
+
+def adpcm_info(e, channel, gain):
+    data, history, loop, _ = channel
+    coefs = b''.join(struct.pack(e + 'hh', *c) for c in COEFS)
+    return coefs + (struct.pack(e + 'H', 0) if gain else b'') + struct.pack(e + 'Hhh', data[0], 0, 0) + struct.pack(e + 'Hhh', *loop)
+
+
+def align(data, n=0x20):
+    return data + bytes(-len(data) % n)
+
+
+def write_bfstm(path, channels):
+    e = '<'
+    blocks, last_samples, last_size, last_padded = layout()
+    count = len(channels)
+
+    stream = struct.pack(e + 'BBBBIIIIIIIIIII', 2, 1, count, 0, SAMPLE_RATE, LOOP_START, TOTAL, blocks, BLOCK_SIZE,
+                         BLOCK_SAMPLES, last_size, last_samples, last_padded, 4, BLOCK_SAMPLES)
+    stream += struct.pack(e + 'HHI', 0x1F00, 0, 0x18)
+    track = struct.pack(e + 'I', 0)
+    # channel table: count, references to the channel infos, each pointing at its adpcm info.
+    table = struct.pack(e + 'I', count)
+    infos = b''
+    base = 4 + count * 8
+    for c, channel in enumerate(channels):
+        table += struct.pack(e + 'HHI', 0x4102, 0, base + len(infos))
+        infos += struct.pack(e + 'HHI', 0x0300, 0, 8) + adpcm_info(e, channel, False)
+    table += infos
+
+    stream_at = 0x18
+    track_at = stream_at + len(stream)
+    table_at = track_at + len(track)
+    refs = struct.pack(e + 'HHi', 0x4100, 0, stream_at) + struct.pack(e + 'HHi', 0x0101, 0, track_at) + struct.pack(e + 'HHi', 0x0101, 0, table_at)
+    body = align(refs + stream + track + table)
+    info = b'INFO' + struct.pack(e + 'I', 8 + len(body)) + body
+
+    seek_body = b''.join(struct.pack(e + 'hh', *channel[1][b]) for b in range(blocks) for channel in channels)
+    seek_body = align(seek_body)
+    seek = b'SEEK' + struct.pack(e + 'I', 8 + len(seek_body)) + seek_body
+
+    data_body = bytes(0x18) + interleave(channels)
+    data = b'DATA' + struct.pack(e + 'I', 8 + len(data_body)) + data_body
+
+    header_size = 0x40
+    info_at = header_size
+    seek_at = info_at + len(info)
+    data_at = seek_at + len(seek)
+    header = b'FSTM' + b'\xff\xfe' + struct.pack(e + 'HIIHH', header_size, 0x00040000, data_at + len(data), 3, 0)
+    header += struct.pack(e + 'HHII', 0x4000, 0, info_at, len(info))
+    header += struct.pack(e + 'HHII', 0x4001, 0, seek_at, len(seek))
+    header += struct.pack(e + 'HHII', 0x4002, 0, data_at, len(data))
+    header = align(header, header_size)
+
+    with open(path, 'wb') as f:
+        f.write(header + info + seek + data)
+
+
+def write_brstm(path, channels):
+    e = '>'
+    blocks, last_samples, last_size, last_padded = layout()
+    count = len(channels)
+
+    header_size = 0x40
+    adpc_body = align(b''.join(struct.pack(e + 'hh', *channel[1][b]) for b in range(blocks) for channel in channels))
+    adpc = b'ADPC' + struct.pack(e + 'I', 8 + len(adpc_body)) + adpc_body
+
+    # head, offsets relative to its 8th byte: stream info, track table, channel table.
+    stream_at = 0x18
+    stream_size = 0x34
+    track_at = stream_at + stream_size
+    track = struct.pack(e + 'BBH', 1, 0, 0) + struct.pack(e + 'BBHI', 1, 0, 0, track_at + 12) + struct.pack(e + 'BBBB', count, 0, 1, 0)
+    table_at = track_at + len(track)
+    table = struct.pack(e + 'BBH', count, 0, 0)
+    infos = b''
+    base = table_at + 4 + count * 8
+    for channel in channels:
+        table += struct.pack(e + 'BBHI', 1, 0, 0, base + len(infos))
+        infos += struct.pack(e + 'BBHI', 1, 0, 0, base + len(infos) + 8) + adpcm_info(e, channel, True) + bytes(2)
+    table += infos
+    refs = struct.pack(e + 'BBHI', 1, 0, 0, stream_at) + struct.pack(e + 'BBHI', 1, 0, 0, track_at) + struct.pack(e + 'BBHI', 1, 0, 0, table_at)
+
+    head_len = len(align(b'HEAD' + bytes(4) + refs + bytes(stream_size) + track + table))
+    data_at = header_size + head_len + len(adpc)
+    stream = struct.pack(e + 'BBBBHHIIIIIIIIIII', 2, 1, count, 0, SAMPLE_RATE, 0, LOOP_START, TOTAL, data_at + 0x20, blocks,
+                         BLOCK_SIZE, BLOCK_SAMPLES, last_size, last_samples, last_padded, BLOCK_SAMPLES, 4)
+    assert len(stream) == stream_size
+    head = align(b'HEAD' + bytes(4) + refs + stream + track + table)
+    head = head[:4] + struct.pack(e + 'I', len(head)) + head[8:]
+
+    data_body = struct.pack(e + 'I', 0x18) + bytes(0x14) + interleave(channels)
+    data = b'DATA' + struct.pack(e + 'I', 8 + len(data_body)) + data_body
+
+    head_at = header_size
+    adpc_at = head_at + len(head)
+    size = data_at + len(data)
+    header = b'RSTM' + b'\xfe\xff' + struct.pack(e + 'HIHH', 0x0100, size, header_size, 3)
+    header += struct.pack(e + 'IIIIII', head_at, len(head), adpc_at, len(adpc), data_at, len(data))
+    header = align(header, header_size)
+
+    with open(path, 'wb') as f:
+        f.write(header + head + adpc + data)
+
+
+def main():
+    channels = [encode(signal(c)) for c in range(2)]
+    write_bfstm(sys.argv[1], channels)
+    write_brstm(sys.argv[2], channels)
+
+    with open(sys.argv[3], 'wb') as f:
+        for frame in zip(*(channel[3] for channel in channels)):
+            f.write(struct.pack('<' + 'h' * len(frame), *frame))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,96 @@
+// decodes each file with the scalar and the simd builds of dr_flac/dr_mp3, fails unless
+// both give the same samples and prints the decode speed of each.
+// on the switch (aarch64) the simd paths are neon, on x86 hosts they are sse.
+// flac is integer only and has to match exactly. mp3 synthesis is float, the simd path
+// adds in a different order and rounds to s16 differently, so it may be 1 lsb off.
+#include "decode_bench.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+    constexpr int RUNS = 3;
+
+    // best of a few runs, in frames per second.
+    double Measure(bool (*decode)(const void *, size_t, Pcm *), const std::vector<u8> &file, Pcm *out) {
+        double best = 0;
+        for (int i = 0; i < RUNS; i++) {
+            Pcm pcm{};
+            const auto start = std::chrono::steady_clock::now();
+            if (!decode(file.data(), file.size(), &pcm)) {
+                return 0;
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            const double fps = (pcm.samples.size() / pcm.channels) / elapsed.count();
+            if (fps > best) {
+                best = fps;
+            }
+            *out = std::move(pcm);
+        }
+        return best;
+    }
+
+    bool Bench(const char *path) {
+        std::ifstream in(path, std::ios::binary);
+        const std::vector<u8> file{std::istreambuf_iterator<char>(in), {}};
+        if (file.empty()) {
+            std::fprintf(stderr, "%s: can't read\n", path);
+            return false;
+        }
+
+        const auto ext = std::strrchr(path, '.');
+        const bool mp3 = ext && !std::strcmp(ext, ".mp3");
+        const auto scalar_decode = mp3 ? SCALAR_DECODERS.mp3 : SCALAR_DECODERS.flac;
+        const auto simd_decode   = mp3 ? SIMD_DECODERS.mp3 : SIMD_DECODERS.flac;
+        const int tolerance      = mp3 ? 1 : 0;
+
+        Pcm scalar, simd;
+        const auto scalar_fps = Measure(scalar_decode, file, &scalar);
+        const auto simd_fps   = Measure(simd_decode, file, &simd);
+        if (!scalar_fps || !simd_fps) {
+            std::fprintf(stderr, "%s: decode failed\n", path);
+            return false;
+        }
+
+        size_t mismatch = 0;
+        int max_diff = 0;
+        const auto count = std::min(scalar.samples.size(), simd.samples.size());
+        for (size_t i = 0; i < count; i++) {
+            mismatch += scalar.samples[i] != simd.samples[i];
+            max_diff = std::max(max_diff, std::abs(scalar.samples[i] - simd.samples[i]));
+        }
+        const bool length_differs = scalar.samples.size() != simd.samples.size();
+        const bool ok = !length_differs && max_diff <= tolerance;
+
+        std::printf("%-24s %7zu frames  %uHz %uch  scalar %6.2f Mfps  simd %6.2f Mfps  x%.2f  %s\n",
+                    std::strrchr(path, '/') ? std::strrchr(path, '/') + 1 : path, scalar.samples.size() / scalar.channels,
+                    scalar.sample_rate, scalar.channels, scalar_fps / 1e6, simd_fps / 1e6, simd_fps / scalar_fps,
+                    !ok ? "MISMATCH" : mismatch ? "within 1 lsb" : "bit-exact");
+        if (length_differs) {
+            std::fprintf(stderr, "%s: %zu vs %zu samples\n", path, scalar.samples.size(), simd.samples.size());
+        } else if (mismatch) {
+            std::fprintf(stderr, "%s: %zu samples differ, by up to %d\n", path, mismatch, max_diff);
+        }
+        return ok;
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s file.flac|file.mp3...\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    for (int i = 1; i < argc; i++) {
+        ok &= Bench(argv[i]);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <switch.h>
+#include <vector>
+
+struct Pcm {
+    u32 channels;
+    u32 sample_rate;
+    std::vector<s16> samples;
+};
+
+struct Decoders {
+    bool (*flac)(const void *data, size_t size, Pcm *out);
+    bool (*mp3)(const void *data, size_t size, Pcm *out);
+};
+
+extern const Decoders SCALAR_DECODERS;
+extern const Decoders SIMD_DECODERS;
@@ -0,0 +1,73 @@
+// built twice by the Makefile, once with the simd paths and once without. the dr_libs
+// functions are made static so both copies can link into the same binary.
+#define DRFLAC_API static
+#define DRFLAC_PRIVATE static
+#define DRMP3_API static
+#define DRMP3_PRIVATE static
+
+// same options as source.cpp.
+#ifdef DECODE_SCALAR
+#define DR_FLAC_NO_SIMD
+#define DR_MP3_NO_SIMD
+#endif
+
+#define DR_FLAC_IMPLEMENTATION
+#define DR_FLAC_NO_OGG
+#define DR_FLAC_NO_STDIO
+#include "dr_flac.h"
+
+#define DR_MP3_IMPLEMENTATION
+#define DR_MP3_NO_STDIO
+#define DRMP3_DATA_CHUNK_SIZE DRMP3_MIN_DATA_CHUNK_SIZE
+#include "dr_mp3.h"
+
+#include "decode_bench.hpp"
+
+#include <vector>
+
+namespace {
+
+    // same block the sysmodule decodes into.
+    constexpr size_t BLOCK_FRAMES = 1024;
+
+    bool DecodeFlac(const void *data, size_t size, Pcm *out) {
+        auto flac = drflac_open_memory(data, size, nullptr);
+        if (!flac) {
+            return false;
+        }
+
+        out->channels    = flac->channels;
+        out->sample_rate = flac->sampleRate;
+        std::vector<s16> block(BLOCK_FRAMES * flac->channels);
+        for (drflac_uint64 read; (read = drflac_read_pcm_frames_s16(flac, BLOCK_FRAMES, block.data())) != 0;) {
+            out->samples.insert(out->samples.end(), block.begin(), block.begin() + read * flac->channels);
+        }
+
+        drflac_close(flac);
+        return true;
+    }
+
+    bool DecodeMp3(const void *data, size_t size, Pcm *out) {
+        drmp3 mp3;
+        if (!drmp3_init_memory(&mp3, data, size, nullptr)) {
+            return false;
+        }
+
+        out->channels    = mp3.channels;
+        out->sample_rate = mp3.sampleRate;
+        std::vector<s16> block(BLOCK_FRAMES * mp3.channels);
+        for (drmp3_uint64 read; (read = drmp3_read_pcm_frames_s16(&mp3, BLOCK_FRAMES, block.data())) != 0;) {
+            out->samples.insert(out->samples.end(), block.begin(), block.begin() + read * mp3.channels);
+        }
+
+        drmp3_uninit(&mp3);
+        return true;
+    }
+
+}
+
+#ifdef DECODE_SCALAR
+const Decoders SCALAR_DECODERS = {DecodeFlac, DecodeMp3};
+#else
+const Decoders SIMD_DECODERS = {DecodeFlac, DecodeMp3};
+#endif
@@ -0,0 +1,146 @@
+// decodes a flac stream the way FlacFile does with parallel_decode on, the main decoder
+// handing shares of it to a second one through the TUNE-FIX frame functions, and checks
+// the result against a plain serial decode.
+#define DR_FLAC_IMPLEMENTATION
+#define DR_FLAC_NO_OGG
+#define DR_FLAC_NO_STDIO
+#include "dr_flac.h"
+
+#include <switch.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+    struct Stream {
+        const std::vector<u8> *file;
+        s64 offset;
+    };
+
+    size_t Read(void *user, void *out, size_t size) {
+        auto stream = static_cast<Stream *>(user);
+        size = std::min<size_t>(size, stream->file->size() - stream->offset);
+        std::memcpy(out, stream->file->data() + stream->offset, size);
+        stream->offset += size;
+        return size;
+    }
+
+    drflac_bool32 Seek(void *user, int offset, drflac_seek_origin origin) {
+        auto stream = static_cast<Stream *>(user);
+        switch (origin) {
+            case DRFLAC_SEEK_SET: stream->offset = offset; break;
+            case DRFLAC_SEEK_CUR: stream->offset += offset; break;
+            case DRFLAC_SEEK_END: stream->offset = stream->file->size() + offset; break;
+        }
+        return stream->offset >= 0 && stream->offset <= s64(stream->file->size());
+    }
+
+    drflac_bool32 Tell(void *user, drflac_int64 *cursor) {
+        *cursor = static_cast<Stream *>(user)->offset;
+        return true;
+    }
+
+    void ReadInto(drflac *flac, u64 frames, std::vector<s16> *out) {
+        const auto size = out->size();
+        out->resize(size + frames * flac->channels);
+        frames = drflac_read_pcm_frames_s16(flac, frames, out->data() + size);
+        out->resize(size + frames * flac->channels);
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s file.flac\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    const std::vector<u8> file{std::istreambuf_iterator<char>(in), {}};
+    Stream serial_stream{&file}, main_stream{&file}, worker_stream{&file};
+
+    const auto serial = drflac_open(Read, Seek, Tell, &serial_stream, nullptr);
+    const auto flac   = drflac_open(Read, Seek, Tell, &main_stream, nullptr);
+    const auto worker = drflac_open(Read, Seek, Tell, &worker_stream, nullptr);
+    if (!serial || !flac || !worker) {
+        std::fprintf(stderr, "%s: can't open\n", argv[1]);
+        return 1;
+    }
+
+    const u64 total = flac->totalPCMFrameCount;
+    const u64 chunk = flac->maxBlockSizeInPCMFrames;
+    std::vector<s16> expected, split, share;
+    ReadInto(serial, total, &expected);
+
+    u32 jobs = 0;
+    for (;;) {
+        const s64 position = main_stream.offset - drflac_get_unread_byte_count(flac);
+        const s64 hint = position + chunk * (file.size() - flac->firstFLACFramePosInBytes) / total;
+        const u64 inline_end = flac->currentPCMFrame + flac->currentFLACFrame.pcmFramesRemaining;
+
+        drflac_uint64 first;
+        if (hint >= s64(file.size()) || !drflac_find_flac_frame(worker, hint, inline_end, &first)) {
+            const auto size = split.size();
+            ReadInto(flac, chunk, &split);
+            if (split.size() == size) {
+                break;
+            }
+            continue;
+        }
+
+        ReadInto(flac, first - flac->currentPCMFrame, &split);
+        if (flac->currentPCMFrame != first || flac->currentFLACFrame.pcmFramesRemaining) {
+            std::fprintf(stderr, "%s: main decoder stopped at %llu, share starts at %llu\n", argv[1], (unsigned long long)flac->currentPCMFrame, (unsigned long long)first);
+            return 1;
+        }
+
+        // the worker finishes the frame it is in once it has a chunk.
+        share.clear();
+        if (!drflac_decode_flac_frame(worker)) {
+            std::fprintf(stderr, "%s: worker failed at %llu\n", argv[1], (unsigned long long)first);
+            return 1;
+        }
+        while (share.size() / worker->channels < chunk || worker->currentFLACFrame.pcmFramesRemaining) {
+            const auto size = share.size();
+            ReadInto(worker, std::max<u64>(worker->currentFLACFrame.pcmFramesRemaining, 1), &share);
+            if (share.size() == size) {
+                break;
+            }
+        }
+
+        const u64 end = first + share.size() / worker->channels;
+        const s64 end_offset = worker_stream.offset - drflac_get_unread_byte_count(worker);
+        drflac_uint64 next = total;
+        if (end < total && (!drflac_find_flac_frame(worker, end_offset, 0, &next) || next != end)) {
+            std::fprintf(stderr, "%s: share ends at %llu, next frame starts at %llu\n", argv[1], (unsigned long long)end, (unsigned long long)next);
+            return 1;
+        }
+
+        split.insert(split.end(), share.begin(), share.end());
+        jobs++;
+
+        if (end >= total) {
+            break;
+        }
+        if (!drflac_find_flac_frame(flac, end_offset, end, &next) || next != end || !drflac_decode_flac_frame(flac)) {
+            std::fprintf(stderr, "%s: main decoder can't pick up at %llu\n", argv[1], (unsigned long long)end);
+            return 1;
+        }
+    }
+
+    drflac_close(serial);
+    drflac_close(flac);
+    drflac_close(worker);
+
+    if (split != expected) {
+        std::fprintf(stderr, "%s: split decode differs from the serial one\n", argv[1]);
+        return 1;
+    }
+
+    std::printf("%s: %u shares, %llu frames match\n", argv[1], jobs, (unsigned long long)total);
+    return 0;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// the LockableMutex the host builds of arena.cpp need.
+#include <mutex>
+
+using LockableMutex = std::mutex;
@@ -0,0 +1,279 @@
+// heap each open track needs besides the shared buffers. the decoder goes through the same
+// Arena and options as source.cpp, one file per run since the high water is kept for the
+// whole process. built with WANT_DUALCORE, a hi-res stereo flac also opens the parallel
+// decode worker's decoder in the same arena. the SDL stream to 48kHz stereo is fed the way Source::ResampleStream feeds it
+// and measured from malloc's own count, s16 is the default build and f32 WANT_FLOAT.
+#define DR_FLAC_IMPLEMENTATION
+#define DR_FLAC_NO_STDIO
+#include "dr_flac.h"
+
+#define DR_MP3_IMPLEMENTATION
+#define DR_MP3_NO_STDIO
+#define DRMP3_DATA_CHUNK_SIZE DRMP3_MIN_DATA_CHUNK_SIZE
+#include "dr_mp3.h"
+
+#define DR_WAV_IMPLEMENTATION
+#define DR_WAV_NO_STDIO
+#include "dr_wav.h"
+
+#include "arena.hpp"
+#include "vorbis.hpp"
+#include "SDL_audioEX.h"
+
+#include <malloc.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace vorbis = tune::impl::vorbis;
+
+namespace {
+
+    // same block the sysmodule decodes into.
+    constexpr size_t BLOCK_FRAMES = 1024;
+    // Source::m_resample_buffer and the audio block it fills.
+    constexpr size_t PUT_BYTES = 1024 * 8;
+    constexpr size_t GET_BYTES = 48000 / 1000 * 42 * 2 * sizeof(s16);
+    constexpr int OUTPUT_RATE = 48000;
+    constexpr int OUTPUT_CHANNELS = 2;
+
+    struct Pcm {
+        int channels;
+        int sample_rate;
+        std::vector<s16> samples;
+    };
+
+    // what didn't fit in the slot, sampled while the decoder is open.
+    u32 g_fallback_peak = 0;
+
+    void Append(Pcm *out, const s16 *block, size_t samples) {
+        out->samples.insert(out->samples.end(), block, block + samples);
+        g_fallback_peak = std::max(g_fallback_peak, Arena::GetFallbackBytes());
+    }
+
+    struct File {
+        std::vector<u8> data;
+        size_t offset;
+    };
+
+    size_t Read(void *user, void *buffer, size_t size) {
+        const auto file = static_cast<File *>(user);
+        size = std::min(size, file->data.size() - file->offset);
+        std::memcpy(buffer, file->data.data() + file->offset, size);
+        file->offset += size;
+        return size;
+    }
+
+    bool Seek(File *file, s64 offset, bool current, bool end) {
+        const s64 base = current ? s64(file->offset) : end ? s64(file->data.size()) : 0;
+        if (base + offset < 0 || size_t(base + offset) > file->data.size()) {
+            return false;
+        }
+        file->offset = base + offset;
+        return true;
+    }
+
+    drflac_bool32 FlacSeek(void *user, int offset, drflac_seek_origin origin) {
+        return Seek(static_cast<File *>(user), offset, origin == DRFLAC_SEEK_CUR, origin == DRFLAC_SEEK_END);
+    }
+
+    drflac_bool32 FlacTell(void *user, drflac_int64 *cursor) {
+        *cursor = static_cast<File *>(user)->offset;
+        return true;
+    }
+
+    drmp3_bool32 Mp3Seek(void *user, int offset, drmp3_seek_origin origin) {
+        return Seek(static_cast<File *>(user), offset, origin == DRMP3_SEEK_CUR, origin == DRMP3_SEEK_END);
+    }
+
+    drmp3_bool32 Mp3Tell(void *user, drmp3_int64 *cursor) {
+        *cursor = static_cast<File *>(user)->offset;
+        return true;
+    }
+
+    drwav_bool32 WavSeek(void *user, int offset, drwav_seek_origin origin) {
+        return Seek(static_cast<File *>(user), offset, origin == DRWAV_SEEK_CUR, origin == DRWAV_SEEK_END);
+    }
+
+    drwav_bool32 WavTell(void *user, drwav_int64 *cursor) {
+        *cursor = static_cast<File *>(user)->offset;
+        return true;
+    }
+
+    bool DecodeFlac(File *file, Arena *arena, Pcm *out) {
+        const auto alloc = arena->GetCallbacks<drflac_allocation_callbacks>();
+        const auto flac = drflac_open(Read, FlacSeek, FlacTell, file, &alloc);
+        if (!flac) {
+            return false;
+        }
+
+        // opened by OpenWorker(), on its own handle.
+        File worker_file{file->data, 0};
+        drflac *worker = nullptr;
+#ifdef WANT_DUALCORE
+        if (flac->sampleRate > 48000 && flac->channels <= 2) {
+            worker = drflac_open(Read, FlacSeek, FlacTell, &worker_file, &alloc);
+        }
+#endif
+
+        *out = {flac->channels, int(flac->sampleRate), {}};
+        std::vector<s16> block(BLOCK_FRAMES * flac->channels);
+        for (drflac_uint64 read; (read = drflac_read_pcm_frames_s16(flac, BLOCK_FRAMES, block.data())) != 0;) {
+            Append(out, block.data(), read * flac->channels);
+        }
+
+        drflac_close(worker);
+        drflac_close(flac);
+        return true;
+    }
+
+    bool DecodeMp3(File *file, Arena *arena, Pcm *out) {
+        const auto alloc = arena->GetCallbacks<drmp3_allocation_callbacks>();
+        drmp3 mp3;
+        if (!drmp3_init(&mp3, Read, Mp3Seek, Mp3Tell, nullptr, file, &alloc)) {
+            return false;
+        }
+
+        *out = {int(mp3.channels), int(mp3.sampleRate), {}};
+        std::vector<s16> block(BLOCK_FRAMES * mp3.channels);
+        for (drmp3_uint64 read; (read = drmp3_read_pcm_frames_s16(&mp3, BLOCK_FRAMES, block.data())) != 0;) {
+            Append(out, block.data(), read * mp3.channels);
+        }
+
+        drmp3_uninit(&mp3);
+        return true;
+    }
+
+    bool DecodeWav(File *file, Arena *arena, Pcm *out) {
+        const auto alloc = arena->GetCallbacks<drwav_allocation_callbacks>();
+        drwav wav;
+        if (!drwav_init(&wav, Read, WavSeek, WavTell, file, &alloc)) {
+            return false;
+        }
+
+        *out = {wav.channels, int(wav.sampleRate), {}};
+        std::vector<s16> block(BLOCK_FRAMES * wav.channels);
+        for (drwav_uint64 read; (read = drwav_read_pcm_frames_s16(&wav, BLOCK_FRAMES, block.data())) != 0;) {
+            Append(out, block.data(), read * wav.channels);
+        }
+
+        drwav_uninit(&wav);
+        return true;
+    }
+
+    bool DecodeVorbis(File *file, Arena *arena, Pcm *out) {
+        const auto read = [](void *user, s64 offset, void *buffer, u64 count) {
+            const auto file = static_cast<const File *>(user);
+            if (offset < 0 || u64(offset) + count > file->data.size()) {
+                return false;
+            }
+            std::memcpy(buffer, file->data.data() + offset, count);
+            return true;
+        };
+
+        vorbis::Decoder decoder;
+        if (!decoder.Open(read, file, file->data.size(), arena->GetCallbacks<vorbis::AllocationCallbacks>())) {
+            return false;
+        }
+
+        const auto &info = decoder.GetInfo();
+        *out = {int(info.channels), int(info.sample_rate), {}};
+        std::vector<s16> block(BLOCK_FRAMES * info.channels);
+        for (u64 read; (read = decoder.Decode(block.data(), BLOCK_FRAMES)) != 0;) {
+            Append(out, block.data(), read * info.channels);
+        }
+        return true;
+    }
+
+    size_t HeapUsed() {
+        return mallinfo2().uordblks;
+    }
+
+    // most heap the stream held at any point of the track, 0 when it plays without one.
+    template<typename T>
+    size_t StreamMemory(const Pcm &pcm, SDL_AudioFormat format) {
+        if (pcm.sample_rate == OUTPUT_RATE) {
+            return 0;
+        }
+
+        std::vector<T> in(pcm.samples.size());
+        if constexpr (std::is_same_v<T, float>) {
+            std::transform(pcm.samples.begin(), pcm.samples.end(), in.begin(), [](s16 v) { return v / 32768.0f; });
+        } else {
+            in = pcm.samples;
+        }
+        std::vector<u8> out(GET_BYTES * sizeof(T) / sizeof(s16));
+
+        const auto before = HeapUsed();
+        size_t peak = 0;
+        const auto stream = SDL_NewAudioStreamEX(format, pcm.channels, pcm.sample_rate, format, OUTPUT_CHANNELS, OUTPUT_RATE, SDL_RESAMPLER_SINC);
+        for (size_t done = 0; stream && done < in.size() * sizeof(T);) {
+            const auto put = std::min(PUT_BYTES, in.size() * sizeof(T) - done);
+            SDL_AudioStreamPutEX(stream, reinterpret_cast<const u8 *>(in.data()) + done, put);
+            done += put;
+            while (SDL_AudioStreamGetEX(stream, out.data(), out.size()) > 0) {
+            }
+            peak = std::max(peak, HeapUsed() - before);
+        }
+        SDL_FreeAudioStreamEX(stream);
+        return peak;
+    }
+
+    struct Codec {
+        const char *extension;
+        const char *name;
+        bool (*decode)(File *file, Arena *arena, Pcm *out);
+    };
+
+    const Codec CODECS[] = {
+        {".flac", "flac", DecodeFlac},
+        {".mp3", "mp3", DecodeMp3},
+        {".wav", "wav", DecodeWav},
+        {".ogg", "vorbis", DecodeVorbis},
+    };
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s file.flac|file.mp3|file.wav|file.ogg\n", argv[0]);
+        return 1;
+    }
+
+    const auto path = argv[1];
+    std::ifstream in(path, std::ios::binary);
+    File file{{std::istreambuf_iterator<char>(in), {}}, 0};
+    const auto ext = std::strrchr(path, '.');
+    const Codec *codec = nullptr;
+    for (const auto &it : CODECS) {
+        if (ext && !std::strcmp(ext, it.extension)) {
+            codec = &it;
+        }
+    }
+    if (file.data.empty() || !codec) {
+        std::fprintf(stderr, "%s: can't read\n", path);
+        return 1;
+    }
+
+    Pcm pcm;
+    {
+        Arena arena;
+        if (!codec->decode(&file, &arena, &pcm)) {
+            std::fprintf(stderr, "%s: decode failed\n", path);
+            return 1;
+        }
+        if (g_fallback_peak) {
+            std::fprintf(stderr, "%s: %u bytes didn't fit in the arena\n", path, g_fallback_peak);
+            return 1;
+        }
+    }
+
+    std::printf("%-24s %-6s decoder %6u bytes of a %zu byte arena, stream %6zu bytes s16 %6zu bytes f32\n",
+                std::strrchr(path, '/') ? std::strrchr(path, '/') + 1 : path, codec->name, Arena::GetHighWater(), Arena::SIZE,
+                StreamMemory<s16>(pcm, AUDIO_S16SYS), StreamMemory<float>(pcm, AUDIO_F32SYS));
+    return 0;
+}
@@ -0,0 +1,154 @@
+// decodes the bfstm/brstm fixtures in data/ through nw_stream::Decoder and compares them
+// sample for sample with data/stereo.s16. with --bench it reports the decode speed instead.
+#include "nw_stream.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace nw_stream = tune::impl::nw_stream;
+
+namespace {
+
+    // what make_nw_stream.py writes.
+    constexpr u32 SAMPLE_RATE = 32000;
+    constexpr u32 TOTAL = 8000;
+    constexpr u32 LOOP_START = 14 * 200;
+    constexpr u32 BLOCK_SAMPLES = 0x800 / 8 * 14;
+
+    std::vector<u8> Load(const char *path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), {}};
+    }
+
+    bool ReadAt(void *user, s64 offset, void *buffer, u64 size) {
+        const auto file = static_cast<const std::vector<u8> *>(user);
+        if (offset < 0 || u64(offset) + size > file->size()) {
+            return false;
+        }
+        std::memcpy(buffer, file->data() + offset, size);
+        return true;
+    }
+
+    // decodes in uneven steps so reads start and stop inside frames and blocks.
+    std::vector<s16> DecodeAll(nw_stream::Decoder &decoder, u64 frames) {
+        std::vector<s16> out(frames * decoder.GetChannelCount());
+        u64 done = 0;
+        for (u64 step = 1; done < frames; step = step * 3 % 1000 + 1) {
+            const auto got = decoder.Decode(out.data() + done * decoder.GetChannelCount(), std::min(step, frames - done));
+            if (!got) {
+                break;
+            }
+            done += got;
+        }
+        out.resize(done * decoder.GetChannelCount());
+        return out;
+    }
+
+    bool Compare(const char *path, const char *what, const std::vector<s16> &got, const std::vector<s16> &expected, u64 first) {
+        const auto begin = expected.begin() + first * 2;
+        if (got.size() != size_t(expected.end() - begin)) {
+            std::fprintf(stderr, "%s: %s decoded %zu samples\n", path, what, got.size());
+            return false;
+        }
+
+        for (size_t i = 0; i < got.size(); i++) {
+            if (got[i] != begin[i]) {
+                std::fprintf(stderr, "%s: %s differs at frame %zu: %d, expected %d\n", path, what, first + i / 2, got[i], begin[i]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Check(const char *path, const std::vector<s16> &expected) {
+        auto file = Load(path);
+        nw_stream::Decoder decoder;
+        if (!decoder.Open(ReadAt, &file, file.size())) {
+            std::fprintf(stderr, "%s: can't open\n", path);
+            return false;
+        }
+
+        const auto &info = decoder.GetInfo();
+        if (info.codec != nw_stream::Codec::DspAdpcm || info.sample_rate != SAMPLE_RATE || decoder.GetChannelCount() != 2 ||
+            info.total_samples != TOTAL || !info.loop || info.loop_start != LOOP_START || !info.seek_offset) {
+            std::fprintf(stderr, "%s: unexpected stream info\n", path);
+            return false;
+        }
+
+        if (!Compare(path, "full decode", DecodeAll(decoder, TOTAL), expected, 0)) {
+            return false;
+        }
+        if (decoder.Decode(nullptr, 1)) {
+            std::fprintf(stderr, "%s: decodes past the end\n", path);
+            return false;
+        }
+
+        // history from the seek table, then decoding up to a target inside a frame.
+        for (const u64 target : {u64(BLOCK_SAMPLES), u64(BLOCK_SAMPLES * 2 + 5), u64(100), u64(TOTAL - 3)}) {
+            char what[32];
+            std::snprintf(what, sizeof(what), "seek to %llu", (unsigned long long)target);
+            if (!decoder.Seek(target) || decoder.GetPosition() != target || !Compare(path, what, DecodeAll(decoder, TOTAL - target), expected, target)) {
+                return false;
+            }
+        }
+
+        // the loop start restores the stored context instead of decoding up to it.
+        if (!decoder.Seek(LOOP_START) || !Compare(path, "loop start", DecodeAll(decoder, TOTAL - LOOP_START), expected, LOOP_START)) {
+            return false;
+        }
+
+        std::printf("%s: %u frames match\n", path, TOTAL);
+        return true;
+    }
+
+    bool Bench(const char *path) {
+        auto file = Load(path);
+        nw_stream::Decoder decoder;
+        if (!decoder.Open(ReadAt, &file, file.size())) {
+            std::fprintf(stderr, "%s: can't open\n", path);
+            return false;
+        }
+
+        std::vector<s16> out(1024 * decoder.GetChannelCount());
+        u64 frames = 0;
+        const auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed{};
+        while (elapsed.count() < 1.0) {
+            decoder.Seek(0);
+            while (const auto got = decoder.Decode(out.data(), 1024)) {
+                frames += got;
+            }
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+
+        std::printf("%-24s %u ch dsp-adpcm  %6.2f Mfps\n", path, decoder.GetChannelCount(), frames / elapsed.count() / 1e6);
+        return true;
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    const bool bench = argc > 1 && !std::strcmp(argv[1], "--bench");
+    if (argc < 3 + bench) {
+        std::fprintf(stderr, "usage: %s [--bench] reference.s16 file.bfstm|file.brstm...\n", argv[0]);
+        return 1;
+    }
+
+    const auto raw = Load(argv[1 + bench]);
+    std::vector<s16> expected(raw.size() / sizeof(s16));
+    std::memcpy(expected.data(), raw.data(), expected.size() * sizeof(s16));
+    if (!bench && expected.size() != TOTAL * 2) {
+        std::fprintf(stderr, "%s: expected %u frames\n", argv[1], TOTAL);
+        return 1;
+    }
+
+    bool ok = true;
+    for (int i = 2 + bench; i < argc; i++) {
+        ok &= bench ? Bench(argv[i]) : Check(argv[i], expected);
+    }
+    return ok ? 0 : 1;
+}
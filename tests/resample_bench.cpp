@@ -0,0 +1,135 @@
+// cost and THD+N of each resampler tier, through the whole stream the way the sysmodule uses
+// it. s16 is an s16 stream, the fixed point path. f32 is a float stream followed by the
+// conversion to s16, the path every other stream takes. the Makefile also builds it with
+// RESAMPLER_PHASES_MAX=0, which turns off the phase tables and times the generic resampler.
+#include "SDL_audioEX.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+    constexpr int OUTPUT_RATE = 48000;
+    // a 997 Hz sine at -1 dBFS, the usual THD+N test tone.
+    constexpr double TONE = 997;
+    constexpr double LEVEL = 0.891;
+    // the sysmodule's block, and enough of them to run for a while.
+    constexpr int BLOCK_FRAMES = 4096;
+    constexpr int BLOCKS = 64;
+    constexpr int RUNS = 20;
+
+    const char *const TIER_NAMES[] = {"linear", "cubic", "sinc_short", "sinc"};
+
+    // fits a*sin + b*cos at the tone, the rest is distortion and noise, in dB below the tone.
+    double ThdN(const std::vector<int16_t> &out) {
+        const size_t frames = out.size() / 2;
+        // skips the filter's run in and the flushed tail.
+        const size_t first = 2000, last = frames - 2000;
+        double ss = 0, cc = 0, sc = 0, xs = 0, xc = 0;
+        for (size_t i = first; i < last; i++) {
+            const double w = 2 * M_PI * TONE * i / OUTPUT_RATE;
+            const double s = std::sin(w), c = std::cos(w), x = out[i * 2];
+            ss += s * s, cc += c * c, sc += s * c, xs += x * s, xc += x * c;
+        }
+
+        const double det = ss * cc - sc * sc;
+        const double a = (xs * cc - xc * sc) / det, b = (xc * ss - xs * sc) / det;
+        double error = 0, power = 0;
+        for (size_t i = first; i < last; i++) {
+            const double w = 2 * M_PI * TONE * i / OUTPUT_RATE;
+            const double fit = a * std::sin(w) + b * std::cos(w);
+            error += (out[i * 2] - fit) * (out[i * 2] - fit);
+            power += fit * fit;
+        }
+        return 10 * std::log10(error / power);
+    }
+
+    // stereo in, s16 out. collects the output when out is set.
+    template<typename T>
+    size_t Drain(SDL_AudioStream *stream, std::vector<T> &block, std::vector<int16_t> &converted, std::vector<int16_t> *out) {
+        size_t frames = 0;
+        for (int got; (got = SDL_AudioStreamGetEX(stream, block.data(), block.size() * sizeof(T))) > 0;) {
+            const int samples = got / sizeof(T);
+            const int16_t *s16 = reinterpret_cast<const int16_t *>(block.data());
+            if constexpr (std::is_same_v<T, float>) {
+                SDL_ConvertF32ToS16EX(block.data(), converted.data(), samples, nullptr);
+                s16 = converted.data();
+            }
+            frames += samples / 2;
+            if (out) {
+                out->insert(out->end(), s16, s16 + samples);
+            }
+        }
+        return frames;
+    }
+
+    // ns per output frame, best of RUNS, put a block at a time like the sysmodule does.
+    // the output for THD+N is made from a single put, every put rounds the output frame
+    // count down and over many blocks that drifts the phase enough to throw off the fit.
+    template<typename T>
+    double Run(SDL_AudioFormat format, int rate, SDL_ResamplerQualityEX quality, const std::vector<T> &in, std::vector<int16_t> *out) {
+        std::vector<T> block(BLOCK_FRAMES * 4);
+        std::vector<int16_t> converted(block.size());
+
+        const auto stream = SDL_NewAudioStreamEX(format, 2, rate, format, 2, OUTPUT_RATE, quality);
+        if (!stream) {
+            return 0;
+        }
+        SDL_AudioStreamPutEX(stream, in.data(), in.size() * sizeof(T));
+        Drain(stream, block, converted, out);
+        SDL_FreeAudioStreamEX(stream);
+
+        double best = 1e9;
+        for (int run = 0; run < RUNS; run++) {
+            const auto stream = SDL_NewAudioStreamEX(format, 2, rate, format, 2, OUTPUT_RATE, quality);
+            size_t frames = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (int b = 0; b < BLOCKS; b++) {
+                SDL_AudioStreamPutEX(stream, in.data() + b * BLOCK_FRAMES * 2, BLOCK_FRAMES * 2 * sizeof(T));
+                frames += Drain<T>(stream, block, converted, nullptr);
+            }
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count() / frames);
+            SDL_FreeAudioStreamEX(stream);
+        }
+        return best;
+    }
+
+}
+
+int main() {
+#if defined(RESAMPLER_PHASES_MAX) && RESAMPLER_PHASES_MAX == 0
+    std::printf("generic resampler, no phase tables\n");
+#else
+    std::printf("phase tables\n");
+#endif
+    std::printf("%-6s %-10s %14s %10s %14s %10s\n", "rate", "tier", "s16 ns/frame", "thd+n", "f32 ns/frame", "thd+n");
+
+    for (const int rate : {44100, 32000, 22050, 96000}) {
+        std::vector<int16_t> in(BLOCK_FRAMES * BLOCKS * 2);
+        for (size_t i = 0; i < in.size() / 2; i++) {
+            const double w = 2 * M_PI * TONE * i / rate;
+            in[i * 2]     = int16_t(std::lrint(LEVEL * 32767 * std::sin(w)));
+            in[i * 2 + 1] = int16_t(std::lrint(LEVEL * 32767 * std::sin(w + 1)));
+        }
+        std::vector<float> in_f32(in.size());
+        std::transform(in.begin(), in.end(), in_f32.begin(), [](int16_t v) { return v / 32768.0f; });
+
+        for (const auto quality : {SDL_RESAMPLER_LINEAR, SDL_RESAMPLER_CUBIC, SDL_RESAMPLER_SINC_SHORT, SDL_RESAMPLER_SINC}) {
+            std::vector<int16_t> out_s16, out_f32;
+            const auto s16_ns = Run(AUDIO_S16SYS, rate, quality, in, &out_s16);
+            const auto f32_ns = Run(AUDIO_F32SYS, rate, quality, in_f32, &out_f32);
+            if (!s16_ns || !f32_ns) {
+                std::fprintf(stderr, "%d Hz %s: can't create the stream\n", rate, TIER_NAMES[quality]);
+                return 1;
+            }
+            std::printf("%-6d %-10s %14.2f %7.1f dB %14.2f %7.1f dB\n", rate, TIER_NAMES[quality], s16_ns, ThdN(out_s16), f32_ns, ThdN(out_f32));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+// runs the same s16 signal through an s16 stream, which resamples in Q14 fixed point below the
+// full sinc, and through a float stream with the same filter. the fixed point taps are rounded, so the outputs
+// may differ by a few lsb but never by more than TOLERANCE, and the frame counts have to match.
+#include "SDL_audioEX.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+    // each tap is off by up to half a Q14 step, the 8 tap short sinc gets to 5 lsb near full scale.
+    constexpr int TOLERANCE = 6;
+    constexpr int OUTPUT_RATE = 48000;
+    constexpr int SECONDS = 2;
+
+    const char *const TIER_NAMES[] = {"linear", "cubic", "sinc_short", "sinc"};
+
+    // two tones, noise and a stretch at full scale to hit the saturation.
+    std::vector<int16_t> MakeSignal(int rate, int channels) {
+        std::vector<int16_t> out(size_t(rate) * SECONDS * channels);
+        uint32_t seed = 1;
+        for (size_t i = 0; i < out.size() / channels; i++) {
+            const double t = double(i) / rate;
+            const bool loud = i % rate > size_t(rate) * 3 / 4;
+            for (int c = 0; c < channels; c++) {
+                seed = seed * 1103515245 + 12345;
+                const double noise = int(seed >> 16 & 0x7FF) - 1024;
+                const double tone = std::sin(2 * M_PI * (440 + 1000 * c) * t) * 14000 + std::sin(2 * M_PI * 5000 * t) * 6000;
+                out[i * channels + c] = int16_t(std::clamp(loud ? tone * 2.5 + noise : tone + noise, -32768.0, 32767.0));
+            }
+        }
+        return out;
+    }
+
+    // puts in uneven blocks, so carry over between puts is covered, then flushes.
+    template<typename T>
+    std::vector<T> Resample(SDL_AudioFormat format, int channels, int rate, SDL_ResamplerQualityEX quality, const std::vector<T> &in) {
+        const auto stream = SDL_NewAudioStreamEX(format, channels, rate, format, channels, OUTPUT_RATE, quality);
+        std::vector<T> out;
+        if (!stream) {
+            return out;
+        }
+
+        std::vector<T> block(4096 * channels);
+        const auto drain = [&] {
+            for (int got; (got = SDL_AudioStreamGetEX(stream, block.data(), block.size() * sizeof(T))) > 0;) {
+                out.insert(out.end(), block.begin(), block.begin() + got / sizeof(T));
+            }
+        };
+
+        const size_t frames = in.size() / channels;
+        for (size_t done = 0, step = 1; done < frames; done += step, step = step * 7 % 1999 + 1) {
+            step = std::min(step, frames - done);
+            SDL_AudioStreamPutEX(stream, in.data() + done * channels, step * channels * sizeof(T));
+            drain();
+        }
+        SDL_AudioStreamFlushEX(stream);
+        drain();
+
+        SDL_FreeAudioStreamEX(stream);
+        return out;
+    }
+
+    bool Check(int rate, int channels, SDL_ResamplerQualityEX quality) {
+        const auto signal = MakeSignal(rate, channels);
+        std::vector<float> signal_f32(signal.size());
+        std::transform(signal.begin(), signal.end(), signal_f32.begin(), [](int16_t v) { return v / 32768.0f; });
+
+        const auto fixed = Resample(AUDIO_S16SYS, channels, rate, quality, signal);
+        const auto reference = Resample(AUDIO_F32SYS, channels, rate, quality, signal_f32);
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "%d Hz %dch %s", rate, channels, TIER_NAMES[quality]);
+        if (fixed.empty() || fixed.size() != reference.size()) {
+            std::fprintf(stderr, "%s: %zu samples, expected %zu\n", name, fixed.size(), reference.size());
+            return false;
+        }
+
+        int max_diff = 0;
+        for (size_t i = 0; i < fixed.size(); i++) {
+            const auto expected = std::clamp(std::lround(reference[i] * 32768.0f), -32768l, 32767l);
+            const int diff = std::abs(int(fixed[i] - expected));
+            if (diff > TOLERANCE) {
+                std::fprintf(stderr, "%s: differs at sample %zu: %d, expected %ld\n", name, i, fixed[i], expected);
+                return false;
+            }
+            max_diff = std::max(max_diff, diff);
+        }
+
+        std::printf("%-24s %7zu frames match, within %d lsb\n", name, fixed.size() / channels, max_diff);
+        return true;
+    }
+
+}
+
+int main() {
+    bool ok = true;
+    // 44056 Hz has too many phases for a table and stays on the float path, it has to agree as well.
+    for (const int rate : {44100, 32000, 22050, 96000, 44056}) {
+        for (const int channels : {1, 2}) {
+            for (const auto quality : {SDL_RESAMPLER_LINEAR, SDL_RESAMPLER_CUBIC, SDL_RESAMPLER_SINC_SHORT, SDL_RESAMPLER_SINC}) {
+                ok &= Check(rate, channels, quality);
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+// decodes an ogg vorbis file through vorbis::Decoder and compares it with ffmpeg's float
+// decode of the same file, straight through and after seeks. both are float decoders that
+// sum in a different order, so samples may differ by rounding but never by more than TOLERANCE.
+// with --bench it reports the decode speed instead.
+#include "vorbis.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace vorbis = tune::impl::vorbis;
+
+namespace {
+
+    constexpr float TOLERANCE = 1.0f / 32768;
+    // the sysmodule's block size.
+    constexpr u64 BLOCK_FRAMES = 1024;
+
+    template<typename T>
+    std::vector<T> Load(const char *path) {
+        std::ifstream in(path, std::ios::binary);
+        const std::vector<char> bytes{std::istreambuf_iterator<char>(in), {}};
+        std::vector<T> out(bytes.size() / sizeof(T));
+        std::memcpy(out.data(), bytes.data(), out.size() * sizeof(T));
+        return out;
+    }
+
+    bool ReadAt(void *user, s64 offset, void *buffer, u64 size) {
+        const auto file = static_cast<const std::vector<u8> *>(user);
+        if (offset < 0 || u64(offset) + size > file->size()) {
+            return false;
+        }
+        std::memcpy(buffer, file->data() + offset, size);
+        return true;
+    }
+
+    const vorbis::AllocationCallbacks ALLOC = {
+        .pUserData = nullptr,
+        .onMalloc  = [](size_t size, void *) { return std::malloc(size); },
+        .onRealloc = [](void *p, size_t size, void *) { return std::realloc(p, size); },
+        .onFree    = [](void *p, void *) { std::free(p); },
+    };
+
+    void OnComment(void *user, const char *comment, size_t size) {
+        auto count = static_cast<u32 *>(user);
+        if (size == 13 && !std::memcmp(comment, "LOOPSTART=441", 13)) {
+            (*count)++;
+        }
+    }
+
+    // decodes in uneven steps so reads start and stop inside blocks.
+    template<typename T>
+    std::vector<T> DecodeAll(vorbis::Decoder &decoder, u64 frames) {
+        const auto channels = decoder.GetInfo().channels;
+        std::vector<T> out(frames * channels);
+        u64 done = 0;
+        for (u64 step = 1; done < frames; step = step * 3 % 1500 + 1) {
+            const auto got = decoder.Decode(out.data() + done * channels, std::min(step, frames - done));
+            if (!got) {
+                break;
+            }
+            done += got;
+        }
+        out.resize(done * channels);
+        return out;
+    }
+
+    template<typename T>
+    bool Compare(const char *path, const char *what, const std::vector<T> &got, const std::vector<float> &expected, u64 first, u32 channels) {
+        const auto begin = expected.begin() + first * channels;
+        const size_t count = std::min<size_t>(got.size(), expected.end() - begin);
+        if (got.size() != size_t(expected.end() - begin)) {
+            std::fprintf(stderr, "%s: %s decoded %zu samples, expected %zu\n", path, what, got.size(), size_t(expected.end() - begin));
+            return false;
+        }
+
+        // s16 output is rounded and clipped on top of the float difference.
+        const bool s16_out = std::is_same_v<T, s16>;
+        const float tolerance = s16_out ? 1.0f : TOLERANCE;
+        for (size_t i = 0; i < count; i++) {
+            const float want = s16_out ? std::clamp(std::round(begin[i] * 32768.0f), -32768.0f, 32767.0f) : begin[i];
+            if (std::fabs(got[i] - want) > tolerance) {
+                std::fprintf(stderr, "%s: %s differs at frame %zu: %f, expected %f\n", path, what, first + i / channels, float(got[i]), want);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Check(const char *path, const char *reference_path) {
+        auto file = Load<u8>(path);
+        const auto expected = Load<float>(reference_path);
+
+        u32 loop_tags = 0;
+        vorbis::Decoder decoder;
+        if (!decoder.Open(ReadAt, &file, file.size(), ALLOC, OnComment, &loop_tags)) {
+            std::fprintf(stderr, "%s: can't open\n", path);
+            return false;
+        }
+
+        const auto &info = decoder.GetInfo();
+        const auto channels = info.channels;
+        const auto frames = expected.size() / channels;
+        if (info.total_frames != frames || loop_tags != 1) {
+            std::fprintf(stderr, "%s: %llu frames and %u loop tags, expected %zu and 1\n", path, (unsigned long long)info.total_frames, loop_tags, frames);
+            return false;
+        }
+
+        if (!Compare(path, "full float decode", DecodeAll<float>(decoder, frames + 100), expected, 0, channels)) {
+            return false;
+        }
+        float tail[16];
+        if (decoder.Decode(tail, 8) || decoder.GetPosition() != frames) {
+            std::fprintf(stderr, "%s: decoded past the end\n", path);
+            return false;
+        }
+
+        // seeks backwards, into the first page, between pages and onto the last frame.
+        for (const u64 target : {frames / 2, u64(100), frames - 1, frames / 3 + 7, u64(0), frames * 9 / 10}) {
+            if (!decoder.Seek(target) || decoder.GetPosition() != target) {
+                std::fprintf(stderr, "%s: seek to %llu failed\n", path, (unsigned long long)target);
+                return false;
+            }
+            char what[64];
+            std::snprintf(what, sizeof(what), "decode after seeking to %llu", (unsigned long long)target);
+            if (!Compare(path, what, DecodeAll<float>(decoder, frames - target), expected, target, channels)) {
+                return false;
+            }
+        }
+
+        if (!decoder.Seek(0) || !Compare(path, "s16 decode", DecodeAll<s16>(decoder, frames), expected, 0, channels)) {
+            return false;
+        }
+
+        std::printf("%s: %zu frames match, %u bytes of decoder memory\n", path, frames, decoder.GetMemoryUsed());
+        return true;
+    }
+
+    bool Bench(const char *path) {
+        auto file = Load<u8>(path);
+        vorbis::Decoder decoder;
+        if (!decoder.Open(ReadAt, &file, file.size(), ALLOC)) {
+            std::fprintf(stderr, "%s: can't open\n", path);
+            return false;
+        }
+
+        const auto channels = decoder.GetInfo().channels;
+        std::vector<s16> block(BLOCK_FRAMES * channels);
+        double best = 0;
+        for (int run = 0; run < 3; run++) {
+            decoder.Seek(0);
+            u64 frames = 0;
+            const auto start = std::chrono::steady_clock::now();
+            for (u64 got; (got = decoder.Decode(block.data(), BLOCK_FRAMES)) != 0;) {
+                frames += got;
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::max(best, frames / elapsed.count());
+        }
+
+        std::printf("%-24s vorbis %6.2f Mfps\n", std::strrchr(path, '/') ? std::strrchr(path, '/') + 1 : path, best / 1e6);
+        return true;
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 3 && !std::strcmp(argv[1], "--bench")) {
+        bool ok = true;
+        for (int i = 2; i < argc; i++) {
+            ok &= Bench(argv[i]);
+        }
+        return ok ? 0 : 1;
+    }
+
+    if (argc < 3 || argc % 2 == 0) {
+        std::fprintf(stderr, "usage: %s file.ogg reference.f32... | --bench file.ogg...\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        ok &= Check(argv[i], argv[i + 1]);
+    }
+    return ok ? 0 : 1;
+}